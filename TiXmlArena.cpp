@@ -0,0 +1,141 @@
+/* 线程局部变量。TiXmlBase用它把“从内存池分配”传给构造函数和operator delete，统计用它记计数器 */
+#if defined( _MSC_VER )
+  #define TIXML_THREAD_LOCAL __declspec( thread )
+#elif defined( __GNUC__ )
+  #define TIXML_THREAD_LOCAL __thread
+#else
+  #define TIXML_THREAD_LOCAL
+#endif
+
+/* 类 */
+
+/* 文档级的内存池(arena)。TiXmlDocument开启后，该文档的所有节点和属性都从这里分配：
+ * 按块向系统申请内存，块内顺序切分，节点在内存中挨得很近；
+ * 单个节点delete时不归还内存，整个文档Clear或析构时所有块一次性释放
+ */
+class TiXmlArena
+{
+public:
+  TiXmlArena( size_t _blockSize = DEFAULT_BLOCK_SIZE )
+    : blocks( 0 ), cursor( 0 ), remaining( 0 ), blockSize( _blockSize ), bytesUsed( 0 ) {}
+  ~TiXmlArena() { Reset(); }
+
+  /* 分配size字节，按ALIGNMENT对齐。内存不足时返回0 */
+  void* Alloc( size_t size );
+
+  /* 释放所有块。调用前必须保证从这里分配的对象都已经析构 */
+  void Reset();
+
+  /* 接管other的所有块，other变成空的。other中分配的对象从此和这里的一起释放 */
+  void Adopt( TiXmlArena* other );
+
+  /* 已经切分出去的字节数 */
+  size_t BytesUsed() const { return bytesUsed; }
+
+  enum
+  {
+    DEFAULT_BLOCK_SIZE = 64 * 1024,
+    ALIGNMENT = 16
+  };
+
+private:
+  /* 不允许拷贝 */
+  TiXmlArena( const TiXmlArena& );
+  void operator=( const TiXmlArena& );
+
+  /* 每个块的头部，块与块之间用单链表串起来 */
+  struct Block
+  {
+    Block*  next;
+    size_t  size;
+  };
+
+  static size_t Align( size_t n ) { return ( n + ALIGNMENT - 1 ) & ~( (size_t)ALIGNMENT - 1 ); }
+
+  Block*  blocks;
+  char*   cursor;     /* 当前块中下一个可用的位置 */
+  size_t  remaining;  /* 当前块中剩余的字节数 */
+  size_t  blockSize;
+  size_t  bytesUsed;
+};
+
+/* 方法 */
+
+void* TiXmlArena::Alloc( size_t size )
+{
+  size = Align( size );
+  const size_t header = Align( sizeof( Block ) );
+
+  if ( size > remaining )
+  {
+    /* 超大的分配单独占一个块，挂在当前块后面，不浪费当前块剩余的空间 */
+    if ( blocks && size > blockSize / 4 )
+    {
+      Block* big = (Block*) malloc( header + size );
+      if ( !big )
+        return 0;
+      big->size = header + size;
+      big->next = blocks->next;
+      blocks->next = big;
+      bytesUsed += size;
+      return (char*)big + header;
+    }
+
+    size_t total = header + ( size > blockSize ? size : blockSize );
+    Block* block = (Block*) malloc( total );
+    if ( !block )
+      return 0;
+    block->size = total;
+    block->next = blocks;
+    blocks = block;
+    cursor = (char*)block + header;
+    remaining = total - header;
+  }
+
+  void* p = cursor;
+  cursor += size;
+  remaining -= size;
+  bytesUsed += size;
+  return p;
+}
+
+void TiXmlArena::Reset()
+{
+  while ( blocks )
+  {
+    Block* next = blocks->next;
+    free( blocks );
+    blocks = next;
+  }
+  cursor = 0;
+  remaining = 0;
+  bytesUsed = 0;
+}
+
+void TiXmlArena::Adopt( TiXmlArena* other )
+{
+  if ( !other->blocks )
+    return;
+
+  if ( !blocks )
+  {
+    blocks = other->blocks;
+    cursor = other->cursor;
+    remaining = other->remaining;
+  }
+  else
+  {
+    /* 接在当前块后面，当前块剩下的空间继续使用 */
+    Block* tail = other->blocks;
+    while ( tail->next )
+      tail = tail->next;
+    tail->next = blocks->next;
+    blocks->next = other->blocks;
+  }
+  bytesUsed += other->bytesUsed;
+
+  other->blocks = 0;
+  other->cursor = 0;
+  other->remaining = 0;
+  other->bytesUsed = 0;
+}
@@ -2,6 +2,11 @@
 class TiXmlAttribute : public TiXmlBase
 {
   friend class TiXmlAttributeSet;
+  friend class TiXmlElement;
+  friend class TiXmlDocument;
+  friend class TiXmlWriter;
+  friend class TiXmlParallelParser;
+  friend class TiXmlSnapshot;
 
 public:
   /* 构造函数 */
@@ -17,16 +22,58 @@ public:
     document = 0;
     prev = next = 0;
   }
+#ifdef TIXML_HAS_MOVE
+  /* 接管other的名字和值。新属性不在任何元素中，也不再指向原来的文档，
+   * 引用文档缓冲区或名字表的名字和值会拷贝成自己的。other还在原来的位置，只是名字和值变空了
+   */
+  TiXmlAttribute( TiXmlAttribute&& other )
+    : TiXmlBase(), document( 0 ), name( std::move( other.name ) ), value( std::move( other.value ) )
+  {
+    name.Own();
+    value.Own();
+    prev = next = 0;
+    if ( other.next )
+      TiXmlAttributeSet::Renamed( &other );
+  }
+  TiXmlAttribute& operator=( TiXmlAttribute&& other );
+#endif
   
   /* 获取value */
   const char* Name() const   { return name.c_str(); }
   const char* Value() const  { return value.c_str(); }
+  /* 就地解析过程中名字还没有补'\0'，这时应该按长度使用它 */
+  const TiXmlStringRef& NameRef() const { return name; }
+
+  /* 修改名字和值。引用文档缓冲区的名字和值在这时才会拷贝成自己的字符串 */
+  void SetName( const char* _name );
+  void SetValue( const char* _value ) { value = _value; }
+#if defined( TIXML_HAS_MOVE ) && defined( TIXML_USE_STL )
+  /* 直接接管传入的字符串，不再拷贝 */
+  void SetName( std::string&& _name );
+  void SetValue( std::string&& _value ) { value = std::move( _value ); }
+#endif
   int IntValue() const;          /* 如果value为int类型，可以进行转换 */
   double DoubleValue() const;    /* 如果value为double类型，可以进行转换 */
 
-  /* 更安全的获取value的方法。成功返回TIXML_SUCCESS，失败返回TIXML_WRONG_TYPE */
-  int QueryIntValue( int* _value ) const;
-  int QueryDoubleValue( double* _value ) const;
+  /* 更安全的获取value的方法。成功返回TIXML_SUCCESS，失败返回TIXML_WRONG_TYPE。
+   * 转换由TiXmlConvert完成，不分配内存，不受locale影响。mode的含义见TiXmlConvert：
+   * 原有的两个函数默认LENIENT，和以前的sscanf()行为一致；新增的函数默认STRICT
+   */
+  int QueryIntValue( int* _value, TiXmlConvert::Mode mode = TiXmlConvert::LENIENT ) const;
+  int QueryDoubleValue( double* _value, TiXmlConvert::Mode mode = TiXmlConvert::LENIENT ) const;
+  int QueryInt64Value( long long* _value, TiXmlConvert::Mode mode = TiXmlConvert::STRICT ) const;
+  int QueryUint64Value( unsigned long long* _value, TiXmlConvert::Mode mode = TiXmlConvert::STRICT ) const;
+  int QueryFloatValue( float* _value, TiXmlConvert::Mode mode = TiXmlConvert::STRICT ) const;
+  int QueryBoolValue( bool* _value, TiXmlConvert::Mode mode = TiXmlConvert::STRICT ) const;
+  /* 值是tokens[0..count)中的哪一个，例如 { "left", "center", "right" } */
+  int QueryEnumValue( int* _value, const char* const* tokens, int count, TiXmlConvert::Mode mode = TiXmlConvert::STRICT ) const;
+
+  /* 按类型设置value，不经过sprintf() */
+  void SetIntValue( int _value )                    { SetInt64Value( _value ); }
+  void SetInt64Value( long long _value );
+  void SetUint64Value( unsigned long long _value );
+  void SetDoubleValue( double _value );
+  void SetBoolValue( bool _value )                  { value = _value ? "true" : "false"; }
   
   /* 从DOM中获取下一下相邻的属性 */
   const TiXmlAttribute* Next() const;
@@ -48,24 +95,72 @@ public:
     Print( cfile, depth, 0 );
   }
   void Print( FILE* cfile, int depth, TIXML_STRING* str ) const;
-  
+
+  /* [internal use] 设置所属的文档，解析出错时通过它报告错误 */
+  void SetDocument( TiXmlDocument* doc ) { document = doc; }
+
 private:
   /* 不需要具体实现的函数*/
   TiXmlAttribute( const TiXmlAttribute& );
   void operator=( const TiXmlAttribute& base );
 
+  /* 只有属性集合的哨兵返回它所在的集合，普通属性返回0 */
+  virtual TiXmlAttributeSet* OwnerSet() const { return 0; }
+  virtual const TiXmlDocument* LocationDocument() const { return document; }
+  /* 值的长度超过了资源限制：设置对应的错误，返回0 */
+  const char* LimitError( size_t length, const char* p, TiXmlParsingData* data, TiXmlEncoding encoding );
+
   /* 指向document的指针，为了方便返回错误信息 */
   TiXmlDocument*  document;
   
-  /* 数据成员 */
-  TIXML_STRING name;
-  TIXML_STRING value;
+  /* 数据成员。就地解析时只引用文档的缓冲区 */
+  TiXmlStringRef name;
+  TiXmlStringRef value;
   TiXmlAttribute* prev;
   TiXmlAttribute* next;
 };
 
 /* 方法 */
 
+void TiXmlAttribute::SetName( const char* _name )
+{
+  name = _name;
+  /* 已经加入了某个元素时，那个元素的属性索引要跟着更新 */
+  if ( next )
+    TiXmlAttributeSet::Renamed( this );
+}
+
+#ifdef TIXML_HAS_MOVE
+/* 只移动名字和值，两个属性各自留在原来的元素中。不在同一个文档时名字和值拷贝成自己的 */
+TiXmlAttribute& TiXmlAttribute::operator=( TiXmlAttribute&& other )
+{
+  if ( this != &other )
+  {
+    name = std::move( other.name );
+    value = std::move( other.value );
+    if ( !document || document != other.document )
+    {
+      name.Own();
+      value.Own();
+    }
+    if ( next )
+      TiXmlAttributeSet::Renamed( this );
+    if ( other.next )
+      TiXmlAttributeSet::Renamed( &other );
+  }
+  return *this;
+}
+#endif
+
+#if defined( TIXML_HAS_MOVE ) && defined( TIXML_USE_STL )
+void TiXmlAttribute::SetName( std::string&& _name )
+{
+  name = std::move( _name );
+  if ( next )
+    TiXmlAttributeSet::Renamed( this );
+}
+#endif
+
 /* 将类似于 name=test的内容以key-value的形式解析出来 */
 const char* TiXmlAttribute::Parse( const char* p, TiXmlParsingData* data, TiXmlEncoding encoding )
 {
@@ -74,12 +169,15 @@ const char* TiXmlAttribute::Parse( const char* p, TiXmlParsingData* data, TiXmlE
 
   if ( data )
   {
-    data->Stamp( p, encoding );
-    location = data->Cursor();
+    location = data->Offset( p );
+    generation = data->Generation();
   }
+  /* 就地解析时，名字和值都只引用文档的缓冲区 */
+  const bool inSitu = document && document->IsParsingInSitu();
+
   // Read the name, the '=' and the value.
   const char* pErr = p; 
-  p = ReadName( p, &name, encoding );
+  p = ReadName( p, &name, inSitu, document ? document->NameTable() : 0, encoding );
   if ( !p || !*p )
   {
     if ( document ) document->SetError( TIXML_ERROR_READING_ATTRIBUTES, pErr, data, encoding );
@@ -99,6 +197,9 @@ const char* TiXmlAttribute::Parse( const char* p, TiXmlParsingData* data, TiXmlE
     return 0;
   }
 
+  /* 资源限制下值最多读入多长，超过时不再往下读，错误在LimitError()中设置 */
+  const size_t budget = ( data && data->Limited() ) ? data->StringBudget( !inSitu ) : (size_t)-1;
+
   const char* end;
   const char SINGLE_QUOTE = '\'';
   const char DOUBLE_QUOTE = '\"';
@@ -107,17 +208,24 @@ const char* TiXmlAttribute::Parse( const char* p, TiXmlParsingData* data, TiXmlE
   {
     ++p;
     end = "\'";   // single quote in string
-    p = ReadText( p, &value, false, end, false, encoding );
+    p = inSitu ? ReadTextInSitu( p, &value, false, end, false, encoding, budget )
+               : ReadText( p, value.Mutable(), false, end, false, encoding, budget );
+    if ( !p && value.length() > budget )
+      return LimitError( value.length(), pErr, data, encoding );
   }
   else if ( *p == DOUBLE_QUOTE )
   {
     ++p;
     end = "\"";   // double quote in string
-    p = ReadText( p, &value, false, end, false, encoding );
+    p = inSitu ? ReadTextInSitu( p, &value, false, end, false, encoding, budget )
+               : ReadText( p, value.Mutable(), false, end, false, encoding, budget );
+    if ( !p && value.length() > budget )
+      return LimitError( value.length(), pErr, data, encoding );
   }
     else
   {
-    value = "";
+    /* 没有引号的值不解码实体引用，先找到结尾，再一次性取出来 */
+    const char* start = p;
     while (p && *p && !IsWhiteSpace(*p ) && *p != '/' && *p != '>' )
     {
       if ( *p == SINGLE_QUOTE || *p == DOUBLE_QUOTE )
@@ -125,54 +233,121 @@ const char* TiXmlAttribute::Parse( const char* p, TiXmlParsingData* data, TiXmlE
         if ( document ) document->SetError( TIXML_ERROR_READING_ATTRIBUTES, p, data, encoding );
         return 0;
       }
-      value += *p;
       ++p;
     }
+    if ( (size_t)( p - start ) > budget )
+      return LimitError( p - start, pErr, data, encoding );
+    if ( inSitu )
+      value.Refer( start, p - start );
+    else
+      value.Mutable()->assign( start, p - start );
   }
   return p;
 }
 
-/* 更安全的一种方法(未必) */
-int TiXmlAttribute::QueryIntValue( int* ival ) const
+const char* TiXmlAttribute::LimitError( size_t length, const char* p, TiXmlParsingData* data, TiXmlEncoding encoding )
+{
+  int err = data->AddString( length, length + 1 );
+  if ( document && err != TIXML_NO_ERROR )
+    document->SetError( err, p, data, encoding );
+  return 0;
+}
+
+/* 按长度转换，就地解析中还没补'\0'的值也可以用 */
+int TiXmlAttribute::QueryIntValue( int* ival, TiXmlConvert::Mode mode ) const
+{
+  return TiXmlConvert::ToInt( value.c_str(), value.length(), ival, mode );
+}
+int TiXmlAttribute::QueryDoubleValue( double* dval, TiXmlConvert::Mode mode ) const
+{
+  return TiXmlConvert::ToDouble( value.c_str(), value.length(), dval, mode );
+}
+int TiXmlAttribute::QueryInt64Value( long long* ival, TiXmlConvert::Mode mode ) const
+{
+  return TiXmlConvert::ToInt64( value.c_str(), value.length(), ival, mode );
+}
+int TiXmlAttribute::QueryUint64Value( unsigned long long* uval, TiXmlConvert::Mode mode ) const
+{
+  return TiXmlConvert::ToUint64( value.c_str(), value.length(), uval, mode );
+}
+int TiXmlAttribute::QueryFloatValue( float* fval, TiXmlConvert::Mode mode ) const
+{
+  return TiXmlConvert::ToFloat( value.c_str(), value.length(), fval, mode );
+}
+int TiXmlAttribute::QueryBoolValue( bool* bval, TiXmlConvert::Mode mode ) const
+{
+  return TiXmlConvert::ToBool( value.c_str(), value.length(), bval, mode );
+}
+int TiXmlAttribute::QueryEnumValue( int* ival, const char* const* tokens, int count, TiXmlConvert::Mode mode ) const
+{
+  return TiXmlConvert::ToEnum( value.c_str(), value.length(), tokens, count, ival, mode );
+}
+
+/* 转换失败时返回0，和以前一样 */
+int TiXmlAttribute::IntValue() const
+{
+  int i = 0;
+  QueryIntValue( &i );
+  return i;
+}
+double TiXmlAttribute::DoubleValue() const
+{
+  double d = 0.0;
+  QueryDoubleValue( &d );
+  return d;
+}
+
+void TiXmlAttribute::SetInt64Value( long long _value )
 {
-  if ( TIXML_SSCANF( value.c_str(), "%d", ival ) == 1 )
-    return TIXML_SUCCESS;
-  return TIXML_WRONG_TYPE;
+  char buf[ TiXmlConvert::BUFFER_SIZE ];
+  size_t len = TiXmlConvert::FromInt64( _value, buf );
+  value.Assign( buf, len );
 }
-int TiXmlAttribute::QueryDoubleValue( double* dval ) const
+void TiXmlAttribute::SetUint64Value( unsigned long long _value )
 {
-  if ( TIXML_SSCANF( value.c_str(), "%lf", dval ) == 1 )
-    return TIXML_SUCCESS;
-  return TIXML_WRONG_TYPE;
+  char buf[ TiXmlConvert::BUFFER_SIZE ];
+  size_t len = TiXmlConvert::FromUint64( _value, buf );
+  value.Assign( buf, len );
+}
+void TiXmlAttribute::SetDoubleValue( double _value )
+{
+  char buf[ TiXmlConvert::BUFFER_SIZE ];
+  size_t len = TiXmlConvert::FromDouble( _value, buf );
+  value.Assign( buf, len );
 }
 
-/* Print()函数的实现 */
+/* Print()函数的实现。名字和值不需要转义时直接输出，不生成临时字符串 */
 void TiXmlAttribute::Print( FILE* cfile, int /*depth*/, TIXML_STRING* str ) const
 {
   TIXML_STRING n, v;
+  const char* nStr = name.c_str();
+  size_t nLen = name.length();
+  const char* vStr = value.c_str();
+  size_t vLen = value.length();
+
+  if ( NeedsEncoding( nStr, nLen ) )
+  {
+    EncodeString( nStr, nLen, &n );
+    nStr = n.c_str();
+    nLen = n.length();
+  }
+  if ( NeedsEncoding( vStr, vLen ) )
+  {
+    EncodeString( vStr, vLen, &v );
+    vStr = v.c_str();
+    vLen = v.length();
+  }
 
-  EncodeString( name, &n );
-  EncodeString( value, &v );
+  /* 值里没有双引号时用双引号括起来，否则用单引号 */
+  const char quote = memchr( value.c_str(), '\"', value.length() ) ? '\'' : '\"';
 
-  if (value.find ('\"') == TIXML_STRING::npos) /* TIXML_STRING::npos 表示“未找到”，值为static const unsigned -1 */
+  if ( cfile ) 
   {
-    if ( cfile ) 
-    {
-      fprintf (cfile, "%s=\"%s\"", n.c_str(), v.c_str() );
-    }
-    if ( str ) 
-    {
-      (*str) += n; (*str) += "=\""; (*str) += v; (*str) += "\"";
-    }
+    fprintf (cfile, "%s=%c%s%c", nStr, quote, vStr, quote );
   }
-  else {
-    if ( cfile ) 
-    {
-      fprintf (cfile, "%s='%s'", n.c_str(), v.c_str() );
-    }
-    if ( str ) 
-    {
-      (*str) += n; (*str) += "='"; (*str) += v; (*str) += "'";
-    }
+  if ( str ) 
+  {
+    str->reserve( str->length() + nLen + vLen + 3 );
+    str->append( nStr, nLen ); (*str) += '='; (*str) += quote; str->append( vStr, vLen ); (*str) += quote;
   }
 }
@@ -0,0 +1,256 @@
+/* 类 */
+
+/* 元素的属性集合。这是一个带哨兵(sentinel)的双向循环链表，哨兵的name和value都是空的，
+ * TiXmlAttribute::Next()/Previous()遇到哨兵时返回0。
+ * 属性超过INDEX_THRESHOLD个时，另外建立一个按名字散列的索引，Find()不再逐个比较；
+ * 链表本身不变，Next()/Previous()的顺序还是属性出现的顺序
+ */
+class TiXmlAttributeSet
+{
+  friend class TiXmlAttribute;
+public:
+  TiXmlAttributeSet();
+  ~TiXmlAttributeSet();
+
+  void Add( TiXmlAttribute* attribute );
+  void Remove( TiXmlAttribute* attribute );
+
+  const TiXmlAttribute* First() const { return ( sentinel.next == &sentinel ) ? 0 : sentinel.next; }
+  TiXmlAttribute* First()             { return ( sentinel.next == &sentinel ) ? 0 : sentinel.next; }
+  const TiXmlAttribute* Last() const  { return ( sentinel.prev == &sentinel ) ? 0 : sentinel.prev; }
+  TiXmlAttribute* Last()              { return ( sentinel.prev == &sentinel ) ? 0 : sentinel.prev; }
+
+  /* 根据名字查找属性，找不到返回0 */
+  TiXmlAttribute* Find( const char* _name ) const;
+  /* 同上。名字可以是还没有补'\0'的引用(就地解析过程中) */
+  TiXmlAttribute* Find( const TiXmlStringRef& _name ) const;
+  TiXmlAttribute* FindOrCreate( const char* _name );
+
+  /* 属性的个数 */
+  size_t Count() const { return count; }
+
+  enum
+  {
+    INDEX_THRESHOLD = 16    /* 属性多于这个数时建立索引 */
+  };
+
+private:
+  /* 不允许拷贝 */
+  TiXmlAttributeSet( const TiXmlAttributeSet& );
+  void operator=( const TiXmlAttributeSet& );
+
+  /* 链表的哨兵，它知道自己属于哪个集合。属性改名时沿链表找到哨兵，再由它找到集合更新索引 */
+  class Sentinel : public TiXmlAttribute
+  {
+  public:
+    Sentinel( TiXmlAttributeSet* _set ) : set( _set ) {}
+  private:
+    virtual TiXmlAttributeSet* OwnerSet() const { return set; }
+    TiXmlAttributeSet* set;
+  };
+
+  /* 索引中的一项。attribute为0表示空位，为&sentinel表示已删除 */
+  struct Entry
+  {
+    TiXmlAttribute* attribute;
+    size_t          hash;
+  };
+
+  TiXmlAttribute* Find( const char* _name, size_t length ) const;
+
+  /* 按当前的链表重建索引，容量至少是属性个数的两倍 */
+  void BuildIndex();
+  void IndexInsert( TiXmlAttribute* attribute );
+  bool IndexErase( TiXmlAttribute* attribute );
+
+  /* TiXmlAttribute::SetName()改了已经在集合中的属性的名字 */
+  static void Renamed( TiXmlAttribute* attribute );
+
+  Sentinel  sentinel;
+  size_t    count;
+
+  Entry*    index;          /* 开放定址，容量是2的幂。属性不多时为0 */
+  size_t    indexCapacity;
+  size_t    indexDeleted;   /* 索引中已删除的项，太多时重建 */
+};
+
+/* 方法 */
+
+TiXmlAttributeSet::TiXmlAttributeSet()
+  : sentinel( this ), count( 0 ), index( 0 ), indexCapacity( 0 ), indexDeleted( 0 )
+{
+  sentinel.next = &sentinel;
+  sentinel.prev = &sentinel;
+}
+
+TiXmlAttributeSet::~TiXmlAttributeSet()
+{
+  assert( sentinel.next == &sentinel );
+  assert( sentinel.prev == &sentinel );
+  delete [] index;
+}
+
+/* 加到链表末尾 */
+void TiXmlAttributeSet::Add( TiXmlAttribute* addMe )
+{
+  assert( !Find( addMe->name ) );  /* 同一个属性不能加两次 */
+
+  addMe->next = &sentinel;
+  addMe->prev = sentinel.prev;
+
+  sentinel.prev->next = addMe;
+  sentinel.prev       = addMe;
+  ++count;
+
+  if ( index )
+    IndexInsert( addMe );
+  else if ( count > INDEX_THRESHOLD )
+    BuildIndex();
+}
+
+void TiXmlAttributeSet::Remove( TiXmlAttribute* removeMe )
+{
+  /* 有索引时先通过索引确认属性在集合中，不用遍历链表 */
+  const bool indexed = index && IndexErase( removeMe );
+  if ( !indexed )
+  {
+    /* 没有索引，或者索引里没找到(名字被绕过SetName()改掉了，散列值对不上)，沿链表确认 */
+    TiXmlAttribute* node;
+    for( node = sentinel.next; node != &sentinel && node != removeMe; node = node->next )
+    {
+    }
+    if ( node == &sentinel )
+    {
+      assert( 0 );  /* 要删除的属性不在链表中 */
+      return;
+    }
+  }
+
+  removeMe->prev->next = removeMe->next;
+  removeMe->next->prev = removeMe->prev;
+  removeMe->next = 0;
+  removeMe->prev = 0;
+  --count;
+
+  /* 索引和链表不一致，按链表重建，不留下指向已删除属性的项 */
+  if ( index && !indexed )
+    BuildIndex();
+}
+
+TiXmlAttribute* TiXmlAttributeSet::Find( const char* name ) const
+{
+  return Find( name, strlen( name ) );
+}
+
+/* 按长度比较，不依赖结尾的'\0' */
+TiXmlAttribute* TiXmlAttributeSet::Find( const TiXmlStringRef& name ) const
+{
+  return Find( name.c_str(), name.length() );
+}
+
+TiXmlAttribute* TiXmlAttributeSet::Find( const char* name, size_t length ) const
+{
+  if ( index )
+  {
+    size_t hash = TiXmlNameTable::Hash( name, length );
+    size_t mask = indexCapacity - 1;
+    for ( size_t i = hash & mask; index[i].attribute; i = ( i + 1 ) & mask )
+    {
+      TiXmlAttribute* node = index[i].attribute;
+      if ( node != &sentinel && index[i].hash == hash && node->name.Equals( name, length ) )
+        return node;
+    }
+    return 0;
+  }
+
+  for( TiXmlAttribute* node = sentinel.next; node != &sentinel; node = node->next )
+  {
+    if ( node->name.Equals( name, length ) )
+      return node;
+  }
+  return 0;
+}
+
+TiXmlAttribute* TiXmlAttributeSet::FindOrCreate( const char* _name )
+{
+  TiXmlAttribute* attrib = Find( _name );
+  if ( !attrib )
+  {
+    /* 先起名再加入，索引按名字散列 */
+    attrib = new TiXmlAttribute();
+    attrib->SetName( _name );
+    Add( attrib );
+  }
+  return attrib;
+}
+
+void TiXmlAttributeSet::BuildIndex()
+{
+  size_t capacity = 32;
+  while ( capacity < count * 2 )
+    capacity *= 2;
+
+  delete [] index;
+  index = new Entry[ capacity ];
+  memset( index, 0, capacity * sizeof( Entry ) );
+  indexCapacity = capacity;
+  indexDeleted = 0;
+
+  for( TiXmlAttribute* node = sentinel.next; node != &sentinel; node = node->next )
+  {
+    size_t hash = TiXmlNameTable::Hash( node->name.c_str(), node->name.length() );
+    size_t i = hash & ( capacity - 1 );
+    while ( index[i].attribute )
+      i = ( i + 1 ) & ( capacity - 1 );
+    index[i].attribute = node;
+    index[i].hash = hash;
+  }
+}
+
+/* attribute已经在链表中，count已经算上了它 */
+void TiXmlAttributeSet::IndexInsert( TiXmlAttribute* attribute )
+{
+  /* 装填因子(包括已删除的项)不超过1/2 */
+  if ( ( count + indexDeleted ) * 2 > indexCapacity )
+  {
+    BuildIndex();
+    return;
+  }
+
+  size_t hash = TiXmlNameTable::Hash( attribute->name.c_str(), attribute->name.length() );
+  size_t mask = indexCapacity - 1;
+  size_t i = hash & mask;
+  while ( index[i].attribute )
+    i = ( i + 1 ) & mask;
+  index[i].attribute = attribute;
+  index[i].hash = hash;
+}
+
+bool TiXmlAttributeSet::IndexErase( TiXmlAttribute* attribute )
+{
+  size_t hash = TiXmlNameTable::Hash( attribute->name.c_str(), attribute->name.length() );
+  size_t mask = indexCapacity - 1;
+  for ( size_t i = hash & mask; index[i].attribute; i = ( i + 1 ) & mask )
+  {
+    if ( index[i].attribute == attribute )
+    {
+      /* 留下删除标记，后面的项还要靠它探测下去 */
+      index[i].attribute = &sentinel;
+      ++indexDeleted;
+      return true;
+    }
+  }
+  return false;
+}
+
+void TiXmlAttributeSet::Renamed( TiXmlAttribute* attribute )
+{
+  TiXmlAttribute* node = attribute->next;
+  while ( !node->OwnerSet() )
+    node = node->next;
+
+  /* 旧名字的散列值已经算不出来了，整个重建。改名很少见 */
+  TiXmlAttributeSet* set = node->OwnerSet();
+  if ( set->index )
+    set->BuildIndex();
+}
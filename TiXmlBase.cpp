@@ -4,10 +4,23 @@ class TiXmlBase
   friend class TiXmlNode;
   friend class TiXmlElement;
   friend class TiXmlDocument;
+  friend class TiXmlReader;
+  friend class TiXmlWriter;
+  friend class TiXmlParallelParser;
 
 public:
-  TiXmlBase() : userData(0) {}
-  virtual ~TiXmlBase()      {}
+  /* 刚由operator new( size, arena )分配的就是this时，记下它来自内存池 */
+  TiXmlBase() : location( NO_LOCATION ), generation( 0 ), inArena( this == arenaAllocated ), userData(0)
+  {
+    if ( inArena )
+      arenaAllocated = 0;
+  }
+  /* 来自内存池的对象告诉紧接着的operator delete不要释放内存 */
+  virtual ~TiXmlBase()
+  {
+    if ( inArena )
+      arenaReleased = this;
+  }
   
   /* 打印节点信息。这是一个纯虚函数，继承TiXmlBase的每个子类都必须实现它
    * 含有纯虚拟函数的类称为抽象类，它不能生成对象。因此TiXmlBase调用自身的成员函数的时候需要直接使用类名：
@@ -15,23 +28,32 @@ public:
    */
   virtual void Print( FILE* cfile, int depth ) const = 0;
 
-  /* 当XML中的内容有多个空格时，是全部显示还是只显示一个？这个选项是由condenseWhiteSpace来控制的
-   * 默认是对多个空格进行合并。对condenseWhiteSpace的修改不是多线程安全的。
-   * 如：<school>沈  阳  工  业  大  学</school>实际显示为<school>沈 阳 工 业 大 学</school>
-   * 这两个函数是静态成员函数，因此condenseWhiteSpace一定是静态数据成员，它是由所有子类共享的
+  /* 节点在输入中的行、列，从1开始。解析时只记下字节偏移，调用时才由文档的行索引换算。
+   * 不是解析得到的、不在文档中、文档没有打开TrackLocation()，或者所在的文档已经重新解析过
+   * (节点移到了别的文档，或者行索引已经换成了另一次解析的)时返回0
    */
-  static void SetCondenseWhiteSpace( bool condense )  { condenseWhiteSpace = condense; }
-  static bool IsWhiteSpaceCondensed() { return condenseWhiteSpace; }
-
-  /* 通过游标类TiXmlCursor获得当前游标所在的行、列 */
-  int Row() const     { return location.row + 1; }
-  int Column() const  { return location.col + 1; }
+  int Row() const     { return Location().row + 1; }
+  int Column() const  { return Location().col + 1; }
+  TiXmlCursor Location() const;
   
   /* 获得指向用户数据的指针 */
   void  SetUserData( void* user )  { userData = user; }
   void* GetUserData()              { return userData; }
   const void* GetUserData() const  { return userData; }
 
+  /* 节点和属性的内存分配。arena为0时走普通的堆分配；不为0时从文档的内存池中分配，
+   * 这时delete只执行析构，内存由内存池统一回收。两种方式都可以直接用delete释放：
+   * TiXmlNode* node = new( document->Arena() ) TiXmlElement( "" );
+   * 对象前面没有额外的头，是否来自内存池记在InArena()中：operator new和构造函数之间、
+   * 析构函数和operator delete之间通过线程局部变量传递，中间不会插入别的分配和释放
+   */
+  static void* operator new( size_t size );
+  static void* operator new( size_t size, TiXmlArena* arena );
+  static void operator delete( void* p );
+  static void operator delete( void* p, TiXmlArena* arena );
+  /* [internal use] 是否来自文档的内存池 */
+  bool InArena() const { return inArena; }
+
   /* 存储与编码相关的信息 */
   static const int utf8ByteTable[256];
   
@@ -41,7 +63,21 @@ public:
   /* 这是用来对字符串编码的。如果字符串里有不可见字符，需进行特殊处理。有<、>等字符，转换成&lt;和&gt;等
    * 就是把特殊字符转化为实体引用
    */
-  static void EncodeString( const TIXML_STRING& str, TIXML_STRING* out );
+  static void EncodeString( const char* str, size_t length, TIXML_STRING* out );
+  /* EncodeString()中单个字符的转义。out指向替换后的内容，可能就是scratch(至少ENCODE_SCRATCH字节)；
+   * 返回下一个要处理的位置。TiXmlWriter直接用它写入自己的缓冲区
+   */
+  enum { ENCODE_SCRATCH = 8 };
+  static const char* EncodeSpecial( const char* p, const char* end, const char** out, size_t* outLength, char* scratch );
+  static void EncodeString( const TIXML_STRING& str, TIXML_STRING* out )
+  {
+    EncodeString( str.c_str(), str.length(), out );
+  }
+  /* 字符串中有没有需要转义的字符。没有时可以直接输出原字符串，省掉一次拷贝 */
+  static bool NeedsEncoding( const char* str, size_t length )
+  {
+    return TiXmlScanner::FindEscape( str, str + length ) != str + length;
+  }
   
   /* 这类似于#indef，从0开始定义错误码 */
   enum
@@ -62,6 +98,13 @@ public:
     TIXML_ERROR_EMBEDDED_NULL,
     TIXML_ERROR_PARSING_CDATA,
     TIXML_ERROR_DOCUMENT_TOP_ONLY,
+    TIXML_ERROR_BINARY_FORMAT,
+    /* 超过了TiXmlParseOptions中的资源限制 */
+    TIXML_ERROR_MEMORY_LIMIT,
+    TIXML_ERROR_NODE_LIMIT,
+    TIXML_ERROR_DEPTH_LIMIT,
+    TIXML_ERROR_ATTRIBUTE_LIMIT,
+    TIXML_ERROR_STRING_LIMIT,
     
     TIXML_ERROR_STRING_COUNT
   };
@@ -69,9 +112,13 @@ public:
 protected:
   /* 跳过空格 */
   static const char* SkipWhiteSpace( const char*, TiXmlEncoding encoding );
+  /* 编码在编译时确定的版本，UTF8为true时还会跳过BOM */
+  template< bool UTF8 >
+  static const char* SkipWhiteSpaceT( const char* p );
+  /* 和TiXmlScanner一样，按C locale下的isspace()判断，不受setlocale()的影响 */
   inline static bool IsWhiteSpace( char c )		
   {
-    return ( isspace( (unsigned char) c ) || c == '\n' || c == '\r' ); 
+    return ( c == ' ' || ( c >= '\t' && c <= '\r' ) );
   }
   inline static bool IsWhiteSpace( int c )
   {
@@ -87,15 +134,43 @@ protected:
 
   /* 从给的字符串中读取名字，读取到的内容放到name中。返回值指向名字最后一个字符的下一个位置 */
   static const char* ReadName( const char* p, TIXML_STRING* name, TiXmlEncoding encoding );
+  /* 同上。inSitu为true时name只引用p所在的缓冲区，不拷贝；names不为0时name指向名字表中的那一份 */
+  static const char* ReadName( const char* p, TiXmlStringRef* name, bool inSitu, TiXmlNameTable* names, TiXmlEncoding encoding );
   
   /* 输入：in
    * 输出：text
-   * 参数：trimWhiteSpace - 是否修剪多余的空格，作用与condenseWhiteSpace一致
+   * 参数：trimWhiteSpace - 是否合并空白，由解析选项TiXmlParseOptions决定
    *       endTag - XML的结束标识符
    *       ignoreCase - 不区分大小写
-   * 返回值：XML的结束标识符的下一个位置
+   *       maxLength - 资源限制(TiXmlParsingData::StringBudget())，text超过它时马上停止
+   * 返回值：XML的结束标识符的下一个位置。超过maxLength时返回0，这时text->length()大于maxLength
+   * "\r\n"和单独的'\r'都会换成'\n'，所以输入不需要预先规范化换行符
+   */
+  static const char* ReadText(const char* in, TIXML_STRING* text, bool trimWhiteSpace, const char* endTag, bool ignoreCase, TiXmlEncoding encoding, size_t maxLength = (size_t)-1 );	
+
+  /* 就地解析版本的ReadText()，参数和返回值与ReadText()相同。
+   * 它只扫描和检查文本，text引用缓冲区中的原始内容，并记下解析结束后还需要做的处理(解码实体引用、合并空白)。
+   * 引用的原文超过maxLength时停止
    */
-  static const char* ReadText(const char* in, TIXML_STRING* text, bool trimWhiteSpace, const char* endTag, bool ignoreCase, TiXmlEncoding encoding );	
+  static const char* ReadTextInSitu(const char* in, TiXmlStringRef* text, bool trimWhiteSpace, const char* endTag, bool ignoreCase, TiXmlEncoding encoding, size_t maxLength = (size_t)-1 );
+
+  /* ReadText()和ReadTextInSitu()的特化实现，由它们根据参数选出一份来调用 */
+  template< bool UTF8, bool CONDENSE, bool IGNORE_CASE >
+  static const char* ReadTextT( const char* in, TIXML_STRING* text, const char* endTag, size_t maxLength );
+  template< bool UTF8, bool CONDENSE, bool IGNORE_CASE >
+  static const char* ReadTextInSituT( const char* in, TiXmlStringRef* text, const char* endTag, size_t maxLength );
+  template< bool IGNORE_CASE >
+  static bool AtEndTag( const char* p, const char* endTag, size_t endLength, TiXmlEncoding encoding );
+
+  /* 就地解码[p, p+length)中的实体引用，condense为true时同时合并空白，返回解码后的长度。
+   * 解码后的内容不会比原来长，所以可以直接写回原来的位置
+   */
+  static size_t DecodeInSitu( char* p, size_t length, bool condense, TiXmlEncoding encoding );
+  template< bool CONDENSE >
+  static size_t DecodeInSituT( char* p, size_t length, TiXmlEncoding encoding );
+
+  /* 把[p, p+length)追加到out，同时把"\r\n"和单独的'\r'换成'\n' */
+  static void AppendNewlineNormalized( const char* p, size_t length, TIXML_STRING* out );
   
   // If an entity has been found, transform it into a character.
   /* 实体引用
@@ -109,7 +184,7 @@ protected:
      &quot;      "           引号
      
      GetEntity()的作用就是如果找到了实体引用，就将这个实体引用转化为实际对应的字符
-     返回值是指向实体引用的下一个位置
+     返回值是指向实体引用的下一个位置。字符引用的格式不对时返回0
    */
   static const char* GetEntity(const char* in, char* value, int* length, TiXmlEncoding encoding );
   
@@ -125,8 +200,15 @@ protected:
   /* 包含着错误码与错误信息的对应关系 */
   static const char* errorString[ TIXML_ERROR_STRING_COUNT ];
   
-  /* 游标信息 */
-  TiXmlCursor location;
+  /* 在输入中的字节偏移，没有时为NO_LOCATION */
+  enum { NO_LOCATION = -1 };
+  size_t location;
+  /* 记下location的那次解析(TiXmlParsingData::Generation())，和文档行索引的不同时location不能用 */
+  int    generation;
+  bool   inArena;
+
+  /* 换算行列号用的文档：节点是GetDocument()，属性是它的document */
+  virtual const TiXmlDocument* LocationDocument() const { return 0; }
   
   /* 指向用户数据的指针 */
   void*  userData;
@@ -158,11 +240,23 @@ private:
     MAX_ENTITY_LENGTH = 6
   };
   static Entity entity[ NUM_ENTITY ];
-  
-  static bool condenseWhiteSpace;
+
+  /* 从内存池分配、还没有构造的对象；刚析构完、等待operator delete的内存池对象 */
+  static TIXML_THREAD_LOCAL void* arenaAllocated;
+  static TIXML_THREAD_LOCAL void* arenaReleased;
 };
 
 /* 方法 */
+TiXmlCursor TiXmlBase::Location() const
+{
+  const TiXmlDocument* document = LocationDocument();
+  if ( document && location != (size_t)NO_LOCATION )
+    return document->LocationOf( location, generation );
+  TiXmlCursor cursor;
+  cursor.Clear();
+  return cursor;
+}
+
 const char* TiXmlBase::errorString[ TiXmlBase::TIXML_ERROR_STRING_COUNT ] = 
 {
   "No error",
@@ -181,93 +275,607 @@ const char* TiXmlBase::errorString[ TiXmlBase::TIXML_ERROR_STRING_COUNT ] =
   "Error null (0) or unexpected EOF found in input stream.",
   "Error parsing CDATA.",
   "Error when TiXmlDocument added to document, because TiXmlDocument can only be at the root.",
+  "Error reading binary snapshot: bad header, version, byte order, checksum or layout.",
+  "Error: memory limit exceeded while parsing.",
+  "Error: node count limit exceeded while parsing.",
+  "Error: nesting depth limit exceeded while parsing.",
+  "Error: too many attributes on an element.",
+  "Error: name, attribute value or text too long.",
 };
 
-void TiXmlBase::EncodeString( const TIXML_STRING& str, TIXML_STRING* outString )
+void TiXmlBase::EncodeString( const char* str, size_t length, TIXML_STRING* outString )
 {
-  int i=0;
+  const char* p = str;
+  const char* end = str + length;
 
-  while( i<(int)str.length() )
-  {     
-    unsigned char c = (unsigned char) str[i];
+  /* 用TiXmlScanner::FindEscape()找到下一个需要转义的字符，中间的内容整段追加 */
+  const char* special = TiXmlScanner::FindEscape( p, end );
+  if ( special == end )
+  {
+    outString->append( str, length );
+    return;
+  }
+
+  /* 转义后会变长，一次预留足够的空间，避免追加过程中反复扩容 */
+  outString->reserve( outString->length() + length + length / 4 + 16 );
 
-    if (c == '&' && i < ( (int)str.length() - 2 ) && str[i+1] == '#' && str[i+2] == 'x') 
+  while ( p < end )
+  {
+    if ( special != p )
     {
-      while ( i<(int)str.length()-1 )
-      {                 
-        outString->append( str.c_str() + i, 1 );
-        ++i;
-        if ( str[i] == ';' )
-          break;
+      outString->append( p, special - p );
+      p = special;
+      if ( p == end )
+        break;
+    }
+
+    const char* out;
+    size_t outLength;
+    char scratch[ ENCODE_SCRATCH ];
+    p = EncodeSpecial( p, end, &out, &outLength, scratch );
+    outString->append( out, outLength );
+
+    special = ( p < end ) ? TiXmlScanner::FindEscape( p, end ) : end;
+  }
+}
+
+/* 对p处需要转义的字符编码，p必须是TiXmlScanner::FindEscape()找到的位置 */
+const char* TiXmlBase::EncodeSpecial( const char* p, const char* end, const char** out, size_t* outLength, char* scratch )
+{
+  unsigned char c = (unsigned char) *p;
+
+  if ( c == '&' && p < end - 2 && p[1] == '#' && p[2] == 'x' )
+  {
+    /* 已经是"&#x..;"形式的字符引用，原样输出到';'之前(';'由下一轮作为普通字符追加) */
+    const char* semi = (const char*) memchr( p + 1, ';', end - ( p + 1 ) );
+    const char* stop = semi ? semi : end - 1;
+    *out = p;
+    *outLength = stop - p;
+    return stop;
+  }
+
+  /* 这个顺序必须与tinyxmlparser.cpp:43的TiXmlBase::Entity TiXmlBase::entity()一致 */
+  int i = -1;
+  switch ( c )
+  {
+    case '&':   i = 0;  break;
+    case '<':   i = 1;  break;
+    case '>':   i = 2;  break;
+    case '\"':  i = 3;  break;
+    case '\'':  i = 4;  break;
+    default:            break;
+  }
+  if ( i >= 0 )
+  {
+    *out = entity[i].str;
+    *outLength = entity[i].strLength;
+    return p + 1;
+  }
+
+  /* 剩下的只有小于32的控制字符，输出成"&#xHH;"。直接查表，不用sprintf() */
+  static const char hex[] = "0123456789ABCDEF";
+  scratch[0] = '&'; scratch[1] = '#'; scratch[2] = 'x';
+  scratch[3] = hex[ c >> 4 ]; scratch[4] = hex[ c & 0xf ]; scratch[5] = ';';
+  *out = scratch;
+  *outLength = 6;
+  return p + 1;
+}
+
+const char* TiXmlBase::ReadName( const char* p, TIXML_STRING * name, TiXmlEncoding encoding )
+{
+  /* 有的编译器下不支持name->clear()这种模式，所以用直接赋值的方式 */
+  *name = "";
+
+  /* name的命名方式：以下划线(_)和英文字母开头，其他字符可以是数字、字母、'_'、'.'和':' */
+  if (p && *p && (IsAlpha( (unsigned char) *p, encoding ) || *p == '_' ))
+  {
+    const char* start = p; 
+    /* 后面的字符是数字、字母、'_'、'-'、'.'、':'或者>= 127的字节 */
+    p = TiXmlScanner::NameEnd( p );
+    if ( p-start > 0 ) 
+    {
+      name->assign(start, p-start );
+    }
+    return p;
+  }
+  return 0;
+}
+
+const char* TiXmlBase::ReadName( const char* p, TiXmlStringRef* name, bool inSitu, TiXmlNameTable* names, TiXmlEncoding encoding )
+{
+  if ( !inSitu && !names )
+    return ReadName( p, name->Mutable(), encoding );
+
+  if (p && *p && (IsAlpha( (unsigned char) *p, encoding ) || *p == '_' ))
+  {
+    const char* start = p;
+    p = TiXmlScanner::NameEnd( p );
+    const char* interned = names ? names->Intern( start, p-start ) : 0;
+    if ( interned )
+      name->Intern( interned, p-start );
+    else if ( inSitu )
+      /* 名字中没有实体引用，也不需要合并空白，解析结束后补上'\0'就行 */
+      name->Refer( start, p-start );
+    else
+      name->Mutable()->assign( start, p-start );
+    return p;
+  }
+  *name = "";
+  return 0;
+}
+
+/* 以下几个函数先根据参数选出一份特化的实现，再进入循环。
+ * 编码、是否合并空白、是否忽略大小写都是模板参数，循环中不再逐个字符判断这些条件，
+ * GetChar()等内联函数收到的encoding也是常量，里面的分支在编译时就去掉了
+ */
+const char* TiXmlBase::ReadText( const char* p, TIXML_STRING * text, bool trimWhiteSpace, const char* endTag, bool caseInsensitive, TiXmlEncoding encoding, size_t maxLength )
+{
+  const bool utf8 = ( encoding == TIXML_ENCODING_UTF8 );
+  switch ( ( utf8 ? 4 : 0 ) | ( trimWhiteSpace ? 2 : 0 ) | ( caseInsensitive ? 1 : 0 ) )
+  {
+    case 0:   return ReadTextT< false, false, false >( p, text, endTag );
+    case 1:   return ReadTextT< false, false, true  >( p, text, endTag );
+    case 2:   return ReadTextT< false, true,  false >( p, text, endTag );
+    case 3:   return ReadTextT< false, true,  true  >( p, text, endTag );
+    case 4:   return ReadTextT< true,  false, false >( p, text, endTag );
+    case 5:   return ReadTextT< true,  false, true  >( p, text, endTag );
+    case 6:   return ReadTextT< true,  true,  false >( p, text, endTag );
+    default:  return ReadTextT< true,  true,  true  >( p, text, endTag );
+  }
+}
+
+const char* TiXmlBase::ReadTextInSitu( const char* p, TiXmlStringRef* text, bool trimWhiteSpace, const char* endTag, bool caseInsensitive, TiXmlEncoding encoding, size_t maxLength )
+{
+  const bool utf8 = ( encoding == TIXML_ENCODING_UTF8 );
+  switch ( ( utf8 ? 4 : 0 ) | ( trimWhiteSpace ? 2 : 0 ) | ( caseInsensitive ? 1 : 0 ) )
+  {
+    case 0:   return ReadTextInSituT< false, false, false >( p, text, endTag );
+    case 1:   return ReadTextInSituT< false, false, true  >( p, text, endTag );
+    case 2:   return ReadTextInSituT< false, true,  false >( p, text, endTag );
+    case 3:   return ReadTextInSituT< false, true,  true  >( p, text, endTag );
+    case 4:   return ReadTextInSituT< true,  false, false >( p, text, endTag );
+    case 5:   return ReadTextInSituT< true,  false, true  >( p, text, endTag );
+    case 6:   return ReadTextInSituT< true,  true,  false >( p, text, endTag );
+    default:  return ReadTextInSituT< true,  true,  true  >( p, text, endTag );
+  }
+}
+
+/* 区分大小写时直接比较字节，不经过StringEqual()；p处至少还有一个字符 */
+template< bool IGNORE_CASE >
+inline bool TiXmlBase::AtEndTag( const char* p, const char* endTag, size_t endLength, TiXmlEncoding encoding )
+{
+  if ( IGNORE_CASE )
+    return StringEqual( p, endTag, true, encoding );
+  return *p == *endTag && strncmp( p + 1, endTag + 1, endLength - 1 ) == 0;
+}
+
+template< bool UTF8, bool CONDENSE, bool IGNORE_CASE >
+const char* TiXmlBase::ReadTextT( const char* p, TIXML_STRING * text, const char* endTag, size_t maxLength )
+{
+  const TiXmlEncoding encoding = UTF8 ? TIXML_ENCODING_UTF8 : TIXML_ENCODING_LEGACY;
+  const size_t endLength = strlen( endTag );
+  *text = "";
+
+  /* 不需要特殊处理的一段内容(没有结束标识符的首字符、'&'、'\r'，合并空白时也没有空白)
+   * 用TiXmlScanner::FindText()找出来，整段追加，UTF-8的多字节字符也在段中。
+   * 段与段之间只剩下ASCII字符：'&'交给GetEntity()，'\r'换成'\n'，空白在这里合并。
+   * 忽略大小写时首字符不好判断，只能逐个字符处理
+   */
+  const int runFlags = CONDENSE ? TiXmlScanner::TIXML_SCAN_SPACE : 0;
+  bool whitespace = false;
+
+  /* 去掉开头的空白 */
+  if ( CONDENSE )
+    p = SkipWhiteSpaceT< UTF8 >( p );
+
+  while ( p && *p && !AtEndTag< IGNORE_CASE >( p, endTag, endLength, encoding ) )
+  {
+    if ( CONDENSE && IsWhiteSpace( *p ) )
+    {
+      whitespace = true;
+      ++p;
+      continue;
+    }
+    /* 空白都合并成一个' '，加在下一个非空白字符之前 */
+    if ( CONDENSE && whitespace )
+    {
+      (*text) += ' ';
+      whitespace = false;
+    }
+    /* 超过限制时不再读下去，已经读入的最多比maxLength多一个字符 */
+    if ( text->length() > maxLength )
+      return 0;
+
+    if ( !IGNORE_CASE )
+    {
+      const char* run = TiXmlScanner::FindText( p, *endTag, runFlags );
+      if ( run != p )
+      {
+        /* 整段追加之前先看会不会超过限制，超过时只追加到刚好超过 */
+        if ( (size_t)( run - p ) > maxLength - text->length() )
+        {
+          text->append( p, maxLength - text->length() + 1 );
+          return 0;
+        }
+        text->append( p, run - p );
+        p = run;
+        continue;
       }
     }
-    else if ( c == '&' )
+
+    if ( *p == '&' )
     {
-      /* 这个顺序必须与tinyxmlparser.cpp:43的TiXmlBase::Entity TiXmlBase::entity()一致 */
-      outString->append( entity[0].str, entity[0].strLength );
-      ++i;
+      int len;
+      char cArr[4];
+      const char* entity = p;
+      p = GetEntity( p, cArr, &len, encoding );
+      if ( p )
+        text->append( cArr, len );
+#ifdef TIXML_USE_STATS
+      /* 只统计真正解码了的：不认识的实体引用只前进一个字符，格式不对的返回0 */
+      if ( p && p > entity + 1 )
+        ++TiXmlParseStats::counters.entities;
+#endif
     }
-    else if ( c == '<' )
+    else if ( *p == '\r' )
     {
-      outString->append( entity[1].str, entity[1].strLength );
-      ++i;
+      /* 换行符在这里规范化，LoadFileMapped()读入的内容没有经过预处理 */
+      (*text) += '\n';
+      ++p;
+      if ( *p == '\n' )
+        ++p;
     }
-    else if ( c == '>' )
+    else
     {
-      outString->append( entity[2].str, entity[2].strLength );
-      ++i;
+      (*text) += *p;
+      ++p;
     }
-    else if ( c == '\"' )
+  }
+  if ( p && *p )
+    p += endLength;
+  return ( p && *p ) ? p : 0;
+}
+
+/* 扫描的过程和ReadTextT()完全一样(包括对GetEntity()的调用，保证出错的情况也一样)，只是不往text里追加字符 */
+template< bool UTF8, bool CONDENSE, bool IGNORE_CASE >
+const char* TiXmlBase::ReadTextInSituT( const char* p, TiXmlStringRef* text, const char* endTag, size_t maxLength )
+{
+  const TiXmlEncoding encoding = UTF8 ? TIXML_ENCODING_UTF8 : TIXML_ENCODING_LEGACY;
+  const size_t endLength = strlen( endTag );
+  TiXmlStringRef::Pending pending = TiXmlStringRef::TIXML_PENDING_NONE;
+
+  if ( CONDENSE )
+  {
+    /* 去掉开头的空白 */
+    p = SkipWhiteSpaceT< UTF8 >( p );
+  }
+
+  const int runFlags = CONDENSE ? TiXmlScanner::TIXML_SCAN_SPACE : 0;
+
+  const char* start = p;
+  bool whitespace = false;
+  while ( p && *p && !AtEndTag< IGNORE_CASE >( p, endTag, endLength, encoding ) )
+  {
+    if ( (size_t)( p - start ) > maxLength )
+    {
+      text->Refer( start, p - start, pending );
+      return 0;
+    }
+    if ( CONDENSE && IsWhiteSpace( *p ) )
     {
-      outString->append( entity[3].str, entity[3].strLength );
-      ++i;
+      /* 只有单个的' '可以原样保留，其他情况都要在解析结束后合并 */
+      if ( whitespace || *p != ' ' )
+        pending = TiXmlStringRef::TIXML_PENDING_CONDENSE;
+      whitespace = true;
+      ++p;
+      continue;
     }
-    else if ( c == '\'' )
+
+    whitespace = false;
+    /* 不需要处理的一段直接跳过 */
+    if ( !IGNORE_CASE )
+    {
+      const char* run = TiXmlScanner::FindText( p, *endTag, runFlags );
+      if ( run != p )
+      {
+        p = run;
+        continue;
+      }
+    }
+    if ( ( *p == '&' || *p == '\r' ) && pending == TiXmlStringRef::TIXML_PENDING_NONE )
+      pending = CONDENSE ? TiXmlStringRef::TIXML_PENDING_CONDENSE : TiXmlStringRef::TIXML_PENDING_ENTITIES;
+
+    if ( *p == '&' )
     {
-      outString->append( entity[4].str, entity[4].strLength );
-      ++i;
+      int len;
+      char cArr[4];
+      p = GetEntity( p, cArr, &len, encoding );
     }
-    else if ( c < 32 )
+    else
+      ++p;
+  }
+  /* 结尾的空白也要去掉 */
+  if ( whitespace )
+    pending = TiXmlStringRef::TIXML_PENDING_CONDENSE;
+
+  if ( p )
+    text->Refer( start, p - start, pending );
+
+  if ( p && *p )
+    p += endLength;
+  return ( p && *p ) ? p : 0;
+}
+
+size_t TiXmlBase::DecodeInSitu( char* p, size_t length, bool condense, TiXmlEncoding encoding )
+{
+  return condense ? DecodeInSituT< true >( p, length, encoding ) : DecodeInSituT< false >( p, length, encoding );
+}
+
+template< bool CONDENSE >
+size_t TiXmlBase::DecodeInSituT( char* p, size_t length, TiXmlEncoding encoding )
+{
+  const char* in = p;
+  const char* end = p + length;
+  char* out = p;
+  bool whitespace = false;
+  const char* amp = 0;    /* 下一个'&'，不合并空白时使用。0表示还没有找过 */
+
+  while ( in < end )
+  {
+    if ( !CONDENSE && *in != '&' && *in != '\r' )
     {
-      char buf[ 32 ];
+      /* 到下一个'&'或'\r'之前的内容整段移过去。'&'的位置记下来，'\r'多的时候不用重复查找 */
+      if ( !amp || amp < in )
+      {
+        amp = (const char*) memchr( in, '&', end - in );
+        if ( !amp )
+          amp = end;
+      }
+      const char* cr = (const char*) memchr( in, '\r', amp - in );
+      const char* stop = cr ? cr : amp;
+      if ( out != in )
+        memmove( out, in, stop - in );
+      out += stop - in;
+      in = stop;
+      continue;
+    }
 
-      #if defined(TIXML_SNPRINTF)   
-        TIXML_SNPRINTF( buf, sizeof(buf), "&#x%02X;", (unsigned) ( c & 0xff ) );
-      #else
-        sprintf( buf, "&#x%02X;", (unsigned) ( c & 0xff ) );
-      #endif
+    if ( CONDENSE && IsWhiteSpace( *in ) )
+    {
+      whitespace = true;
+      ++in;
+      continue;
+    }
+    /* 连续的空白合并成一个' ' */
+    if ( whitespace )
+    {
+      *out++ = ' ';
+      whitespace = false;
+    }
 
-      outString->append( buf, (int)strlen( buf ) );
-      ++i;
+    if ( *in == '\r' )
+    {
+      /* 不合并空白时，换行符也要规范化 */
+      *out++ = '\n';
+      ++in;
+      if ( in < end && *in == '\n' )
+        ++in;
+    }
+    else if ( *in == '&' )
+    {
+      /* 解析时已经用GetEntity()检查过，这里不会失败 */
+      int len = 0;
+      char cArr[4] = { 0, 0, 0, 0 };
+      const char* entity = in;
+      in = GetEntity( in, cArr, &len, encoding );
+      memcpy( out, cArr, len );
+      out += len;
+#ifdef TIXML_USE_STATS
+      if ( in > entity + 1 )
+        ++TiXmlParseStats::counters.entities;
+#endif
     }
     else
     {
-      //char realc = (char) c;
-      //outString->append( &realc, 1 );
-      *outString += (char) c; // somewhat more efficient function call.
-      ++i;
+      *out++ = *in++;
     }
   }
+  return out - p;
 }
 
-const char* TiXmlBase::ReadName( const char* p, TIXML_STRING * name, TiXmlEncoding encoding )
+/* 按'&'后面的字符直接分派，不逐个和entity表比较 */
+const char* TiXmlBase::GetEntity( const char* p, char* value, int* length, TiXmlEncoding encoding )
 {
-  /* 有的编译器下不支持name->clear()这种模式，所以用直接赋值的方式 */
-  *name = "";
+  *length = 0;
 
-  /* name的命名方式：以下划线(_)和英文字母开头，其他字符可以是数字、字母、'_'、'.'和':' */
-  if (p && *p && (IsAlpha( (unsigned char) *p, encoding ) || *p == '_' ))
+  if ( p[1] == '#' && p[2] )
   {
-    const char* start = p; 
-    while(p && *p &&  (IsAlphaNum((unsigned char ) *p, encoding) || *p == '_' || *p == '-' || *p == '.' || *p == ':' ))
+    /* 字符引用&#nnn;和&#xhhh;。超出Unicode范围的值不输出任何字符 */
+    unsigned long ucs = 0;
+    const char* q = p + 2;
+    if ( *q == 'x' )
     {
-      ++p;
+      for ( ++q; *q != ';'; ++q )
+      {
+        unsigned int digit;
+        if ( *q >= '0' && *q <= '9' )
+          digit = *q - '0';
+        else if ( *q >= 'a' && *q <= 'f' )
+          digit = *q - 'a' + 10;
+        else if ( *q >= 'A' && *q <= 'F' )
+          digit = *q - 'A' + 10;
+        else
+          return 0;
+        if ( ucs <= 0x10FFFF )
+          ucs = ucs * 16 + digit;
+      }
     }
-    if ( p-start > 0 ) 
+    else
     {
-      name->assign(start, p-start );
+      for ( ; *q != ';'; ++q )
+      {
+        if ( *q < '0' || *q > '9' )
+          return 0;
+        if ( ucs <= 0x10FFFF )
+          ucs = ucs * 10 + ( *q - '0' );
+      }
     }
-    return p;
+
+    if ( encoding == TIXML_ENCODING_UTF8 )
+    {
+      ConvertUTF32ToUTF8( ucs, value, length );
+    }
+    else
+    {
+      *value = (char)ucs;
+      *length = 1;
+    }
+    return q + 1;
   }
-  return 0;
+
+  /* 五个预定义的实体引用。逐个字符比较，遇到'\0'就不会再往后读 */
+  char c = 0;
+  const char* next = 0;
+  switch ( p[1] )
+  {
+    case 'l':
+      if ( p[2] == 't' && p[3] == ';' )   { c = '<'; next = p + 4; }
+      break;
+    case 'g':
+      if ( p[2] == 't' && p[3] == ';' )   { c = '>'; next = p + 4; }
+      break;
+    case 'a':
+      if ( p[2] == 'm' && p[3] == 'p' && p[4] == ';' )                    { c = '&'; next = p + 5; }
+      else if ( p[2] == 'p' && p[3] == 'o' && p[4] == 's' && p[5] == ';' ) { c = '\''; next = p + 6; }
+      break;
+    case 'q':
+      if ( p[2] == 'u' && p[3] == 'o' && p[4] == 't' && p[5] == ';' )     { c = '\"'; next = p + 6; }
+      break;
+    default:
+      break;
+  }
+  if ( next )
+  {
+    *value = c;
+    *length = 1;
+    return next;
+  }
+
+  /* 不认识的实体引用不算错误，'&'原样保留 */
+  *value = *p;
+  *length = 1;
+  return p + 1;
+}
+
+void* TiXmlBase::operator new( size_t size )
+{
+  return operator new( size, (TiXmlArena*)0 );
+}
+
+TIXML_THREAD_LOCAL void* TiXmlBase::arenaAllocated = 0;
+TIXML_THREAD_LOCAL void* TiXmlBase::arenaReleased = 0;
+
+void* TiXmlBase::operator new( size_t size, TiXmlArena* arena )
+{
+  void* p = 0;
+  if ( arena )
+  {
+    p = arena->Alloc( size );
+    if ( !p )
+      throw std::bad_alloc();
+    /* 马上要执行的构造函数据此设置inArena。参数中临时构造的节点地址不同，不受影响 */
+    arenaAllocated = p;
+  }
+  else
+  {
+    p = ::operator new( size );
+  }
+#ifdef TIXML_USE_STATS
+  ++TiXmlParseStats::counters.allocations;
+  TiXmlParseStats::counters.bytesAllocated += size;
+#endif
+  return p;
+}
+
+void TiXmlBase::operator delete( void* p )
+{
+  if ( !p )
+    return;
+
+  /* 来自内存池的内存不单独释放，等文档Clear或析构时整块回收 */
+  if ( p == arenaReleased )
+  {
+    arenaReleased = 0;
+    return;
+  }
+  ::operator delete( p );
+}
+
+/* 只有构造函数抛出异常时才会被调用，这时还没有析构函数来设置arenaReleased */
+void TiXmlBase::operator delete( void* p, TiXmlArena* arena )
+{
+  if ( arena )
+  {
+    if ( p == arenaAllocated )
+      arenaAllocated = 0;
+    return;
+  }
+  ::operator delete( p );
+}
+
+void TiXmlBase::AppendNewlineNormalized( const char* p, size_t length, TIXML_STRING* out )
+{
+  const char* end = p + length;
+  while ( p < end )
+  {
+    /* 没有'\r'的部分整段追加 */
+    const char* cr = (const char*) memchr( p, '\r', end - p );
+    if ( !cr )
+    {
+      out->append( p, end - p );
+      return;
+    }
+    out->append( p, cr - p );
+    *out += '\n';
+    p = cr + 1;
+    if ( p < end && *p == '\n' )
+      ++p;
+  }
+}
+
+const char* TiXmlBase::SkipWhiteSpace( const char* p, TiXmlEncoding encoding )
+{
+  return ( encoding == TIXML_ENCODING_UTF8 ) ? SkipWhiteSpaceT< true >( p ) : SkipWhiteSpaceT< false >( p );
+}
+
+template< bool UTF8 >
+const char* TiXmlBase::SkipWhiteSpaceT( const char* p )
+{
+  if ( !p || !*p )
+  {
+    return 0;
+  }
+  if ( UTF8 )
+  {
+    for ( ;; )
+    {
+      p = TiXmlScanner::SkipSpace( p );
+
+      /* 跳过微软的UTF-8 BOM(0xef 0xbb 0xbf)，以及0xef 0xbf 0xbe、0xef 0xbf 0xbf */
+      const unsigned char* pU = (const unsigned char*)p;
+      if ( pU[0] == TIXML_UTF_LEAD_0
+        && ( ( pU[1] == TIXML_UTF_LEAD_1 && pU[2] == TIXML_UTF_LEAD_2 )
+          || ( pU[1] == 0xbfU && ( pU[2] == 0xbeU || pU[2] == 0xbfU ) ) ) )
+      {
+        p += 3;
+        continue;
+      }
+      break;
+    }
+  }
+  else
+  {
+    p = TiXmlScanner::SkipSpace( p );
+  }
+  return p;
 }
@@ -0,0 +1,314 @@
+/* 类 */
+
+#if defined( TIXML_USE_THREADS ) && ( defined( __unix__ ) || defined( __APPLE__ ) )
+  #define TIXML_BATCH_PTHREAD
+  #include <pthread.h>
+#endif
+
+/* 批量加载很多个小文档，由一个固定大小的线程池并发解析。
+ * 每个输入得到一个TiXmlDocument，顺序和加入的顺序相同，出错的信息在各自的文档中：
+ *
+ *   TiXmlBatchLoader loader;
+ *   for ( ... ) loader.AddFile( path );
+ *   loader.Run();
+ *   for ( int i = 0; i < loader.Count(); ++i )
+ *     if ( loader.Document( i )->Error() ) ...
+ *
+ * 输入开始时按顺序平均分给各个线程；某个线程做完了自己的部分，就从别的线程剩下的任务中偷走后一半
+ * (work stealing)，文件大小差别很大时也不会有线程闲着。
+ * 解析不读写任何全局状态，解析选项(TiXmlParseOptions)在各文档自己身上，所以可以同时解析。
+ * 没有定义TIXML_USE_THREADS时在当前线程中逐个加载
+ */
+class TiXmlBatchLoader
+{
+public:
+  /* threads为0时使用CPU的个数 */
+  TiXmlBatchLoader( int threads = 0 );
+  ~TiXmlBatchLoader();
+
+  /* 加入一个文件，或者一块以'\0'结尾的缓冲区。两者在Run()返回之前都要一直有效 */
+  void AddFile( const char* filename );
+  void AddBuffer( const char* xml );
+
+  /* 每个文档的解析选项，各文档各自一份，互不影响 */
+  void SetParseOptions( const TiXmlParseOptions& _options ) { options = _options; }
+  void SetUseArena( bool use )                    { useArena = use; }
+  /* 文件用TiXmlDocument::LoadFileMapped()加载 */
+  void SetMapped( bool use )                      { mapped = use; }
+
+  /* 加载所有的输入，全部成功时返回true。之前的结果会被清掉 */
+  bool Run();
+
+  int Count() const { return count; }
+  /* 第i个输入的文档，由loader拥有 */
+  TiXmlDocument* Document( int i ) const { return ( i >= 0 && i < count ) ? jobs[i].document : 0; }
+  /* 取走第i个文档，之后由调用者delete */
+  TiXmlDocument* Release( int i );
+  /* 出错的文档个数 */
+  int ErrorCount() const { return errors; }
+
+  /* 清空输入和结果 */
+  void Clear();
+
+private:
+  /* 不允许拷贝 */
+  TiXmlBatchLoader( const TiXmlBatchLoader& );
+  void operator=( const TiXmlBatchLoader& );
+
+  struct Job
+  {
+    const char*     filename;   /* 文件和缓冲区只有一个不为0 */
+    const char*     xml;
+    TiXmlDocument*  document;
+  };
+
+  /* 一个线程的任务：jobs中[begin, end)的部分。自己从begin取，别人从end偷 */
+  struct Queue
+  {
+    TiXmlBatchLoader* loader;
+    int   begin;
+    int   end;
+    int   index;
+#ifdef TIXML_BATCH_PTHREAD
+    pthread_mutex_t lock;
+#endif
+  };
+
+  void Add( const char* filename, const char* xml );
+  void Load( Job* job );
+
+  /* 从自己的队列中取一个任务，没有时返回-1 */
+  int Pop( Queue* queue );
+  /* 从别的队列偷一半到自己的队列，什么都没偷到时返回false */
+  bool Steal( Queue* queue );
+  static void* Work( void* arg );
+
+  int   threads;
+  Job*  jobs;
+  int   count;
+  int   capacity;
+  int   errors;
+
+  Queue*  queues;
+  int     queueCount;
+
+  TiXmlParseOptions options;
+  bool  useArena;
+  bool  mapped;
+};
+
+/* 方法 */
+
+TiXmlBatchLoader::TiXmlBatchLoader( int _threads )
+  : threads( _threads ), jobs( 0 ), count( 0 ), capacity( 0 ), errors( 0 ), queues( 0 ), queueCount( 0 ),
+    useArena( false ), mapped( false )
+{
+  if ( threads <= 0 )
+  {
+#ifdef TIXML_BATCH_PTHREAD
+    long n = sysconf( _SC_NPROCESSORS_ONLN );
+    threads = n > 0 ? (int)n : 1;
+#else
+    threads = 1;
+#endif
+  }
+}
+
+TiXmlBatchLoader::~TiXmlBatchLoader()
+{
+  Clear();
+}
+
+void TiXmlBatchLoader::Clear()
+{
+  for ( int i = 0; i < count; ++i )
+    delete jobs[i].document;
+  delete [] jobs;
+  jobs = 0;
+  count = capacity = errors = 0;
+}
+
+void TiXmlBatchLoader::AddFile( const char* filename )
+{
+  Add( filename, 0 );
+}
+
+void TiXmlBatchLoader::AddBuffer( const char* xml )
+{
+  Add( 0, xml );
+}
+
+void TiXmlBatchLoader::Add( const char* filename, const char* xml )
+{
+  if ( count == capacity )
+  {
+    int newCapacity = capacity ? capacity * 2 : 64;
+    Job* newJobs = new Job[ newCapacity ];
+    if ( count )
+      memcpy( newJobs, jobs, count * sizeof( Job ) );
+    delete [] jobs;
+    jobs = newJobs;
+    capacity = newCapacity;
+  }
+  jobs[count].filename = filename;
+  jobs[count].xml = xml;
+  jobs[count].document = 0;
+  ++count;
+}
+
+TiXmlDocument* TiXmlBatchLoader::Release( int i )
+{
+  if ( i < 0 || i >= count )
+    return 0;
+  TiXmlDocument* document = jobs[i].document;
+  jobs[i].document = 0;
+  return document;
+}
+
+void TiXmlBatchLoader::Load( Job* job )
+{
+  TiXmlDocument* document = new TiXmlDocument();
+  document->SetParseOptions( options );
+  document->UseArena( useArena );
+
+  if ( job->filename )
+  {
+    if ( mapped )
+      document->LoadFileMapped( job->filename, options.Encoding() );
+    else
+      document->LoadFile( job->filename, options.Encoding() );
+  }
+  else
+  {
+    document->Parse( job->xml, 0, options.Encoding() );
+  }
+  job->document = document;
+}
+
+bool TiXmlBatchLoader::Run()
+{
+  errors = 0;
+  for ( int i = 0; i < count; ++i )
+  {
+    delete jobs[i].document;
+    jobs[i].document = 0;
+  }
+  if ( !count )
+    return true;
+
+  /* 线程不比任务多 */
+  queueCount = threads < count ? threads : count;
+  queues = new Queue[ queueCount ];
+  for ( int i = 0; i < queueCount; ++i )
+  {
+    queues[i].loader = this;
+    queues[i].index = i;
+    queues[i].begin = (int)( (long long)count * i / queueCount );
+    queues[i].end = (int)( (long long)count * ( i + 1 ) / queueCount );
+#ifdef TIXML_BATCH_PTHREAD
+    pthread_mutex_init( &queues[i].lock, 0 );
+#endif
+  }
+
+#ifdef TIXML_BATCH_PTHREAD
+  /* 第0个队列由当前线程处理 */
+  pthread_t* workers = new pthread_t[ queueCount ];
+  bool* started = new bool[ queueCount ];
+  for ( int i = 1; i < queueCount; ++i )
+    started[i] = pthread_create( &workers[i], 0, Work, &queues[i] ) == 0;
+  Work( &queues[0] );
+  for ( int i = 1; i < queueCount; ++i )
+  {
+    if ( started[i] )
+      pthread_join( workers[i], 0 );
+  }
+  /* 没建起来的线程，它的任务已经被别的线程偷完了 */
+  delete [] started;
+  delete [] workers;
+  for ( int i = 0; i < queueCount; ++i )
+    pthread_mutex_destroy( &queues[i].lock );
+#else
+  Work( &queues[0] );
+#endif
+
+  delete [] queues;
+  queues = 0;
+  queueCount = 0;
+
+  for ( int i = 0; i < count; ++i )
+  {
+    if ( jobs[i].document->Error() )
+      ++errors;
+  }
+  return errors == 0;
+}
+
+void* TiXmlBatchLoader::Work( void* arg )
+{
+  Queue* queue = (Queue*)arg;
+  TiXmlBatchLoader* loader = queue->loader;
+  for ( ;; )
+  {
+    int i = loader->Pop( queue );
+    if ( i < 0 )
+    {
+      if ( !loader->Steal( queue ) )
+        break;
+      continue;
+    }
+    loader->Load( &loader->jobs[i] );
+  }
+  return 0;
+}
+
+int TiXmlBatchLoader::Pop( Queue* queue )
+{
+  int i = -1;
+#ifdef TIXML_BATCH_PTHREAD
+  pthread_mutex_lock( &queue->lock );
+#endif
+  if ( queue->begin < queue->end )
+    i = queue->begin++;
+#ifdef TIXML_BATCH_PTHREAD
+  pthread_mutex_unlock( &queue->lock );
+#endif
+  return i;
+}
+
+/* 从下一个队列开始轮流找，偷走剩下任务中靠后的一半 */
+bool TiXmlBatchLoader::Steal( Queue* queue )
+{
+  for ( int k = 1; k < queueCount; ++k )
+  {
+    Queue* victim = &queues[ ( queue->index + k ) % queueCount ];
+    int begin = 0, end = 0;
+
+#ifdef TIXML_BATCH_PTHREAD
+    pthread_mutex_lock( &victim->lock );
+#endif
+    int left = victim->end - victim->begin;
+    if ( left > 0 )
+    {
+      end = victim->end;
+      begin = end - ( left + 1 ) / 2;
+      victim->end = begin;
+    }
+#ifdef TIXML_BATCH_PTHREAD
+    pthread_mutex_unlock( &victim->lock );
+#endif
+
+    if ( begin < end )
+    {
+#ifdef TIXML_BATCH_PTHREAD
+      pthread_mutex_lock( &queue->lock );
+#endif
+      queue->begin = begin;
+      queue->end = end;
+#ifdef TIXML_BATCH_PTHREAD
+      pthread_mutex_unlock( &queue->lock );
+#endif
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,458 @@
+/* 类 */
+
+/* 属性值和数值之间的转换，类似C++17的std::from_chars()/std::to_chars()：
+ * 不分配内存，不受locale影响，按长度处理(不依赖结尾的'\0')。
+ * 有两种模式：
+ * STRICT  - 整个字符串必须恰好是一个值，前后不能有空白或其他字符，整数不能溢出，浮点数不能超出double的范围
+ * LENIENT - 和原来的sscanf()一样：跳过开头的空白，数值后面的内容忽略。bool和枚举会去掉前后的空白，
+ *           并且不区分大小写
+ * 成功返回TIXML_SUCCESS，失败返回TIXML_WRONG_TYPE，失败时不修改输出参数
+ */
+class TiXmlConvert
+{
+public:
+  enum Mode
+  {
+    STRICT,
+    LENIENT
+  };
+
+  static int ToInt( const char* p, size_t length, int* value, Mode mode );
+  static int ToInt64( const char* p, size_t length, long long* value, Mode mode );
+  static int ToUint64( const char* p, size_t length, unsigned long long* value, Mode mode );
+  static int ToDouble( const char* p, size_t length, double* value, Mode mode );
+  static int ToFloat( const char* p, size_t length, float* value, Mode mode );
+  /* "true"/"false"/"1"/"0"。LENIENT下还接受"yes"/"no"/"on"/"off" */
+  static int ToBool( const char* p, size_t length, bool* value, Mode mode );
+  /* 在tokens[0..count)中查找，value得到下标 */
+  static int ToEnum( const char* p, size_t length, const char* const* tokens, int count, int* value, Mode mode );
+
+  /* 把数值写到buffer中，buffer至少要有BUFFER_SIZE个字节。返回长度，结尾补'\0' */
+  enum { BUFFER_SIZE = 32 };
+  static size_t FromInt64( long long value, char* buffer );
+  static size_t FromUint64( unsigned long long value, char* buffer );
+  /* 输出能够原样读回的最短形式。小数位不超过15位的值不经过sprintf() */
+  static size_t FromDouble( double value, char* buffer );
+
+private:
+  /* 和C locale下的isspace()一样 */
+  static bool IsSpace( char c ) { return c == ' ' || ( c >= '\t' && c <= '\r' ); }
+
+  /* 读取[p, end)开头的十进制数字，溢出或没有数字时返回false */
+  static bool ReadDigits( const char** p, const char* end, unsigned long long* value );
+  /* 读取一个带符号的整数，magnitude是绝对值 */
+  static int ReadInteger( const char* p, size_t length, bool* negative, unsigned long long* magnitude, Mode mode );
+  /* 去掉前后的空白(LENIENT时) */
+  static void Trim( const char** p, const char** end, Mode mode );
+  static bool EqualsToken( const char* p, size_t length, const char* token, Mode mode );
+};
+
+/* 方法 */
+
+void TiXmlConvert::Trim( const char** p, const char** end, Mode mode )
+{
+  if ( mode != LENIENT )
+    return;
+  while ( *p < *end && IsSpace( **p ) )
+    ++*p;
+  while ( *end > *p && IsSpace( *(*end - 1) ) )
+    --*end;
+}
+
+bool TiXmlConvert::ReadDigits( const char** p, const char* end, unsigned long long* value )
+{
+  const unsigned long long MAX = ~0ULL;
+  const char* q = *p;
+  unsigned long long v = 0;
+  while ( q < end && *q >= '0' && *q <= '9' )
+  {
+    unsigned d = *q - '0';
+    if ( v > ( MAX - d ) / 10 )
+      return false;
+    v = v * 10 + d;
+    ++q;
+  }
+  if ( q == *p )
+    return false;
+  *p = q;
+  *value = v;
+  return true;
+}
+
+int TiXmlConvert::ReadInteger( const char* p, size_t length, bool* negative, unsigned long long* magnitude, Mode mode )
+{
+  const char* end = p + length;
+  if ( mode == LENIENT )
+  {
+    while ( p < end && IsSpace( *p ) )
+      ++p;
+  }
+
+  *negative = false;
+  if ( p < end && ( *p == '-' || *p == '+' ) )
+  {
+    *negative = ( *p == '-' );
+    ++p;
+  }
+
+  if ( !ReadDigits( &p, end, magnitude ) )
+    return TIXML_WRONG_TYPE;
+  if ( mode == STRICT && p != end )
+    return TIXML_WRONG_TYPE;
+  return TIXML_SUCCESS;
+}
+
+int TiXmlConvert::ToInt64( const char* p, size_t length, long long* value, Mode mode )
+{
+  bool negative;
+  unsigned long long m;
+  if ( ReadInteger( p, length, &negative, &m, mode ) != TIXML_SUCCESS )
+    return TIXML_WRONG_TYPE;
+
+  /* 负数的绝对值可以比正数多1 */
+  const unsigned long long LIMIT = 0x7fffffffffffffffULL;
+  if ( m > LIMIT + ( negative ? 1 : 0 ) )
+    return TIXML_WRONG_TYPE;
+  *value = negative ? (long long)( 0 - m ) : (long long)m;
+  return TIXML_SUCCESS;
+}
+
+int TiXmlConvert::ToUint64( const char* p, size_t length, unsigned long long* value, Mode mode )
+{
+  bool negative;
+  unsigned long long m;
+  if ( ReadInteger( p, length, &negative, &m, mode ) != TIXML_SUCCESS )
+    return TIXML_WRONG_TYPE;
+  /* "-0"可以，其他负数不行 */
+  if ( negative && m != 0 )
+    return TIXML_WRONG_TYPE;
+  *value = m;
+  return TIXML_SUCCESS;
+}
+
+int TiXmlConvert::ToInt( const char* p, size_t length, int* value, Mode mode )
+{
+  long long v;
+  if ( ToInt64( p, length, &v, mode ) != TIXML_SUCCESS )
+    return TIXML_WRONG_TYPE;
+  if ( v < INT_MIN || v > INT_MAX )
+    return TIXML_WRONG_TYPE;
+  *value = (int)v;
+  return TIXML_SUCCESS;
+}
+
+/* 有效数字不超过19位、指数绝对值不超过22时，尾数和10的幂都能精确表示成double，
+ * 一次乘法或除法的结果就是正确舍入的(Clinger的快速路径)，这是绝大多数属性值的情况。
+ * 其他情况交给strtod()，把小数点换成当前locale的再调用
+ */
+int TiXmlConvert::ToDouble( const char* p, size_t length, double* value, Mode mode )
+{
+  static const double POW10[] =
+  {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  const char* end = p + length;
+  if ( mode == LENIENT )
+  {
+    while ( p < end && IsSpace( *p ) )
+      ++p;
+  }
+  const char* start = p;
+
+  bool negative = false;
+  if ( p < end && ( *p == '-' || *p == '+' ) )
+  {
+    negative = ( *p == '-' );
+    ++p;
+  }
+
+  /* XML Schema中的INF、-INF、NaN */
+  if ( end - p >= 3 && ( memcmp( p, "INF", 3 ) == 0 || ( mode == LENIENT && ( memcmp( p, "inf", 3 ) == 0 ) ) ) )
+  {
+    if ( mode == STRICT && p + 3 != end )
+      return TIXML_WRONG_TYPE;
+    *value = negative ? -HUGE_VAL : HUGE_VAL;
+    return TIXML_SUCCESS;
+  }
+  if ( end - p >= 3 && ( memcmp( p, "NaN", 3 ) == 0 || ( mode == LENIENT && memcmp( p, "nan", 3 ) == 0 ) ) )
+  {
+    /* 和strtod()一样接受带符号的"-NaN"，结果都是NaN */
+    if ( mode == STRICT && p + 3 != end )
+      return TIXML_WRONG_TYPE;
+    *value = HUGE_VAL - HUGE_VAL;
+    return TIXML_SUCCESS;
+  }
+
+  unsigned long long mantissa = 0;
+  int digits = 0;         /* 尾数中的有效数字个数 */
+  int exponent = 0;       /* 十进制指数的修正 */
+  bool truncated = false; /* 超过19位，后面的数字丢掉了 */
+  bool any = false;
+
+  for ( ; p < end && *p >= '0' && *p <= '9'; ++p )
+  {
+    any = true;
+    if ( digits < 19 )
+    {
+      mantissa = mantissa * 10 + ( *p - '0' );
+      if ( mantissa )
+        ++digits;
+    }
+    else
+    {
+      ++exponent;
+      truncated = truncated || *p != '0';
+    }
+  }
+  if ( p < end && *p == '.' )
+  {
+    ++p;
+    for ( ; p < end && *p >= '0' && *p <= '9'; ++p )
+    {
+      any = true;
+      if ( digits < 19 )
+      {
+        mantissa = mantissa * 10 + ( *p - '0' );
+        if ( mantissa )
+          ++digits;
+        --exponent;
+      }
+      else
+      {
+        truncated = truncated || *p != '0';
+      }
+    }
+  }
+  if ( !any )
+    return TIXML_WRONG_TYPE;
+
+  if ( p < end && ( *p == 'e' || *p == 'E' ) )
+  {
+    const char* q = p + 1;
+    bool expNegative = false;
+    if ( q < end && ( *q == '-' || *q == '+' ) )
+    {
+      expNegative = ( *q == '-' );
+      ++q;
+    }
+    unsigned long long e;
+    if ( ReadDigits( &q, end, &e ) )
+    {
+      /* 再大的指数结果也只能是0或者无穷大，截断即可 */
+      int ei = e > 100000 ? 100000 : (int)e;
+      exponent += expNegative ? -ei : ei;
+      p = q;
+    }
+    else if ( mode == STRICT )
+    {
+      return TIXML_WRONG_TYPE;
+    }
+  }
+  if ( mode == STRICT && p != end )
+    return TIXML_WRONG_TYPE;
+
+  if ( !truncated && mantissa <= ( 1ULL << 53 ) && exponent >= -22 && exponent <= 22 )
+  {
+    double d = (double)mantissa;
+    d = ( exponent < 0 ) ? d / POW10[ -exponent ] : d * POW10[ exponent ];
+    *value = negative ? -d : d;
+    return TIXML_SUCCESS;
+  }
+
+  /* 慢路径：拷贝出来，换成locale的小数点，用strtod()转换 */
+  char local[128];
+  TIXML_STRING heap;
+  size_t n = p - start;
+  char* buf = local;
+  if ( n >= sizeof( local ) )
+  {
+    heap.assign( start, n );
+    buf = const_cast< char* >( heap.c_str() );
+  }
+  else
+  {
+    memcpy( buf, start, n );
+    buf[n] = 0;
+  }
+  const char point = *localeconv()->decimal_point;
+  char* dot = (char*)memchr( buf, '.', n );
+  if ( dot )
+    *dot = point;
+  /* 输入是有限的数，结果是无穷大说明溢出了(strtod()的ERANGE)，STRICT下算类型不对。下溢得到0或非规格化数，照常返回 */
+  const double d = strtod( buf, 0 );
+  if ( mode == STRICT && ( d >= HUGE_VAL || d <= -HUGE_VAL ) )
+    return TIXML_WRONG_TYPE;
+  *value = d;
+  return TIXML_SUCCESS;
+}
+
+int TiXmlConvert::ToFloat( const char* p, size_t length, float* value, Mode mode )
+{
+  double d;
+  if ( ToDouble( p, length, &d, mode ) != TIXML_SUCCESS )
+    return TIXML_WRONG_TYPE;
+  /* 超出float范围的有限值算类型不对 */
+  if ( d == d && d > -HUGE_VAL && d < HUGE_VAL && ( d > FLT_MAX || d < -FLT_MAX ) )
+    return TIXML_WRONG_TYPE;
+  *value = (float)d;
+  return TIXML_SUCCESS;
+}
+
+bool TiXmlConvert::EqualsToken( const char* p, size_t length, const char* token, Mode mode )
+{
+  if ( strlen( token ) != length )
+    return false;
+  if ( mode == STRICT )
+    return memcmp( p, token, length ) == 0;
+  for ( size_t i = 0; i < length; ++i )
+  {
+    if ( tolower( (unsigned char)p[i] ) != tolower( (unsigned char)token[i] ) )
+      return false;
+  }
+  return true;
+}
+
+int TiXmlConvert::ToBool( const char* p, size_t length, bool* value, Mode mode )
+{
+  static const char* const TRUE_TOKENS[]  = { "true",  "1", "yes", "on" };
+  static const char* const FALSE_TOKENS[] = { "false", "0", "no",  "off" };
+
+  const char* end = p + length;
+  Trim( &p, &end, mode );
+
+  /* STRICT只认XML Schema中的四种写法 */
+  const int count = ( mode == STRICT ) ? 2 : 4;
+  for ( int i = 0; i < count; ++i )
+  {
+    if ( EqualsToken( p, end - p, TRUE_TOKENS[i], mode ) )
+    {
+      *value = true;
+      return TIXML_SUCCESS;
+    }
+    if ( EqualsToken( p, end - p, FALSE_TOKENS[i], mode ) )
+    {
+      *value = false;
+      return TIXML_SUCCESS;
+    }
+  }
+  return TIXML_WRONG_TYPE;
+}
+
+int TiXmlConvert::ToEnum( const char* p, size_t length, const char* const* tokens, int count, int* value, Mode mode )
+{
+  const char* end = p + length;
+  Trim( &p, &end, mode );
+
+  for ( int i = 0; i < count; ++i )
+  {
+    if ( EqualsToken( p, end - p, tokens[i], mode ) )
+    {
+      *value = i;
+      return TIXML_SUCCESS;
+    }
+  }
+  return TIXML_WRONG_TYPE;
+}
+
+size_t TiXmlConvert::FromUint64( unsigned long long value, char* buffer )
+{
+  /* 从后往前写，再整体移到开头 */
+  char tmp[ BUFFER_SIZE ];
+  char* q = tmp + sizeof( tmp );
+  do
+  {
+    *--q = (char)( '0' + value % 10 );
+    value /= 10;
+  } while ( value );
+
+  size_t n = tmp + sizeof( tmp ) - q;
+  memcpy( buffer, q, n );
+  buffer[n] = 0;
+  return n;
+}
+
+size_t TiXmlConvert::FromInt64( long long value, char* buffer )
+{
+  if ( value < 0 )
+  {
+    buffer[0] = '-';
+    /* 先转成无符号再取反，最小的负数也不会溢出 */
+    return 1 + FromUint64( 0 - (unsigned long long)value, buffer + 1 );
+  }
+  return FromUint64( (unsigned long long)value, buffer );
+}
+
+size_t TiXmlConvert::FromDouble( double value, char* buffer )
+{
+  static const double POW10[] =
+  {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+  };
+  const double LIMIT = 9007199254740992.0;  /* 2^53 */
+
+  if ( value != value )
+  {
+    memcpy( buffer, "NaN", 4 );
+    return 3;
+  }
+  /* -0.0 < 0不成立，用1 / -0.0 == -INF判断符号，输出"-0" */
+  const bool negative = value < 0 || ( value == 0 && 1 / value < 0 );
+  if ( value >= HUGE_VAL || value <= -HUGE_VAL )
+  {
+    memcpy( buffer, value < 0 ? "-INF" : "INF", value < 0 ? 5 : 4 );
+    return value < 0 ? 4 : 3;
+  }
+
+  /* 找最少的小数位数k，使value * 10^k是不超过2^53的整数，并且除回去恰好得到value。
+   * 这时这个十进制数就是能读回value的最短写法
+   */
+  double magnitude = negative ? -value : value;
+  for ( int k = 0; k <= 15; ++k )
+  {
+    double scaled = magnitude * POW10[k];
+    if ( scaled >= LIMIT )
+      break;
+    unsigned long long n = (unsigned long long)scaled;
+    if ( (double)n != scaled || (double)n / POW10[k] != magnitude )
+      continue;
+
+    char digits[ BUFFER_SIZE ];
+    size_t len = FromUint64( n, digits );
+    char* q = buffer;
+    if ( negative )
+      *q++ = '-';
+    if ( k == 0 )
+    {
+      memcpy( q, digits, len + 1 );
+      return q - buffer + len;
+    }
+    /* 不足k+1位时前面补0，再在倒数第k位前插入小数点 */
+    size_t pad = ( len <= (size_t)k ) ? k + 1 - len : 0;
+    size_t total = len + pad;
+    for ( size_t i = 0; i < total; ++i )
+    {
+      if ( i == total - k )
+        *q++ = '.';
+      *q++ = ( i < pad ) ? '0' : digits[ i - pad ];
+    }
+    *q = 0;
+    return q - buffer;
+  }
+
+  /* 很大、很小或者小数位很多的值用"%.17g"，再把locale的小数点换回'.' */
+  #if defined(TIXML_SNPRINTF)
+    TIXML_SNPRINTF( buffer, BUFFER_SIZE, "%.17g", value );
+  #else
+    sprintf( buffer, "%.17g", value );
+  #endif
+  const char point = *localeconv()->decimal_point;
+  if ( point != '.' )
+  {
+    char* dot = strchr( buffer, point );
+    if ( dot )
+      *dot = '.';
+  }
+  return strlen( buffer );
+}
@@ -1,6 +1,8 @@
 /* 类 */
 class TiXmlDocument : public TiXmlNode
 {
+  friend class TiXmlParallelParser;
+  friend class TiXmlSnapshot;
 public:
   /* 构造函数 */
   TiXmlDocument();
@@ -8,18 +10,73 @@ public:
 
   TiXmlDocument( const TiXmlDocument& copy );
   TiXmlDocument& operator=( const TiXmlDocument& copy );
+#ifdef TIXML_HAS_MOVE
+  /* 整棵树连同内存池、名字表、就地解析的缓冲区和行索引一起移过来，不复制任何节点。
+   * other变成空文档；正在进行的分段解析(FeedChunk())被放弃
+   */
+  TiXmlDocument( TiXmlDocument&& other );
+  TiXmlDocument& operator=( TiXmlDocument&& other );
+#endif
 
-  virtual ~TiXmlDocument() {}
+  /* 先删除所有子节点，再释放内存池。顺序不能反：~TiXmlNode()执行时内存池已经不存在了 */
+  virtual ~TiXmlDocument()
+  {
+    Clear();
+    delete incremental;
+    delete [] inSituBuffer;
+    delete arena;
+    if ( ownsNameTable )
+      delete nameTable;
+  }
 
   bool LoadFile( TiXmlEncoding encoding = TIXML_DEFAULT_ENCODING );
   bool SaveFile() const;
   bool LoadFile( const char * filename, TiXmlEncoding encoding = TIXML_DEFAULT_ENCODING );
   bool SaveFile( const char * filename ) const;
   bool LoadFile( FILE*, TiXmlEncoding encoding = TIXML_DEFAULT_ENCODING );
+  /* 先换成options中的解析选项，再按options.Encoding()加载 */
+  bool LoadFile( const char * filename, const TiXmlParseOptions& options );
   bool SaveFile( FILE* ) const;
 
+  /* 用mmap()只读映射文件后直接解析，文件内容既不拷贝也不预先遍历：
+   * 换行符在ReadText()、TiXmlLineIndex::Build()等扫描函数中顺便处理。
+   * 文件大小用size_t表示，可以加载超过2GB的文件。映射是只读的，所以这里不使用就地解析。
+   * 不支持mmap()的平台上等同于LoadFile( filename, encoding )
+   */
+  bool LoadFileMapped( const char * filename, TiXmlEncoding encoding = TIXML_DEFAULT_ENCODING );
+
+  /* 二进制快照(TiXmlSnapshot)。SaveBinary()把整棵树写成紧凑的二进制格式，
+   * LoadBinary()直接按记录重建节点，不做任何文本解析，字符串引用文档保留的缓冲区(和就地解析一样)。
+   * 快照带版本号和校验和，版本或字节序不符、内容损坏时LoadBinary()返回false，错误码是TIXML_ERROR_BINARY_FORMAT。
+   * 节点的类型、值、属性及其顺序、CDATA都原样保留；快照中没有行列号
+   */
+  bool SaveBinary( const char * filename ) const;
+  bool LoadBinary( const char * filename );
+
+  /* 把当前的内容复制成只读的TiXmlFrozenDocument，可以不加锁地给多个线程同时查询。
+   * 返回的对象由调用者delete，之后对这个文档的修改不会反映到它上面
+   */
+  TiXmlFrozenDocument* Freeze() const;
+
+  /* 把所有节点的值、属性名和属性值换成带引用计数的共享字符串(TiXmlStringRef::Share())。
+   * 之后拷贝这个文档(拷贝构造、operator=、Clone()、InsertEndChild()等)时，字符串只增加引用计数，
+   * 修改某个值时只复制这一个字符串(copy-on-write)。适合一个模板文档被拷贝很多次、每份只改少数几个值的场合；
+   * 调用之后模板可以在几个线程中同时被拷贝。名字表中的名字不变
+   */
+  void ShareStrings();
+
+  /* 分段解析：数据每收到一块就调用一次FeedChunk()，全部收完后调用Finish()。
+   * 已经完整的标记马上解析成节点，断在中间的名字、实体引用、属性值、CDATA等留到下一块再解析，
+   * 所以不需要先把整个文档收齐。encoding只在第一块时起作用。
+   * 资源限制(TiXmlParseOptions::SetMaxNodes()等)和Parse()一样检查。
+   * 出错时返回false，之后的FeedChunk()都会被忽略。错误没有行列号
+   */
+  bool FeedChunk( const char* data, size_t length, TiXmlEncoding encoding = TIXML_DEFAULT_ENCODING );
+  bool Finish();
+
   /* 将文件数据解析成树状图 */
   virtual const char* Parse( const char* p, TiXmlParsingData* data = 0, TiXmlEncoding encoding = TIXML_DEFAULT_ENCODING );
+  const char* Parse( const char* p, const TiXmlParseOptions& options );
   
   const TiXmlElement* RootElement() const { return FirstChildElement(); }
   TiXmlElement* RootElement() { return FirstChildElement(); }
@@ -28,11 +85,75 @@ public:
   const char * ErrorDesc() const { return errorDesc.c_str (); }
   int ErrorId() const       { return errorId; }
 
+  /* 出错的位置在SetError()时由TiXmlParsingData::Stamp()从头扫描得到，只有出错时才付出这个开销 */
   int ErrorRow() const { return errorLocation.row+1; }
   int ErrorCol() const { return errorLocation.col+1; }
   
-  void SetTabSize( int _tabsize ) { tabsize = _tabsize; }
-  int TabSize() const { return tabsize; }
+  /* 解析选项：合并空白、制表符宽度、是否记录行列号、编码(只在Parse( p, options )等重载中使用)。
+   * 只影响之后的解析，已经建立的节点不变
+   */
+  void SetParseOptions( const TiXmlParseOptions& _options ) { options = _options; }
+  const TiXmlParseOptions& ParseOptions() const { return options; }
+
+  /* 以下是单独设置某一个选项的简便写法 */
+  void SetTabSize( int _tabsize ) { options.SetTabSize( _tabsize ); }
+  int TabSize() const { return options.TabSize(); }
+
+  /* 是否从文档自己的内存池中分配节点和属性，默认关闭。
+   * 只能在文档没有子节点时切换，否则返回false。
+   * 开启后，从文档中摘下来的节点不能比文档活得更久，它们的内存会随文档一起释放
+   */
+  bool UseArena( bool use );
+  TiXmlArena* Arena() const { return arena; }
+
+  /* 删除所有子节点，然后整块回收内存池。从内存池分配、还没有挂到文档上的节点也一起失效。
+   * 隐藏了TiXmlNode::Clear()，通过TiXmlNode*调用时不回收内存池
+   */
+  void Clear();
+
+  /* 解析时把元素名和属性名放进名字表，默认关闭。同名的节点共享一份名字，
+   * FirstChild( name )、FirstChildElement( name )等按名字查找时指针相同就不用再比较内容。
+   * UseNameTable()使用文档自己的表；SetNameTable()使用外部的表，可以由几个文档共享，
+   * 它要比这些文档活得更久。和UseArena()一样只能在文档没有子节点时切换，否则返回false。
+   * 节点移到另一个文档时，名字不再指向原来的表
+   */
+  bool UseNameTable( bool use );
+  bool SetNameTable( TiXmlNameTable* table );
+  TiXmlNameTable* NameTable() const { return nameTable; }
+
+  /* 就地(in-situ)解析，默认关闭。开启后LoadFile()读入的缓冲区由文档保留，
+   * 节点的值、属性名和属性值都直接引用这块缓冲区，不再各自拷贝一份；实体引用的解码和空白的合并
+   * 也在缓冲区中就地完成。只有用户修改节点时才会拷贝。Parse(const char*)不受影响
+   */
+  void SetInSitu( bool use ) { inSitu = use; }
+  bool InSitu() const { return inSitu; }
+
+  void SetCondenseWhiteSpace( bool condense ) { options.SetCondenseWhiteSpace( condense ); }
+  bool IsWhiteSpaceCondensed() const { return options.IsWhiteSpaceCondensed(); }
+
+  /* 解析时根元素的内容最多分给几个线程，默认1(不并行)。
+   * 只有根元素下面有大量子节点、文档足够大(每个线程至少TiXmlParallelParser::MIN_SEGMENT字节)时才会并行，
+   * 得到的树、行列号和错误信息都和串行解析相同。需要定义TIXML_USE_THREADS，否则总是串行。
+   * 解析选项中设置了资源限制时也总是串行
+   */
+  void SetParseThreads( int threads ) { parseThreads = threads > 1 ? threads : 1; }
+  int ParseThreads() const { return parseThreads; }
+
+  /* 挂上统计对象(TiXmlParseStats)以后，LoadFile()、LoadFileMapped()、Parse()和SaveFile()把统计数据累加进去，
+   * 传0取消。统计对象由调用者所有，要比文档活得更久；拷贝文档时不会带过去。需要定义TIXML_USE_STATS
+   */
+  void SetStats( TiXmlParseStats* _stats ) { stats = _stats; }
+  TiXmlParseStats* Stats() const { return stats; }
+
+  /* [internal use] 当前是否正在就地解析 */
+  bool IsParsingInSitu() const { return parsingInSitu; }
+  /* [internal use] 解析时设置了资源限制(TiXmlParseOptions::SetMaxNodes()等)时，Identify()用它给新节点记账 */
+  TiXmlParsingData* ParsingLimits() const { return limits; }
+
+  /* 文档占用的内存(估计值)：节点和属性对象、它们自己的字符串，加上就地解析的缓冲区、自己的名字表和行索引。
+   * 引用缓冲区和名字表的字符串不重复计算；共享的字符串在每个引用它的地方各算一次
+   */
+  size_t BytesUsed() const;
 
   void ClearError()
   {
@@ -44,7 +165,18 @@ public:
 
   /** Write the document to standard out using formatted printing ("pretty print"). */
   void Print() const { Print( stdout, 0 ); }
+  /* 用TiXmlWriter格式化输出整个文档，depth没有作用 */
+  virtual void Print( FILE* cfile, int depth = 0 ) const;
+
+  /* SaveFile()的输出格式，默认缩进换行(TiXmlWriter::PRETTY) */
+  void SetWriteStyle( TiXmlWriter::Style style ) { writeStyle = style; }
+  TiXmlWriter::Style WriteStyle() const { return writeStyle; }
   
+  /* [internal use] 第generation次解析的输入中偏移offset处的行列号，从0开始。
+   * 没有行索引，或者行索引不是那次解析建立的时候是(-1, -1)
+   */
+  TiXmlCursor LocationOf( size_t offset, int generation ) const { return lineIndex.Locate( offset, generation ); }
+
   /* [internal use] */
   void SetError( int err, const char* errorLocation, TiXmlParsingData* prevData, TiXmlEncoding encoding );
   virtual bool Accept( TiXmlVisitor* content ) const;
@@ -54,17 +186,250 @@ protected:
 
 private:
   void CopyTo( TiXmlDocument* target ) const;
+#ifdef TIXML_HAS_MOVE
+  /* 移动构造和移动赋值使用。调用前自己的节点和资源都已经释放 */
+  void TakeOver( TiXmlDocument& other );
+#endif
+
+  /* 加载新文件之前，清掉旧的节点、内存池和缓冲区 */
+  void ClearForLoad();
+
+  /* 就地解析buf，解析完成后由文档保留buf。length是buf的大小 */
+  void ParseInSitu( char* buf, size_t length, TiXmlEncoding encoding );
+  /* LoadFileMapped()没有预先规范化换行符。文本和CDATA在解析时处理，
+   * 注释、声明和未知节点的内容是原样拷贝的，解析结束后在这里把"\r\n"和单独的'\r'换成'\n'
+   */
+  void NormalizeRawValues();
+  /* 就地解析结束后，处理所有引用缓冲区的字符串 */
+  void ResolveInSitu( TiXmlEncoding encoding );
+  static void ResolveInSitu( TiXmlStringRef* str, TiXmlEncoding encoding );
+#ifdef TIXML_USE_STATS
+  /* 一次解析结束后，把用时、字节数和这期间计数器的增量记进stats */
+  void RecordParse( size_t bytes, double start, const TiXmlParseStats::Counters& before );
+#endif
 
   bool error;
   int  errorId;
   TIXML_STRING errorDesc;
-  int  tabsize;
   TiXmlCursor errorLocation;
   bool useMicrosoftBOM;
+  TiXmlArena* arena;
+  TiXmlNameTable* nameTable;
+  bool  ownsNameTable;
+
+  bool  inSitu;
+  bool  parsingInSitu;
+  char* inSituBuffer;   /* 就地解析时保留的缓冲区 */
+  size_t inSituLength;
+
+  TiXmlIncrementalParser* incremental;  /* FeedChunk()和Finish()之间的解析状态 */
+  int   parseThreads;
+  TiXmlParseOptions options;
+  TiXmlWriter::Style writeStyle;
+  TiXmlLineIndex lineIndex;   /* 解析时建立，Row()、Column()由它换算 */
+  TiXmlParseStats* stats;     /* 不为0时记录统计数据 */
+  TiXmlParsingData* limits;   /* 设置了资源限制时，指向正在进行的Parse()的状态 */
 };
 
 /* 方法 */
 
+TiXmlDocument::TiXmlDocument() : TiXmlNode( TiXmlNode::TINYXML_DOCUMENT )
+{
+  useMicrosoftBOM = false;
+  arena = 0;
+  nameTable = 0;
+  ownsNameTable = false;
+  inSitu = parsingInSitu = false;
+  inSituBuffer = 0;
+  inSituLength = 0;
+  incremental = 0;
+  writeStyle = TiXmlWriter::PRETTY;
+  parseThreads = 1;
+  stats = 0;
+  limits = 0;
+  ClearError();
+}
+
+TiXmlDocument::TiXmlDocument( const char * documentName ) : TiXmlNode( TiXmlNode::TINYXML_DOCUMENT )
+{
+  useMicrosoftBOM = false;
+  arena = 0;
+  nameTable = 0;
+  ownsNameTable = false;
+  inSitu = parsingInSitu = false;
+  inSituBuffer = 0;
+  inSituLength = 0;
+  incremental = 0;
+  writeStyle = TiXmlWriter::PRETTY;
+  parseThreads = 1;
+  stats = 0;
+  limits = 0;
+  value = documentName;
+  ClearError();
+}
+
+/* 拷贝出来的节点都在堆上，新文档不继承原文档的内存池 */
+TiXmlDocument::TiXmlDocument( const TiXmlDocument& copy ) : TiXmlNode( TiXmlNode::TINYXML_DOCUMENT )
+{
+  arena = 0;
+  nameTable = 0;
+  ownsNameTable = false;
+  inSitu = parsingInSitu = false;
+  inSituBuffer = 0;
+  inSituLength = 0;
+  incremental = 0;
+  writeStyle = TiXmlWriter::PRETTY;
+  parseThreads = 1;
+  stats = 0;
+  limits = 0;
+  options = copy.options;
+  copy.CopyTo( this );
+}
+
+TiXmlDocument& TiXmlDocument::operator=( const TiXmlDocument& copy )
+{
+  if ( this != &copy )
+  {
+    /* 拷贝出来的节点没有位置，旧的行索引也用不上了 */
+    Clear();
+    lineIndex.Clear();
+    copy.CopyTo( this );
+  }
+  return *this;
+}
+
+#ifdef TIXML_HAS_MOVE
+TiXmlDocument::TiXmlDocument( TiXmlDocument&& other ) : TiXmlNode( TiXmlNode::TINYXML_DOCUMENT )
+{
+  arena = 0;
+  nameTable = 0;
+  ownsNameTable = false;
+  inSituBuffer = 0;
+  inSituLength = 0;
+  incremental = 0;
+  stats = 0;
+  limits = 0;
+  TakeOver( other );
+}
+
+/* 先像析构函数一样释放自己的节点和资源 */
+TiXmlDocument& TiXmlDocument::operator=( TiXmlDocument&& other )
+{
+  if ( this != &other )
+  {
+    ClearForLoad();
+    delete arena;
+    if ( ownsNameTable )
+      delete nameTable;
+    TakeOver( other );
+  }
+  return *this;
+}
+
+void TiXmlDocument::TakeOver( TiXmlDocument& other )
+{
+  MoveFrom( other );
+
+  error = other.error;
+  errorId = other.errorId;
+  errorDesc = other.errorDesc;
+  errorLocation = other.errorLocation;
+  useMicrosoftBOM = other.useMicrosoftBOM;
+  inSitu = other.inSitu;
+  parsingInSitu = false;
+  parseThreads = other.parseThreads;
+  options = other.options;
+  writeStyle = other.writeStyle;
+  stats = other.stats;
+
+  /* 节点从other的内存池中分配，字符串引用other的缓冲区和名字表，这些都要一起接管 */
+  arena = other.arena;
+  nameTable = other.nameTable;
+  ownsNameTable = other.ownsNameTable;
+  inSituBuffer = other.inSituBuffer;
+  inSituLength = other.inSituLength;
+  lineIndex.TakeOver( other.lineIndex );
+  other.arena = 0;
+  other.nameTable = 0;
+  other.ownsNameTable = false;
+  other.inSituBuffer = 0;
+  other.ClearError();
+
+  /* 分段解析的状态里记着other和当前节点，不能移过来 */
+  delete other.incremental;
+  other.incremental = 0;
+  incremental = 0;
+
+  /* 属性通过document报告位置，改成指向自己 */
+  TiXmlNode* node = firstChild;
+  while ( node )
+  {
+    if ( TiXmlElement* element = node->ToElement() )
+    {
+      for ( TiXmlAttribute* attrib = element->FirstAttribute(); attrib; attrib = attrib->Next() )
+      {
+        if ( attrib->document == &other )
+          attrib->document = this;
+      }
+    }
+    if ( node->firstChild )
+    {
+      node = node->firstChild;
+      continue;
+    }
+    while ( node != this && !node->next )
+      node = node->parent;
+    node = ( node != this ) ? node->next : 0;
+  }
+}
+#endif
+
+bool TiXmlDocument::UseArena( bool use )
+{
+  if ( !NoChildren() )
+    return false;
+
+  if ( use && !arena )
+  {
+    arena = new TiXmlArena();
+  }
+  else if ( !use && arena )
+  {
+    delete arena;
+    arena = 0;
+  }
+  return true;
+}
+
+bool TiXmlDocument::UseNameTable( bool use )
+{
+  if ( !NoChildren() )
+    return false;
+
+  if ( use && !( nameTable && ownsNameTable ) )
+  {
+    SetNameTable( new TiXmlNameTable() );
+    ownsNameTable = true;
+  }
+  else if ( !use )
+  {
+    SetNameTable( 0 );
+  }
+  return true;
+}
+
+bool TiXmlDocument::SetNameTable( TiXmlNameTable* table )
+{
+  if ( !NoChildren() )
+    return false;
+
+  if ( ownsNameTable && table != nameTable )
+    delete nameTable;
+  nameTable = table;
+  ownsNameTable = false;
+  return true;
+}
+
 /* 从文件中使用fread()函数一次性读取全部内容，依次遍历，将其中的'\r'或'\r\n'转换为'\n'
  * 并用Parse()函数解析出内容
  */
@@ -76,16 +441,22 @@ bool TiXmlDocument::LoadFile( FILE* file, TiXmlEncoding encoding )
     return false;
   }     
 
-  Clear();
-  location.Clear();
+  ClearForLoad();
 
-  /* 获取文件大小，便于一次性分配足够空间存储 */
-  long length = 0;
-  fseek( file, 0, SEEK_END );
-  length = ftell( file );
+#ifdef TIXML_USE_STATS
+  const double ioStart = stats ? TiXmlParseStats::Now() : 0;
+#endif
+
+  /* 获取文件大小，便于一次性分配足够空间存储。用size_t，超过2GB的文件也能加载 */
+  size_t length = 0;
+  if ( !TiXmlFileMapping::FileSize( file, &length ) )
+  {
+    SetError( TIXML_ERROR_OPENING_FILE, 0, 0, TIXML_ENCODING_UNKNOWN );
+    return false;
+  }
   fseek( file, 0, SEEK_SET );
 
-  if (length <= 0 )
+  if ( length == 0 )
   {
     SetError( TIXML_ERROR_DOCUMENT_EMPTY, 0, 0, TIXML_ENCODING_UNKNOWN );
     return false;
@@ -108,39 +479,442 @@ bool TiXmlDocument::LoadFile( FILE* file, TiXmlEncoding encoding )
     return false;
   }
 
-  const char* p = buf;  // the read head
-  char* q = buf;      // the write head
-  const char CR = 0x0d;
-  const char LF = 0x0a;
+#ifdef TIXML_USE_STATS
+  const double normalizeStart = stats ? TiXmlParseStats::Now() : 0;
+  if ( stats )
+  {
+    stats->ioSeconds += normalizeStart - ioStart;
+    stats->bytesRead += length;
+  }
+#endif
 
+  /* 把'\r'和"\r\n"都换成'\n'，大块没有'\r'的内容用SIMD一次跳过 */
   buf[length] = 0;
-  while( *p ) 
+  char* q = TiXmlScanner::NormalizeNewlines( buf, length );
+  assert( q <= (buf+length) );
+  *q = 0;
+
+#ifdef TIXML_USE_STATS
+  if ( stats )
+    stats->normalizeSeconds += TiXmlParseStats::Now() - normalizeStart;
+#endif
+
+  if ( inSitu )
   {
-    assert( p < (buf+length) );
-    assert( q <= (buf+length) );
-    assert( q <= p );
+    ParseInSitu( buf, length + 1, encoding );
+    return !Error();
+  }
+
+  Parse( buf, 0, encoding );
+
+  delete [] buf;
+  return !Error();
+}
 
-    if ( *p == CR ) 
+bool TiXmlDocument::LoadFile( const char* filename, const TiXmlParseOptions& _options )
+{
+  options = _options;
+  return LoadFile( filename, options.Encoding() );
+}
+
+const char* TiXmlDocument::Parse( const char* p, const TiXmlParseOptions& _options )
+{
+  options = _options;
+  return Parse( p, 0, options.Encoding() );
+}
+
+bool TiXmlDocument::SaveFile() const
+{
+  return SaveFile( Value() );
+}
+
+bool TiXmlDocument::SaveFile( const char* filename ) const
+{
+  FILE* fp = TiXmlFOpen( filename, "w" );
+  if ( !fp )
+    return false;
+  bool result = SaveFile( fp );
+  fclose( fp );
+  return result;
+}
+
+TiXmlFrozenDocument* TiXmlDocument::Freeze() const
+{
+  return new TiXmlFrozenDocument( *this );
+}
+
+bool TiXmlDocument::SaveBinary( const char* filename ) const
+{
+  FILE* fp = TiXmlFOpen( filename, "wb" );
+  if ( !fp )
+    return false;
+  bool result = TiXmlSnapshot::Write( *this, fp ) == TIXML_NO_ERROR;
+  if ( fclose( fp ) != 0 )
+    result = false;
+  return result;
+}
+
+bool TiXmlDocument::LoadBinary( const char* filename )
+{
+  value = filename;
+
+  FILE* fp = TiXmlFOpen( filename, "rb" );
+  if ( !fp )
+  {
+    SetError( TIXML_ERROR_OPENING_FILE, 0, 0, TIXML_ENCODING_UNKNOWN );
+    return false;
+  }
+
+  ClearForLoad();
+  ClearError();
+
+  size_t length = 0;
+  if ( !TiXmlFileMapping::FileSize( fp, &length ) || length == 0 )
+  {
+    fclose( fp );
+    SetError( length ? TIXML_ERROR_OPENING_FILE : TIXML_ERROR_DOCUMENT_EMPTY, 0, 0, TIXML_ENCODING_UNKNOWN );
+    return false;
+  }
+
+  /* new出来的内存满足最严格的对齐，快照中的记录可以直接按结构访问 */
+  char* buf = new char[ length ];
+  bool ok = fread( buf, length, 1, fp ) == 1;
+  fclose( fp );
+  if ( !ok )
+  {
+    delete [] buf;
+    SetError( TIXML_ERROR_OPENING_FILE, 0, 0, TIXML_ENCODING_UNKNOWN );
+    return false;
+  }
+
+  inSituBuffer = buf;
+  inSituLength = length;
+  int err = TiXmlSnapshot::Read( this, buf, length );
+  if ( err != TIXML_NO_ERROR )
+  {
+    ClearForLoad();
+    SetError( err, 0, 0, TIXML_ENCODING_UNKNOWN );
+    return false;
+  }
+  return true;
+}
+
+/* 整个文档写进TiXmlWriter的缓冲区，每满64KB调用一次fwrite()，不再逐个节点fprintf() */
+bool TiXmlDocument::SaveFile( FILE* fp ) const
+{
+#ifdef TIXML_USE_STATS
+  const double saveStart = stats ? TiXmlParseStats::Now() : 0;
+#endif
+  TiXmlFileSink sink( fp );
+  TiXmlWriter writer( writeStyle );
+  writer.SetSink( &sink );
+
+  if ( useMicrosoftBOM )
+  {
+    const char bom[] = { (char)TIXML_UTF_LEAD_0, (char)TIXML_UTF_LEAD_1, (char)TIXML_UTF_LEAD_2 };
+    writer.WriteRaw( bom, 3 );
+  }
+  writer.Write( *this );
+  const bool ok = writer.Flush() && ferror( fp ) == 0;
+
+#ifdef TIXML_USE_STATS
+  if ( stats )
+  {
+    stats->saveSeconds += TiXmlParseStats::Now() - saveStart;
+    ++stats->saves;
+  }
+#endif
+  return ok;
+}
+
+void TiXmlDocument::Print( FILE* cfile, int /*depth*/ ) const
+{
+  assert( cfile );
+  TiXmlFileSink sink( cfile );
+  TiXmlWriter writer( TiXmlWriter::PRETTY );
+  writer.SetSink( &sink );
+  writer.Write( *this );
+  writer.Flush();
+}
+
+void TiXmlDocument::Clear()
+{
+  TiXmlNode::Clear();
+  /* 旧的节点都已经析构，内存池可以整块回收了 */
+  if ( arena )
+    arena->Reset();
+}
+
+void TiXmlDocument::ClearForLoad()
+{
+  Clear();
+  lineIndex.Clear();
+  delete [] inSituBuffer;
+  inSituBuffer = 0;
+  inSituLength = 0;
+  delete incremental;
+  incremental = 0;
+}
+
+bool TiXmlDocument::FeedChunk( const char* data, size_t length, TiXmlEncoding encoding )
+{
+  if ( !incremental )
+  {
+    ClearForLoad();
+    ClearError();
+    incremental = new TiXmlIncrementalParser( this, encoding );
+  }
+  return incremental->Feed( data, length );
+}
+
+bool TiXmlDocument::Finish()
+{
+  if ( !incremental )
+  {
+    SetError( TIXML_ERROR_DOCUMENT_EMPTY, 0, 0, TIXML_ENCODING_UNKNOWN );
+    return false;
+  }
+  bool ok = incremental->Finish();
+  delete incremental;
+  incremental = 0;
+  return ok;
+}
+
+bool TiXmlDocument::LoadFileMapped( const char* filename, TiXmlEncoding encoding )
+{
+  if ( !TiXmlFileMapping::Supported() )
+    return LoadFile( filename, encoding );
+
+  value = filename;
+
+  /* 和LoadFile()一样，打开失败时也不保留旧的内容 */
+  ClearForLoad();
+
+#ifdef TIXML_USE_STATS
+  const double ioStart = stats ? TiXmlParseStats::Now() : 0;
+#endif
+  TiXmlFileMapping mapping;
+  int err = mapping.Open( filename );
+  if ( err != TIXML_NO_ERROR )
+  {
+    SetError( err, 0, 0, TIXML_ENCODING_UNKNOWN );
+    return false;
+  }
+
+#ifdef TIXML_USE_STATS
+  /* 页面在解析时才真正读进来，这里只是建立映射的开销 */
+  if ( stats )
+  {
+    stats->ioSeconds += TiXmlParseStats::Now() - ioStart;
+    stats->bytesRead += mapping.Length();
+  }
+#endif
+
+  Parse( mapping.Data(), 0, encoding );
+  NormalizeRawValues();
+
+  /* 映射在这里解除，节点中的字符串都是拷贝出来的 */
+  return !Error();
+}
+
+/* 按先序走，和ShareStrings()一样不用递归。只有含'\r'的值才重新赋值 */
+void TiXmlDocument::NormalizeRawValues()
+{
+  TiXmlNode* node = firstChild;
+  while ( node )
+  {
+    const int type = node->Type();
+    if ( type == TINYXML_COMMENT || type == TINYXML_UNKNOWN || type == TINYXML_DECLARATION )
     {
-      *q++ = LF;
-      p++;
-      if ( *p == LF ) 
+      const size_t length = node->value.length();
+      if ( length && memchr( node->value.c_str(), '\r', length ) )
       {
-        p++;
+        char* buf = new char[ length + 1 ];
+        memcpy( buf, node->value.c_str(), length );
+        buf[length] = 0;
+        char* end = TiXmlScanner::NormalizeNewlines( buf, length );
+        node->value.Assign( buf, end - buf );
+        delete [] buf;
       }
     }
-    else 
+
+    if ( node->firstChild )
     {
-      *q++ = *p++;
+      node = node->firstChild;
+      continue;
     }
+    while ( node != this && !node->next )
+      node = node->parent;
+    node = ( node != this ) ? node->next : 0;
   }
-  assert( q <= (buf+length) );
-  *q = 0;
+}
 
+void TiXmlDocument::ParseInSitu( char* buf, size_t length, TiXmlEncoding encoding )
+{
+  inSituBuffer = buf;
+  inSituLength = length;
+
+  parsingInSitu = true;
   Parse( buf, 0, encoding );
+  parsingInSitu = false;
 
-  delete [] buf;
-  return !Error();
+  /* 文档开头的声明可能改变了编码，以它为准来解码实体引用 */
+  const TiXmlNode* first = FirstChild();
+  if ( encoding == TIXML_ENCODING_UNKNOWN && first && first->ToDeclaration() )
+  {
+    const char* enc = first->ToDeclaration()->Encoding();
+    if ( *enc == 0 || StringEqual( enc, "UTF-8", true, TIXML_ENCODING_UNKNOWN ) || StringEqual( enc, "UTF8", true, TIXML_ENCODING_UNKNOWN ) )
+      encoding = TIXML_ENCODING_UTF8;
+    else
+      encoding = TIXML_ENCODING_LEGACY;
+  }
+
+#ifdef TIXML_USE_STATS
+  const double resolveStart = stats ? TiXmlParseStats::Now() : 0;
+  const TiXmlParseStats::Counters before = TiXmlParseStats::counters;
+#endif
+
+  /* 出错时已经建立的节点也要处理，保证它们的c_str()都是以'\0'结尾的 */
+  ResolveInSitu( encoding );
+
+#ifdef TIXML_USE_STATS
+  /* 实体引用在这里才真正解码，算在解析里 */
+  if ( stats )
+  {
+    stats->parseSeconds += TiXmlParseStats::Now() - resolveStart;
+    stats->entities += TiXmlParseStats::counters.entities - before.entities;
+  }
+#endif
+}
+
+void TiXmlDocument::ShareStrings()
+{
+  TiXmlNode* node = firstChild;
+  while ( node )
+  {
+    node->value.Share();
+
+    TiXmlElement* element = node->ToElement();
+    if ( element )
+    {
+      for ( TiXmlAttribute* attrib = element->FirstAttribute(); attrib; attrib = attrib->Next() )
+      {
+        attrib->name.Share();
+        attrib->value.Share();
+      }
+    }
+
+    if ( node->firstChild )
+    {
+      node = node->firstChild;
+      continue;
+    }
+    while ( node != this && !node->next )
+      node = node->parent;
+    node = ( node != this ) ? node->next : 0;
+  }
+}
+
+/* 节点和属性按对象大小计算，和解析时的资源限制(TiXmlParsingData)用同一种算法 */
+size_t TiXmlDocument::BytesUsed() const
+{
+  size_t bytes = sizeof( TiXmlDocument ) + value.HeapBytes() + lineIndex.BytesUsed();
+  if ( inSituBuffer )
+    bytes += inSituLength;
+  if ( nameTable && ownsNameTable )
+    bytes += nameTable->BytesUsed();
+
+  const TiXmlNode* node = firstChild;
+  while ( node )
+  {
+    bytes += node->SizeOf() + node->value.HeapBytes();
+
+    const TiXmlElement* element = node->ToElement();
+    if ( element )
+    {
+      for ( const TiXmlAttribute* attrib = element->FirstAttribute(); attrib; attrib = attrib->Next() )
+        bytes += sizeof( TiXmlAttribute ) + attrib->name.HeapBytes() + attrib->value.HeapBytes();
+    }
+
+    if ( node->firstChild )
+    {
+      node = node->firstChild;
+      continue;
+    }
+    while ( node != this && !node->next )
+      node = node->parent;
+    node = ( node != this ) ? node->next : 0;
+  }
+  return bytes;
+}
+
+TiXmlNode* TiXmlDocument::Clone() const
+{
+  TiXmlDocument* clone = new TiXmlDocument();
+  CopyTo( clone );
+  return clone;
+}
+
+void TiXmlDocument::CopyTo( TiXmlDocument* target ) const
+{
+  TiXmlNode::CopyTo( target );
+
+  target->error = error;
+  target->errorId = errorId;
+  target->errorDesc = errorDesc;
+  target->errorLocation = errorLocation;
+  target->useMicrosoftBOM = useMicrosoftBOM;
+  target->options = options;
+  target->writeStyle = writeStyle;
+
+  for ( const TiXmlNode* node = firstChild; node; node = node->NextSibling() )
+    target->LinkEndChild( node->Clone() );
+}
+
+/* 按文档顺序(先序)遍历所有节点。解析时只记下了每个字符串在缓冲区中的范围，
+ * 这时整个文档已经解析完，可以放心地修改缓冲区：就地解码、合并空白，并在末尾补'\0'
+ */
+void TiXmlDocument::ResolveInSitu( TiXmlEncoding encoding )
+{
+  TiXmlNode* node = firstChild;
+  while ( node )
+  {
+    ResolveInSitu( &node->value, encoding );
+
+    TiXmlElement* element = node->ToElement();
+    if ( element )
+    {
+      for ( TiXmlAttribute* attrib = element->FirstAttribute(); attrib; attrib = attrib->Next() )
+      {
+        ResolveInSitu( &attrib->name, encoding );
+        ResolveInSitu( &attrib->value, encoding );
+      }
+    }
+
+    if ( node->firstChild )
+    {
+      node = node->firstChild;
+      continue;
+    }
+    while ( node != this && !node->next )
+      node = node->parent;
+    node = ( node != this ) ? node->next : 0;
+  }
+}
+
+void TiXmlDocument::ResolveInSitu( TiXmlStringRef* str, TiXmlEncoding encoding )
+{
+  if ( !str->IsReference() )
+    return;
+
+  char* p = const_cast< char* >( str->c_str() );
+  size_t length = str->length();
+  if ( str->PendingWork() != TiXmlStringRef::TIXML_PENDING_NONE )
+    length = DecodeInSitu( p, length, str->PendingWork() == TiXmlStringRef::TIXML_PENDING_CONDENSE, encoding );
+
+  /* 结尾处原来是分隔符('<'、'>'、引号等)，解析结束后已经没用了 */
+  p[length] = 0;
+  str->Refer( p, length );
 }
 
 /* 将所有内容连接成树状图 */
@@ -154,19 +928,22 @@ const char* TiXmlDocument::Parse( const char* p, TiXmlParsingData* prevData, TiX
     return 0;
   }
 
-  location.Clear();
-  if ( prevData )
-  {
-    location.row = prevData->cursor.row;
-    location.col = prevData->cursor.col;
-  }
-  else 
-  {
-    location.row = 0; 
-    location.col = 0; 
-  }
-  TiXmlParsingData data( p, TabSize(), location.row, location.col );
-  location = data.Cursor();
+#ifdef TIXML_USE_STATS
+  const double parseStart = stats ? TiXmlParseStats::Now() : 0;
+  const TiXmlParseStats::Counters before = TiXmlParseStats::Begin();
+#endif
+
+  /* 节点只记下相对于pStart的偏移，行列号在解析结束后由行索引换算 */
+  const char* const pStart = p;
+  int row = prevData ? prevData->cursor.row : 0;
+  int col = prevData ? prevData->cursor.col : 0;
+  TiXmlParsingData data( p, options, row, col );
+  location = 0;
+  generation = data.Generation();
+  lineIndex.Clear();
+  /* 直接调用Parse()而不是LoadFile()时，上一次留下的内存池在这里回收 */
+  if ( !firstChild && arena )
+    arena->Reset();
   
   p = SkipWhiteSpace( p, encoding );
   if ( !p )
@@ -174,7 +951,8 @@ const char* TiXmlDocument::Parse( const char* p, TiXmlParsingData* prevData, TiX
     SetError( TIXML_ERROR_DOCUMENT_EMPTY, 0, 0, TIXML_ENCODING_UNKNOWN );
     return 0;
   } 
-  
+
+  limits = data.Limited() ? &data : 0;
   while ( p && *p )
   { 
     /* 这块是形成树状图的关键位置 */
@@ -207,12 +985,38 @@ const char* TiXmlDocument::Parse( const char* p, TiXmlParsingData* prevData, TiX
     }
     p = SkipWhiteSpace( p, encoding );
   }
+  limits = 0;
+
+  /* 超过资源限制时Identify()返回0，循环停在那里，错误已经设置好了 */
+  if ( error && errorId >= TIXML_ERROR_MEMORY_LIMIT && errorId <= TIXML_ERROR_STRING_LIMIT )
+    return 0;
 
   if ( !firstChild ) {
     SetError( TIXML_ERROR_DOCUMENT_EMPTY, 0, 0, encoding );
     return 0;
   }
 
+  /* 打开了TrackLocation()时只扫描一遍换行符，比解析时逐个节点Stamp()便宜得多。
+   * 所有节点都在p之前，不需要再找输入的结尾。出错时的行列号已经在SetError()中算好了
+   */
+  if ( p && options.TrackLocation() )
+    lineIndex.Build( pStart, p, options, encoding, row, col, data.Generation() );
+
+#ifdef TIXML_USE_STATS
+  if ( stats )
+    RecordParse( p ? p - pStart : strlen( pStart ), parseStart, before );
+#endif
   return p;
 }
+
+#ifdef TIXML_USE_STATS
+void TiXmlDocument::RecordParse( size_t bytes, double start, const TiXmlParseStats::Counters& before )
+{
+  stats->parseSeconds += TiXmlParseStats::Now() - start;
+  stats->bytesParsed += bytes;
+  ++stats->parses;
+  ++stats->nodes[ TINYXML_DOCUMENT ];
+  stats->Add( TiXmlParseStats::Since( before ) );
+}
+#endif
     
@@ -0,0 +1,383 @@
+/* 类 */
+
+/* 元素节点，例如<school name="syu">...</school>。value中存放的是元素名，属性放在attributeSet中 */
+class TiXmlElement : public TiXmlNode
+{
+  friend class TiXmlNode;
+  friend class TiXmlParallelParser;
+  friend class TiXmlSnapshot;
+  friend class TiXmlQueryIterator;
+public:
+  /* 构造函数 */
+  TiXmlElement( const char * in_value );
+  TiXmlElement( const TiXmlElement& );
+  TiXmlElement& operator=( const TiXmlElement& base );
+#ifdef TIXML_HAS_MOVE
+  /* 接管other的名字、属性和子节点，other变成没有名字的空元素 */
+  TiXmlElement( TiXmlElement&& other );
+  TiXmlElement& operator=( TiXmlElement&& other );
+#endif
+
+  virtual ~TiXmlElement();
+
+  /* 根据属性名获取属性值，没有这个属性时返回0 */
+  const char* Attribute( const char* name ) const;
+  const char* Attribute( const char* name, int* i ) const;
+  const char* Attribute( const char* name, double* d ) const;
+
+  /* 与TiXmlAttribute::QueryIntValue()一样，成功返回TIXML_SUCCESS，
+   * 类型不对返回TIXML_WRONG_TYPE，没有这个属性返回TIXML_NO_ATTRIBUTE
+   */
+  int QueryIntAttribute( const char* name, int* _value ) const;
+  int QueryDoubleAttribute( const char* name, double* _value ) const;
+  /* 类型化的版本，转换规则和mode见TiXmlAttribute::QueryInt64Value()等 */
+  int QueryInt64Attribute( const char* name, long long* _value, TiXmlConvert::Mode mode = TiXmlConvert::STRICT ) const;
+  int QueryUint64Attribute( const char* name, unsigned long long* _value, TiXmlConvert::Mode mode = TiXmlConvert::STRICT ) const;
+  int QueryFloatAttribute( const char* name, float* _value, TiXmlConvert::Mode mode = TiXmlConvert::STRICT ) const;
+  int QueryBoolAttribute( const char* name, bool* _value, TiXmlConvert::Mode mode = TiXmlConvert::STRICT ) const;
+  int QueryEnumAttribute( const char* name, int* _value, const char* const* tokens, int count,
+                          TiXmlConvert::Mode mode = TiXmlConvert::STRICT ) const;
+
+  /* 设置属性，属性不存在时新建一个 */
+  void SetAttribute( const char* name, const char * _value );
+#if defined( TIXML_HAS_MOVE ) && defined( TIXML_USE_STL )
+  void SetAttribute( const char* name, std::string&& _value ) { attributeSet.FindOrCreate( name )->SetValue( std::move( _value ) ); }
+#endif
+  void SetAttribute( const char * name, int value );
+  void SetDoubleAttribute( const char * name, double value );
+  void SetInt64Attribute( const char * name, long long value )            { attributeSet.FindOrCreate( name )->SetInt64Value( value ); }
+  void SetUint64Attribute( const char * name, unsigned long long value )  { attributeSet.FindOrCreate( name )->SetUint64Value( value ); }
+  void SetBoolAttribute( const char * name, bool value )                  { attributeSet.FindOrCreate( name )->SetBoolValue( value ); }
+
+  /* 删除属性 */
+  void RemoveAttribute( const char * name );
+
+  /* 遍历属性：for( attrib = element->FirstAttribute(); attrib; attrib = attrib->Next() ) */
+  const TiXmlAttribute* FirstAttribute() const  { return attributeSet.First(); }
+  TiXmlAttribute* FirstAttribute()              { return attributeSet.First(); }
+  const TiXmlAttribute* LastAttribute() const   { return attributeSet.Last(); }
+  TiXmlAttribute* LastAttribute()               { return attributeSet.Last(); }
+
+  /* 获取第一个孩子节点的文本。第一个孩子节点不是TiXmlText时返回0 */
+  const char* GetText() const;
+
+  virtual TiXmlNode* Clone() const;
+  virtual void Print( FILE* cfile, int depth ) const;
+
+  /* 解析<...>开始的元素，包括属性、内容和结束标签 */
+  virtual const char* Parse( const char* p, TiXmlParsingData* data, TiXmlEncoding encoding );
+
+  virtual const TiXmlElement* ToElement() const { return this; }
+  virtual TiXmlElement*       ToElement()       { return this; }
+
+  virtual bool Accept( TiXmlVisitor* visitor ) const;
+
+protected:
+  void CopyTo( TiXmlElement* target ) const;
+  void ClearThis(); /* 和Clear()一样，只是多清除了属性 */
+
+#ifdef TIXML_HAS_MOVE
+  virtual TiXmlNode* MoveOut();
+  /* 把other的属性逐个摘下来挂到自己身上，属性对象本身不复制 */
+  void TakeAttributes( TiXmlElement& other );
+  /* 见TiXmlNode::Localize()。内存池中的属性换成堆上的拷贝，名字见LocalizeName()，值拷贝成自己的，顺序不变 */
+  void LocalizeAttributes( TiXmlNameTable* names );
+#endif
+
+  /* 读取元素的内容：文本、CDATA以及子元素，直到遇到结束标签</... */
+  const char* ReadValue( const char* in, TiXmlParsingData* prevData, TiXmlEncoding encoding );
+
+private:
+  TiXmlAttributeSet attributeSet;
+};
+
+/* 方法 */
+
+const char* TiXmlElement::Parse( const char* p, TiXmlParsingData* data, TiXmlEncoding encoding )
+{
+  p = SkipWhiteSpace( p, encoding );
+  TiXmlDocument* document = GetDocument();
+
+  if ( !p || !*p )
+  {
+    if ( document ) document->SetError( TIXML_ERROR_PARSING_ELEMENT, 0, 0, encoding );
+    return 0;
+  }
+
+  if ( data )
+  {
+    location = data->Offset( p );
+    generation = data->Generation();
+  }
+
+  if ( *p != '<' )
+  {
+    if ( document ) document->SetError( TIXML_ERROR_PARSING_ELEMENT, p, data, encoding );
+    return 0;
+  }
+
+  p = SkipWhiteSpace( p+1, encoding );
+
+  /* 读取元素名 */
+  const char* pErr = p;
+
+  /* 就地解析时元素名只引用文档的缓冲区 */
+  p = ReadName( p, &value, document && document->IsParsingInSitu(), document ? document->NameTable() : 0, encoding );
+  if ( !p || !*p )
+  {
+    if ( document ) document->SetError( TIXML_ERROR_FAILED_TO_READ_ELEMENT_NAME, pErr, data, encoding );
+    return 0;
+  }
+
+  /* 资源限制。元素本身已经在Identify()中记过账 */
+  const bool limited = data && data->Limited();
+  int attributeCount = 0;
+  if ( limited && !CheckLimit( data->AddString( value.length(), value.HeapBytes() ), pErr, data, encoding ) )
+    return 0;
+
+  TIXML_STRING endTag ("</");
+  endTag.append( value.c_str(), value.length() );
+
+  /* 读取属性，直到遇到空标签"/>"或者开始标签的结束">" */
+  while ( p && *p )
+  {
+    pErr = p;
+    p = SkipWhiteSpace( p, encoding );
+    if ( !p || !*p )
+    {
+      if ( document ) document->SetError( TIXML_ERROR_READING_ATTRIBUTES, pErr, data, encoding );
+      return 0;
+    }
+    if ( *p == '/' )
+    {
+      ++p;
+      /* 空标签 */
+      if ( *p  != '>' )
+      {
+        if ( document ) document->SetError( TIXML_ERROR_PARSING_EMPTY, p, data, encoding );
+        return 0;
+      }
+      return (p+1);
+    }
+    else if ( *p == '>' )
+    {
+      /* 属性读完了，接着读取内容(其中可能包含子元素)，最后读取结束标签 */
+      ++p;
+#ifdef TIXML_USE_STATS
+      ++TiXmlParseStats::counters.depth;
+#endif
+      /* 根元素的内容可以分成几段并行解析，见TiXmlParallelParser */
+      if ( document && data && parent == document && document->ParseThreads() > 1 && !limited )
+      {
+        TiXmlParallelParser parallel( document, this, encoding );
+        p = parallel.ReadValue( p, data );
+      }
+      else
+      {
+        if ( limited )
+          data->EnterElement();
+        p = ReadValue( p, data, encoding );
+        if ( limited )
+          data->LeaveElement();
+      }
+#ifdef TIXML_USE_STATS
+      --TiXmlParseStats::counters.depth;
+#endif
+      if ( !p || !*p ) {
+        if ( document ) document->SetError( TIXML_ERROR_READING_END_TAG, p, data, encoding );
+        return 0;
+      }
+
+      /* </foo >和</foo>都是合法的结束标签 */
+      if ( StringEqual( p, endTag.c_str(), false, encoding ) )
+      {
+        p += endTag.length();
+        p = SkipWhiteSpace( p, encoding );
+        if ( p && *p && *p == '>' ) {
+          ++p;
+          return p;
+        }
+        if ( document ) document->SetError( TIXML_ERROR_READING_END_TAG, p, data, encoding );
+        return 0;
+      }
+      else
+      {
+        if ( document ) document->SetError( TIXML_ERROR_READING_END_TAG, p, data, encoding );
+        return 0;
+      }
+    }
+    else
+    {
+      /* 属性个数超过限制时，在分配之前就停下 */
+      if ( limited && !CheckLimit( data->AddAttribute( ++attributeCount, sizeof( TiXmlAttribute ) ), p, data, encoding ) )
+        return 0;
+
+      /* 读取一个属性。文档开启了内存池时，属性和节点一样从内存池中分配 */
+      TiXmlAttribute* attrib = new( document ? document->Arena() : 0 ) TiXmlAttribute();
+      if ( !attrib )
+      {
+        return 0;
+      }
+
+      attrib->SetDocument( document );
+      pErr = p;
+      p = attrib->Parse( p, data, encoding );
+
+      if ( !p || !*p )
+      {
+        if ( document ) document->SetError( TIXML_ERROR_PARSING_ELEMENT, pErr, data, encoding );
+        delete attrib;
+        return 0;
+      }
+
+      /* 同名的属性出现了两次 */
+      TiXmlAttribute* node = attributeSet.Find( attrib->NameRef() );
+      if ( node )
+      {
+        if ( document ) document->SetError( TIXML_ERROR_PARSING_ELEMENT, pErr, data, encoding );
+        delete attrib;
+        return 0;
+      }
+
+      if ( limited )
+      {
+        const TiXmlStringRef& attribName = attrib->NameRef();
+        const TiXmlStringRef& attribValue = attrib->value;
+        if ( !CheckLimit( data->AddString( attribName.length(), attribName.HeapBytes() ), pErr, data, encoding )
+          || !CheckLimit( data->AddString( attribValue.length(), attribValue.HeapBytes() ), pErr, data, encoding ) )
+        {
+          delete attrib;
+          return 0;
+        }
+      }
+
+      attributeSet.Add( attrib );
+#ifdef TIXML_USE_STATS
+      ++TiXmlParseStats::counters.attributes;
+#endif
+    }
+  }
+  return p;
+}
+
+int TiXmlElement::QueryInt64Attribute( const char* name, long long* ival, TiXmlConvert::Mode mode ) const
+{
+  const TiXmlAttribute* attrib = attributeSet.Find( name );
+  return attrib ? attrib->QueryInt64Value( ival, mode ) : TIXML_NO_ATTRIBUTE;
+}
+
+int TiXmlElement::QueryUint64Attribute( const char* name, unsigned long long* uval, TiXmlConvert::Mode mode ) const
+{
+  const TiXmlAttribute* attrib = attributeSet.Find( name );
+  return attrib ? attrib->QueryUint64Value( uval, mode ) : TIXML_NO_ATTRIBUTE;
+}
+
+int TiXmlElement::QueryFloatAttribute( const char* name, float* fval, TiXmlConvert::Mode mode ) const
+{
+  const TiXmlAttribute* attrib = attributeSet.Find( name );
+  return attrib ? attrib->QueryFloatValue( fval, mode ) : TIXML_NO_ATTRIBUTE;
+}
+
+int TiXmlElement::QueryBoolAttribute( const char* name, bool* bval, TiXmlConvert::Mode mode ) const
+{
+  const TiXmlAttribute* attrib = attributeSet.Find( name );
+  return attrib ? attrib->QueryBoolValue( bval, mode ) : TIXML_NO_ATTRIBUTE;
+}
+
+int TiXmlElement::QueryEnumAttribute( const char* name, int* ival, const char* const* tokens, int count, TiXmlConvert::Mode mode ) const
+{
+  const TiXmlAttribute* attrib = attributeSet.Find( name );
+  return attrib ? attrib->QueryEnumValue( ival, tokens, count, mode ) : TIXML_NO_ATTRIBUTE;
+}
+
+TiXmlNode* TiXmlElement::Clone() const
+{
+  /* 名字由CopyTo()拷贝，共享的名字不需要先复制一份 */
+  TiXmlElement* clone = new TiXmlElement( "" );
+  CopyTo( clone );
+  return clone;
+}
+
+void TiXmlElement::CopyTo( TiXmlElement* target ) const
+{
+  TiXmlNode::CopyTo( target );
+
+  /* 直接拷贝TiXmlStringRef，不经过SetAttribute()，共享的名字和值不复制内容 */
+  for ( const TiXmlAttribute* attribute = attributeSet.First(); attribute; attribute = attribute->Next() )
+  {
+    TiXmlAttribute* copy = new TiXmlAttribute();
+    copy->name = attribute->name;
+    copy->value = attribute->value;
+    target->attributeSet.Add( copy );
+  }
+
+  for ( const TiXmlNode* node = firstChild; node; node = node->NextSibling() )
+    target->LinkEndChild( node->Clone() );
+}
+
+#ifdef TIXML_HAS_MOVE
+TiXmlElement::TiXmlElement( TiXmlElement&& other ) : TiXmlNode( TiXmlNode::TINYXML_ELEMENT )
+{
+  const TiXmlDocument* from = other.GetDocument();
+  MoveFrom( other );
+  TakeAttributes( other );
+  Localize( from );
+}
+
+TiXmlElement& TiXmlElement::operator=( TiXmlElement&& other )
+{
+  if ( this != &other )
+  {
+    const TiXmlDocument* from = other.GetDocument();
+    ClearThis();
+    MoveFrom( other );
+    TakeAttributes( other );
+    Localize( from );
+  }
+  return *this;
+}
+
+/* 和拷贝出来的属性一样，移过来的属性不再指向原来的文档 */
+void TiXmlElement::TakeAttributes( TiXmlElement& other )
+{
+  while ( TiXmlAttribute* attribute = other.attributeSet.First() )
+  {
+    other.attributeSet.Remove( attribute );
+    attribute->document = 0;
+    attributeSet.Add( attribute );
+  }
+}
+
+TiXmlNode* TiXmlElement::MoveOut()
+{
+  TiXmlElement* node = new TiXmlElement( "" );
+  node->MoveFrom( *this );
+  node->TakeAttributes( *this );
+  return node;
+}
+
+void TiXmlElement::LocalizeAttributes( TiXmlNameTable* names )
+{
+  int count = 0;
+  for ( const TiXmlAttribute* attribute = attributeSet.First(); attribute; attribute = attribute->Next() )
+    ++count;
+
+  /* 从头摘下来再挂到末尾，走完一圈顺序和原来一样 */
+  for ( int i = 0; i < count; ++i )
+  {
+    TiXmlAttribute* attribute = attributeSet.First();
+    attributeSet.Remove( attribute );
+    if ( attribute->InArena() )
+    {
+      TiXmlAttribute* copy = new TiXmlAttribute();
+      copy->name = attribute->name;
+      copy->value = attribute->value;
+      delete attribute;
+      attribute = copy;
+    }
+    LocalizeName( attribute->name, names );
+    attribute->value.Own();
+    attributeSet.Add( attribute );
+  }
+}
+#endif
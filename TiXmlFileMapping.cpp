@@ -0,0 +1,139 @@
+/* 类 */
+
+#if defined( _WIN32 )
+  #include <io.h>
+#endif
+
+/* 把文件只读映射到内存。映射出来的内容后面至少跟着一个'\0'，可以直接交给解析器。
+ * 文件大小用size_t表示，可以映射超过2GB的文件
+ */
+class TiXmlFileMapping
+{
+public:
+  TiXmlFileMapping() : base( 0 ), length( 0 ), mapLength( 0 ) {}
+  ~TiXmlFileMapping() { Close(); }
+
+  /* 成功返回TIXML_NO_ERROR；失败返回TIXML_ERROR_OPENING_FILE，空文件返回TIXML_ERROR_DOCUMENT_EMPTY */
+  int Open( const char* filename );
+  void Close();
+
+  const char* Data() const { return (const char*)base; }
+  size_t Length() const    { return length; }
+
+  /* 当前平台是否支持mmap() */
+  static bool Supported();
+
+  /* 已经打开的文件的大小。和Open()一样用size_t表示，不受ftell()返回long的限制；取不到时返回false */
+  static bool FileSize( FILE* file, size_t* size );
+
+private:
+  /* 不允许拷贝 */
+  TiXmlFileMapping( const TiXmlFileMapping& );
+  void operator=( const TiXmlFileMapping& );
+
+  void*   base;
+  size_t  length;     /* 文件的大小 */
+  size_t  mapLength;  /* 映射的大小，比文件至少多一页 */
+};
+
+/* 方法 */
+
+bool TiXmlFileMapping::Supported()
+{
+#if defined( __unix__ ) || defined( __APPLE__ )
+  return true;
+#else
+  return false;
+#endif
+}
+
+bool TiXmlFileMapping::FileSize( FILE* file, size_t* size )
+{
+#if defined( __unix__ ) || defined( __APPLE__ )
+  struct stat st;
+  if ( fstat( fileno( file ), &st ) != 0 || st.st_size < 0 || (unsigned long long)st.st_size >= (size_t)-1 )
+    return false;
+  *size = (size_t)st.st_size;
+  return true;
+#elif defined( _WIN32 )
+  __int64 length = _filelengthi64( _fileno( file ) );
+  if ( length < 0 || (unsigned __int64)length >= (size_t)-1 )
+    return false;
+  *size = (size_t)length;
+  return true;
+#else
+  fseek( file, 0, SEEK_END );
+  long length = ftell( file );
+  fseek( file, 0, SEEK_SET );
+  if ( length < 0 )
+    return false;
+  *size = (size_t)length;
+  return true;
+#endif
+}
+
+int TiXmlFileMapping::Open( const char* filename )
+{
+  Close();
+
+#if defined( __unix__ ) || defined( __APPLE__ )
+  int fd = open( filename, O_RDONLY );
+  if ( fd < 0 )
+    return TiXmlBase::TIXML_ERROR_OPENING_FILE;
+
+  /* 用fstat()取文件大小，不受long的限制 */
+  struct stat st;
+  if ( fstat( fd, &st ) != 0 || (unsigned long long)st.st_size >= (size_t)-1 )
+  {
+    close( fd );
+    return TiXmlBase::TIXML_ERROR_OPENING_FILE;
+  }
+  if ( st.st_size == 0 )
+  {
+    close( fd );
+    return TiXmlBase::TIXML_ERROR_DOCUMENT_EMPTY;
+  }
+
+  /* 解析器要求输入以'\0'结尾。先保留一段比文件至少多一页的匿名零页，再把文件映射到它的开头：
+   * 文件最后一页中超出文件的部分由内核填0，后面多出的一页也全是0
+   */
+  size_t size = (size_t)st.st_size;
+  size_t pageSize = (size_t)sysconf( _SC_PAGESIZE );
+  size_t total = ( size / pageSize + 1 ) * pageSize;
+
+  void* p = mmap( 0, total, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+  if ( p == MAP_FAILED )
+  {
+    close( fd );
+    return TiXmlBase::TIXML_ERROR_OPENING_FILE;
+  }
+  if ( mmap( p, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0 ) == MAP_FAILED )
+  {
+    munmap( p, total );
+    close( fd );
+    return TiXmlBase::TIXML_ERROR_OPENING_FILE;
+  }
+  close( fd );
+
+  /* 解析是从头到尾顺序扫描的 */
+  madvise( p, size, MADV_SEQUENTIAL );
+
+  base = p;
+  length = size;
+  mapLength = total;
+  return TiXmlBase::TIXML_NO_ERROR;
+#else
+  (void)filename;
+  return TiXmlBase::TIXML_ERROR_OPENING_FILE;
+#endif
+}
+
+void TiXmlFileMapping::Close()
+{
+#if defined( __unix__ ) || defined( __APPLE__ )
+  if ( base )
+    munmap( base, mapLength );
+#endif
+  base = 0;
+  length = mapLength = 0;
+}
@@ -0,0 +1,176 @@
+/* 类 */
+
+/* 冻结的文档：由TiXmlDocument::Freeze()生成的只读、紧凑的表示，给很多线程同时查询读多写少的数据。
+ * TiXmlNode每个节点有虚表指针、五个链接指针、字符串、userData和位置，这里每个节点只有几个32位的编号，
+ * 按列(structure of arrays)连续存放：
+ *   types[i]       节点类型，CDATA的文本另加FLAG_CDATA
+ *   values[i]      值在字符串池中的编号
+ *   parents[i]     父节点
+ *   ends[i]        子树结束的位置。节点按先序排列，第一个子节点是i + 1(如果i + 1 < ends[i])，下一个兄弟是ends[i]
+ *   attributes[i]  属性在attributeNames/attributeValues中的开头，第i个节点的属性是[attributes[i], attributes[i+1])
+ * 所有字符串都在一个TiXmlStringPool中只存一份，按名字查找时先查出名字的编号，再逐个比较编号。
+ * 建好以后不再修改，也没有任何缓存，所以多个线程可以不加锁地同时使用。
+ * 通过TiXmlFrozenNode访问，用法和TiXmlNode、TiXmlElement一样：
+ *
+ *   TiXmlFrozenDocument* frozen = doc.Freeze();
+ *   for ( TiXmlFrozenNode item = frozen->RootElement().FirstChildElement( "item" ); item; item = item.NextSiblingElement( "item" ) )
+ *     item.QueryIntAttribute( "id", &id );
+ *   delete frozen;
+ */
+class TiXmlFrozenDocument
+{
+  friend class TiXmlFrozenNode;
+public:
+  /* 把document当前的内容复制过来。之后document的修改不会影响它 */
+  explicit TiXmlFrozenDocument( const TiXmlDocument& document );
+  ~TiXmlFrozenDocument();
+
+  /* 文档本身和根元素 */
+  TiXmlFrozenNode Root() const;
+  TiXmlFrozenNode RootElement() const;
+
+  /* 节点的个数，包括文档本身 */
+  unsigned int NodeCount() const { return count; }
+  /* 占用的内存 */
+  size_t BytesUsed() const;
+
+  enum
+  {
+    NONE = 0xffffffffu,
+    FLAG_CDATA = 0x80,
+    TYPE_MASK = 0x7f
+  };
+
+private:
+  /* 不允许拷贝 */
+  TiXmlFrozenDocument( const TiXmlFrozenDocument& );
+  void operator=( const TiXmlFrozenDocument& );
+
+  /* i的下一个兄弟，没有时返回NONE */
+  unsigned int Next( unsigned int i ) const
+  {
+    unsigned int next = ends[i];
+    return ( i != 0 && next < ends[ parents[i] ] ) ? next : (unsigned int)NONE;
+  }
+  /* i的第一个子节点，没有时返回NONE */
+  unsigned int First( unsigned int i ) const
+  {
+    return ( i + 1 < ends[i] ) ? i + 1 : (unsigned int)NONE;
+  }
+  int Type( unsigned int i ) const { return types[i] & TYPE_MASK; }
+
+  unsigned int    count;
+  unsigned char*  types;
+  unsigned int*   values;
+  unsigned int*   parents;
+  unsigned int*   ends;
+  unsigned int*   attributes;       /* count + 1个 */
+  unsigned int*   attributeNames;
+  unsigned int*   attributeValues;
+  TiXmlStringPool strings;
+};
+
+/* 方法 */
+
+TiXmlFrozenDocument::TiXmlFrozenDocument( const TiXmlDocument& document )
+{
+  /* 先数一遍，各列一次分配到位 */
+  unsigned int attributeCount = 0;
+  count = 1;
+  for ( const TiXmlNode* node = document.FirstChild(); node; )
+  {
+    ++count;
+    if ( const TiXmlElement* element = node->ToElement() )
+    {
+      for ( const TiXmlAttribute* attrib = element->FirstAttribute(); attrib; attrib = attrib->Next() )
+        ++attributeCount;
+    }
+    if ( node->FirstChild() )
+    {
+      node = node->FirstChild();
+      continue;
+    }
+    while ( node != &document && !node->NextSibling() )
+      node = node->Parent();
+    node = ( node != &document ) ? node->NextSibling() : 0;
+  }
+
+  types = new unsigned char[ count ];
+  values = new unsigned int[ count ];
+  parents = new unsigned int[ count ];
+  ends = new unsigned int[ count ];
+  attributes = new unsigned int[ count + 1 ];
+  attributeNames = new unsigned int[ attributeCount ? attributeCount : 1 ];
+  attributeValues = new unsigned int[ attributeCount ? attributeCount : 1 ];
+
+  /* 再按先序填写，子树结束时补上ends。parent是当前节点的父节点的编号 */
+  unsigned int i = 0;
+  unsigned int a = 0;
+  unsigned int parent = NONE;
+  const TiXmlNode* node = &document;
+  while ( node )
+  {
+    types[i] = (unsigned char)node->Type();
+    if ( node->ToText() && node->ToText()->CDATA() )
+      types[i] |= FLAG_CDATA;
+    values[i] = strings.Add( node->Value(), strlen( node->Value() ) );
+    parents[i] = parent;
+    attributes[i] = a;
+    if ( const TiXmlElement* element = node->ToElement() )
+    {
+      for ( const TiXmlAttribute* attrib = element->FirstAttribute(); attrib; attrib = attrib->Next() )
+      {
+        attributeNames[a] = strings.Add( attrib->Name(), strlen( attrib->Name() ) );
+        attributeValues[a] = strings.Add( attrib->Value(), strlen( attrib->Value() ) );
+        ++a;
+      }
+    }
+    const unsigned int index = i++;
+
+    if ( node->FirstChild() )
+    {
+      parent = index;
+      node = node->FirstChild();
+      continue;
+    }
+    ends[index] = i;
+    /* 往上走，沿途结束的子树都补上ends */
+    while ( node != &document && !node->NextSibling() )
+    {
+      node = node->Parent();
+      ends[ parent ] = i;
+      parent = parents[ parent ];
+    }
+    node = ( node != &document ) ? node->NextSibling() : 0;
+  }
+  ends[0] = count;
+  attributes[count] = a;
+  assert( i == count && a == attributeCount );
+}
+
+TiXmlFrozenDocument::~TiXmlFrozenDocument()
+{
+  delete [] types;
+  delete [] values;
+  delete [] parents;
+  delete [] ends;
+  delete [] attributes;
+  delete [] attributeNames;
+  delete [] attributeValues;
+}
+
+size_t TiXmlFrozenDocument::BytesUsed() const
+{
+  return sizeof( *this ) + count * ( sizeof( unsigned char ) + 4 * sizeof( unsigned int ) ) + sizeof( unsigned int )
+         + attributes[count] * 2 * sizeof( unsigned int ) + strings.BytesUsed();
+}
+
+TiXmlFrozenNode TiXmlFrozenDocument::Root() const
+{
+  return TiXmlFrozenNode( this, 0 );
+}
+
+TiXmlFrozenNode TiXmlFrozenDocument::RootElement() const
+{
+  return Root().FirstChildElement();
+}
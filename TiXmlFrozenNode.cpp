@@ -0,0 +1,248 @@
+/* 类 */
+
+/* TiXmlFrozenDocument中的一个节点。它只是(文档, 编号)两个值，按值传递，不用释放；
+ * 不指向任何节点时为空，可以直接用在if和for的条件中。
+ * 导航和属性的接口与TiXmlNode、TiXmlElement同名，返回的是TiXmlFrozenNode而不是指针。
+ * 和TiXmlHandle一样，空节点上的调用都是安全的：导航返回空节点，字符串返回0，查询返回TIXML_NO_ATTRIBUTE，
+ * 所以frozen->RootElement().FirstChildElement( "a" ).FirstChildElement( "b" ).Attribute( "c" )不用逐级检查
+ */
+class TiXmlFrozenNode
+{
+  friend class TiXmlFrozenDocument;
+public:
+  TiXmlFrozenNode() : document( 0 ), index( 0 ) {}
+
+  /* 是否指向一个节点 */
+  operator const void*() const { return document ? this : 0; }
+
+  /* TiXmlNode::NodeType，空节点返回-1 */
+  int Type() const           { return document ? document->Type( index ) : -1; }
+  /* 空节点返回0 */
+  const char* Value() const  { return document ? document->strings.String( document->values[index] ) : 0; }
+  bool ValueIs( const char* value ) const { return document && strcmp( Value(), value ) == 0; }
+
+  bool IsElement() const     { return Type() == TiXmlNode::TINYXML_ELEMENT; }
+  bool IsText() const        { return Type() == TiXmlNode::TINYXML_TEXT; }
+  bool CDATA() const         { return document && ( document->types[index] & TiXmlFrozenDocument::FLAG_CDATA ) != 0; }
+
+  TiXmlFrozenNode Parent() const;
+  TiXmlFrozenNode FirstChild() const;
+  TiXmlFrozenNode FirstChild( const char* value ) const;
+  TiXmlFrozenNode NextSibling() const;
+  TiXmlFrozenNode NextSibling( const char* value ) const;
+  TiXmlFrozenNode FirstChildElement() const;
+  TiXmlFrozenNode FirstChildElement( const char* value ) const;
+  TiXmlFrozenNode NextSiblingElement() const;
+  TiXmlFrozenNode NextSiblingElement( const char* value ) const;
+
+  /* 第一个孩子节点的文本，同TiXmlElement::GetText() */
+  const char* GetText() const;
+
+  /* 属性。按名字查找时没有这个属性返回0 */
+  const char* Attribute( const char* name ) const;
+  int AttributeCount() const;
+  const char* AttributeName( int i ) const;
+  const char* AttributeValue( int i ) const;
+
+  /* 同TiXmlElement::QueryIntAttribute()等，返回TIXML_SUCCESS、TIXML_WRONG_TYPE或TIXML_NO_ATTRIBUTE。
+   * 默认的mode也和它们一样：Int和Double是LENIENT，其余的是STRICT
+   */
+  int QueryIntAttribute( const char* name, int* _value, TiXmlConvert::Mode mode = TiXmlConvert::LENIENT ) const;
+  int QueryInt64Attribute( const char* name, long long* _value, TiXmlConvert::Mode mode = TiXmlConvert::STRICT ) const;
+  int QueryUint64Attribute( const char* name, unsigned long long* _value, TiXmlConvert::Mode mode = TiXmlConvert::STRICT ) const;
+  int QueryDoubleAttribute( const char* name, double* _value, TiXmlConvert::Mode mode = TiXmlConvert::LENIENT ) const;
+  int QueryBoolAttribute( const char* name, bool* _value, TiXmlConvert::Mode mode = TiXmlConvert::STRICT ) const;
+
+  bool operator==( const TiXmlFrozenNode& other ) const { return document == other.document && index == other.index; }
+  bool operator!=( const TiXmlFrozenNode& other ) const { return !( *this == other ); }
+
+private:
+  TiXmlFrozenNode( const TiXmlFrozenDocument* _document, unsigned int _index )
+    : document( _index == TiXmlFrozenDocument::NONE ? 0 : _document ), index( _index ) {}
+
+  /* 名字在字符串池中的编号，池中没有或者自己是空节点时返回NONE(这时一定找不到) */
+  unsigned int NameId( const char* name ) const { return document ? document->strings.Find( name ) : TiXmlFrozenDocument::NONE; }
+  /* 属性值的编号，没有这个属性时返回NONE */
+  unsigned int FindAttribute( const char* name ) const;
+
+  const TiXmlFrozenDocument*  document;
+  unsigned int                index;
+};
+
+/* 方法 */
+
+TiXmlFrozenNode TiXmlFrozenNode::Parent() const
+{
+  if ( !document )
+    return TiXmlFrozenNode();
+  return TiXmlFrozenNode( document, document->parents[index] );
+}
+
+TiXmlFrozenNode TiXmlFrozenNode::FirstChild() const
+{
+  if ( !document )
+    return TiXmlFrozenNode();
+  return TiXmlFrozenNode( document, document->First( index ) );
+}
+
+TiXmlFrozenNode TiXmlFrozenNode::NextSibling() const
+{
+  if ( !document )
+    return TiXmlFrozenNode();
+  return TiXmlFrozenNode( document, document->Next( index ) );
+}
+
+TiXmlFrozenNode TiXmlFrozenNode::FirstChild( const char* value ) const
+{
+  const unsigned int id = NameId( value );
+  if ( id == TiXmlFrozenDocument::NONE )
+    return TiXmlFrozenNode();
+  unsigned int i = document->First( index );
+  while ( i != TiXmlFrozenDocument::NONE && document->values[i] != id )
+    i = document->Next( i );
+  return TiXmlFrozenNode( document, i );
+}
+
+TiXmlFrozenNode TiXmlFrozenNode::NextSibling( const char* value ) const
+{
+  const unsigned int id = NameId( value );
+  if ( id == TiXmlFrozenDocument::NONE )
+    return TiXmlFrozenNode();
+  unsigned int i = document->Next( index );
+  while ( i != TiXmlFrozenDocument::NONE && document->values[i] != id )
+    i = document->Next( i );
+  return TiXmlFrozenNode( document, i );
+}
+
+TiXmlFrozenNode TiXmlFrozenNode::FirstChildElement() const
+{
+  if ( !document )
+    return TiXmlFrozenNode();
+  unsigned int i = document->First( index );
+  while ( i != TiXmlFrozenDocument::NONE && document->Type( i ) != TiXmlNode::TINYXML_ELEMENT )
+    i = document->Next( i );
+  return TiXmlFrozenNode( document, i );
+}
+
+TiXmlFrozenNode TiXmlFrozenNode::FirstChildElement( const char* value ) const
+{
+  const unsigned int id = NameId( value );
+  if ( id == TiXmlFrozenDocument::NONE )
+    return TiXmlFrozenNode();
+  unsigned int i = document->First( index );
+  while ( i != TiXmlFrozenDocument::NONE
+          && ( document->values[i] != id || document->Type( i ) != TiXmlNode::TINYXML_ELEMENT ) )
+    i = document->Next( i );
+  return TiXmlFrozenNode( document, i );
+}
+
+TiXmlFrozenNode TiXmlFrozenNode::NextSiblingElement() const
+{
+  if ( !document )
+    return TiXmlFrozenNode();
+  unsigned int i = document->Next( index );
+  while ( i != TiXmlFrozenDocument::NONE && document->Type( i ) != TiXmlNode::TINYXML_ELEMENT )
+    i = document->Next( i );
+  return TiXmlFrozenNode( document, i );
+}
+
+TiXmlFrozenNode TiXmlFrozenNode::NextSiblingElement( const char* value ) const
+{
+  const unsigned int id = NameId( value );
+  if ( id == TiXmlFrozenDocument::NONE )
+    return TiXmlFrozenNode();
+  unsigned int i = document->Next( index );
+  while ( i != TiXmlFrozenDocument::NONE
+          && ( document->values[i] != id || document->Type( i ) != TiXmlNode::TINYXML_ELEMENT ) )
+    i = document->Next( i );
+  return TiXmlFrozenNode( document, i );
+}
+
+const char* TiXmlFrozenNode::GetText() const
+{
+  TiXmlFrozenNode child = FirstChild();
+  if ( child && child.IsText() )
+    return child.Value();
+  return 0;
+}
+
+unsigned int TiXmlFrozenNode::FindAttribute( const char* name ) const
+{
+  const unsigned int id = NameId( name );
+  if ( id == TiXmlFrozenDocument::NONE )
+    return TiXmlFrozenDocument::NONE;
+  const unsigned int end = document->attributes[ index + 1 ];
+  for ( unsigned int a = document->attributes[index]; a < end; ++a )
+  {
+    if ( document->attributeNames[a] == id )
+      return document->attributeValues[a];
+  }
+  return TiXmlFrozenDocument::NONE;
+}
+
+const char* TiXmlFrozenNode::Attribute( const char* name ) const
+{
+  const unsigned int id = FindAttribute( name );
+  return id == TiXmlFrozenDocument::NONE ? 0 : document->strings.String( id );
+}
+
+int TiXmlFrozenNode::AttributeCount() const
+{
+  if ( !document )
+    return 0;
+  return (int)( document->attributes[ index + 1 ] - document->attributes[index] );
+}
+
+const char* TiXmlFrozenNode::AttributeName( int i ) const
+{
+  if ( i < 0 || i >= AttributeCount() )
+    return 0;
+  return document->strings.String( document->attributeNames[ document->attributes[index] + i ] );
+}
+
+const char* TiXmlFrozenNode::AttributeValue( int i ) const
+{
+  if ( i < 0 || i >= AttributeCount() )
+    return 0;
+  return document->strings.String( document->attributeValues[ document->attributes[index] + i ] );
+}
+
+int TiXmlFrozenNode::QueryIntAttribute( const char* name, int* _value, TiXmlConvert::Mode mode ) const
+{
+  const unsigned int id = FindAttribute( name );
+  if ( id == TiXmlFrozenDocument::NONE )
+    return TIXML_NO_ATTRIBUTE;
+  return TiXmlConvert::ToInt( document->strings.String( id ), document->strings.Length( id ), _value, mode );
+}
+
+int TiXmlFrozenNode::QueryInt64Attribute( const char* name, long long* _value, TiXmlConvert::Mode mode ) const
+{
+  const unsigned int id = FindAttribute( name );
+  if ( id == TiXmlFrozenDocument::NONE )
+    return TIXML_NO_ATTRIBUTE;
+  return TiXmlConvert::ToInt64( document->strings.String( id ), document->strings.Length( id ), _value, mode );
+}
+
+int TiXmlFrozenNode::QueryUint64Attribute( const char* name, unsigned long long* _value, TiXmlConvert::Mode mode ) const
+{
+  const unsigned int id = FindAttribute( name );
+  if ( id == TiXmlFrozenDocument::NONE )
+    return TIXML_NO_ATTRIBUTE;
+  return TiXmlConvert::ToUint64( document->strings.String( id ), document->strings.Length( id ), _value, mode );
+}
+
+int TiXmlFrozenNode::QueryDoubleAttribute( const char* name, double* _value, TiXmlConvert::Mode mode ) const
+{
+  const unsigned int id = FindAttribute( name );
+  if ( id == TiXmlFrozenDocument::NONE )
+    return TIXML_NO_ATTRIBUTE;
+  return TiXmlConvert::ToDouble( document->strings.String( id ), document->strings.Length( id ), _value, mode );
+}
+
+int TiXmlFrozenNode::QueryBoolAttribute( const char* name, bool* _value, TiXmlConvert::Mode mode ) const
+{
+  const unsigned int id = FindAttribute( name );
+  if ( id == TiXmlFrozenDocument::NONE )
+    return TIXML_NO_ATTRIBUTE;
+  return TiXmlConvert::ToBool( document->strings.String( id ), document->strings.Length( id ), _value, mode );
+}
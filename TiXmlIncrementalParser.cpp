@@ -0,0 +1,424 @@
+/* 类 */
+
+/* TiXmlDocument::FeedChunk()/Finish()使用的分段解析器。
+ * 收到的数据先追加到buffer，然后找出其中最后一个完整标记的结尾，把这之前的部分交给TiXmlReader，
+ * 再由reader的事件建立DOM树。标记之间的状态(打开的元素、编码)保存在reader中；
+ * 还没收完的标记(名字、实体引用、属性值、CDATA等断在中间的情况)留在buffer里等下一块。
+ * 查找标记结尾时记住已经扫描过的位置，同一个字节不会扫描两次。
+ * 文档设置了资源限制(TiXmlParseOptions::SetMaxNodes()等)时，和Parse()一样在建立节点时记账；
+ * 还没收完的字符串和缓冲区也有上限，不会因为一个永远不结束的标记无限增长
+ */
+class TiXmlIncrementalParser
+{
+public:
+  TiXmlIncrementalParser( TiXmlDocument* document, TiXmlEncoding encoding );
+  ~TiXmlIncrementalParser();
+
+  /* 追加一块数据，并解析其中已经完整的部分。出错返回false，错误信息在文档中 */
+  bool Feed( const char* data, size_t length );
+  /* 输入结束，解析剩下的内容 */
+  bool Finish();
+
+private:
+  /* 不允许拷贝 */
+  TiXmlIncrementalParser( const TiXmlIncrementalParser& );
+  void operator=( const TiXmlIncrementalParser& );
+
+  /* 正在扫描的标记是哪一种，决定了用什么来找它的结尾 */
+  enum Token
+  {
+    TOKEN_NONE,       /* 在两个标记之间 */
+    TOKEN_TEXT,       /* 文本，到下一个'<'为止 */
+    TOKEN_TAG,        /* <name ...>、<?xml ...?>，引号中的'>'不算结尾 */
+    TOKEN_DTD,        /* <!DOCTYPE ...>等，到第一个'>'为止 */
+    TOKEN_COMMENT,    /* <!-- ... --> */
+    TOKEN_CDATA       /* <![CDATA[ ... ]]> */
+  };
+
+  size_t FindBoundary();
+  bool Consume( size_t length, bool more );
+  bool Emit();
+  bool Fail( int err );
+  /* 资源限制的记账，超过限制时返回对应的错误码 */
+  int ChargeElement();
+  int ChargeNode( size_t size );
+
+  TiXmlDocument*  document;
+  TiXmlArena*     arena;
+  TiXmlEncoding   encoding;
+  TiXmlReader     reader;
+  TiXmlNode*      current;    /* 新节点挂在它下面 */
+  bool            started;    /* reader已经打开 */
+  TiXmlParsingData* limits;   /* 没有设置资源限制时为0 */
+
+  char*           buffer;     /* 还没有交给reader的数据 */
+  size_t          length;
+  size_t          capacity;
+
+  Token           token;
+  size_t          tokenStart; /* 当前标记在buffer中的开头 */
+  size_t          scan;       /* 当前标记从这里继续找结尾 */
+  char            quote;      /* TOKEN_TAG中正在读的引号，0表示不在引号中 */
+  size_t          stringStart;  /* 正在读的字符串(文本、注释、属性值等)在buffer中的开头 */
+};
+
+/* 方法 */
+
+TiXmlIncrementalParser::TiXmlIncrementalParser( TiXmlDocument* _document, TiXmlEncoding _encoding )
+  : document( _document ), arena( _document->Arena() ), encoding( _encoding ),
+    current( _document ), started( false ), limits( 0 ),
+    buffer( 0 ), length( 0 ), capacity( 0 ),
+    token( TOKEN_NONE ), tokenStart( 0 ), scan( 0 ), quote( 0 ), stringStart( 0 )
+{
+  const TiXmlParseOptions& options = document->ParseOptions();
+  reader.SetCondenseWhiteSpace( options.IsWhiteSpaceCondensed() );
+  /* 计数跨越所有的块，所以整个分段解析共用一份 */
+  if ( options.HasLimits() )
+    limits = new TiXmlParsingData( "", options, 0, 0 );
+}
+
+TiXmlIncrementalParser::~TiXmlIncrementalParser()
+{
+  delete [] buffer;
+  delete limits;
+}
+
+bool TiXmlIncrementalParser::Fail( int err )
+{
+  document->SetError( err, 0, 0, TIXML_ENCODING_UNKNOWN );
+  return false;
+}
+
+bool TiXmlIncrementalParser::Feed( const char* data, size_t dataLength )
+{
+  if ( document->Error() )
+    return false;
+  /* 根元素之后出现了文本，和Parse()一样忽略后面的所有内容 */
+  if ( started && reader.Done() )
+    return true;
+  if ( dataLength == 0 )
+    return true;
+  /* reader以'\0'为结尾，数据中间不能有'\0' */
+  if ( memchr( data, 0, dataLength ) )
+    return Fail( TiXmlBase::TIXML_ERROR_EMBEDDED_NULL );
+
+  /* 多留一个字节放'\0' */
+  if ( length + dataLength + 1 > capacity )
+  {
+    size_t newCapacity = capacity ? capacity * 2 : 4096;
+    while ( newCapacity < length + dataLength + 1 )
+      newCapacity *= 2;
+    if ( limits )
+    {
+      int err = limits->CheckPending( 0, newCapacity );
+      if ( err )
+        return Fail( err );
+    }
+    char* newBuffer = new char[ newCapacity ];
+    if ( length )
+      memcpy( newBuffer, buffer, length );
+    delete [] buffer;
+    buffer = newBuffer;
+    capacity = newCapacity;
+  }
+  memcpy( buffer + length, data, dataLength );
+  length += dataLength;
+
+  size_t complete = FindBoundary();
+  if ( complete && !Consume( complete, true ) )
+    return false;
+
+  /* 剩下的是还没收完的标记，检查它正在读的字符串有没有超过限制 */
+  if ( limits )
+  {
+    int err = limits->CheckPending( length - stringStart, capacity );
+    if ( err )
+      return Fail( err );
+  }
+  return true;
+}
+
+bool TiXmlIncrementalParser::Finish()
+{
+  if ( document->Error() )
+    return false;
+  if ( !started || !reader.Done() )
+  {
+    if ( length && !Consume( length, false ) )
+      return false;
+    if ( started && !reader.Done() )
+    {
+      reader.Continue( "", false );
+      if ( !Emit() )
+        return false;
+    }
+  }
+
+  if ( document->NoChildren() )
+    return Fail( TiXmlBase::TIXML_ERROR_DOCUMENT_EMPTY );
+  return true;
+}
+
+/* 把buffer的前n个字节交给reader，剩下的移到开头 */
+bool TiXmlIncrementalParser::Consume( size_t n, bool more )
+{
+  char saved = buffer[n];
+  buffer[n] = 0;
+
+  if ( !started )
+  {
+    reader.Open( buffer, encoding );
+    started = true;
+  }
+  reader.Continue( buffer, more );
+  bool ok = Emit();
+
+  buffer[n] = saved;
+  length -= n;
+  if ( length )
+    memmove( buffer, buffer + n, length );
+  tokenStart -= n;
+  scan -= n;
+  stringStart -= n;
+  return ok;
+}
+
+/* 读出reader中的事件，建立节点。和TiXmlDocument::Parse()得到的树相同 */
+bool TiXmlIncrementalParser::Emit()
+{
+  for ( ;; )
+  {
+    TiXmlNode* node = 0;
+    switch ( reader.Read() )
+    {
+      case TiXmlReader::TIXML_READ_START_ELEMENT:
+      {
+        if ( limits )
+        {
+          int err = ChargeElement();
+          if ( err )
+            return Fail( err );
+          limits->EnterElement();
+        }
+        TiXmlElement* element = new( arena ) TiXmlElement( reader.Name() );
+        for ( int i = 0; i < reader.AttributeCount(); ++i )
+        {
+          const TiXmlAttribute* attrib = reader.AttributeAt( i );
+          element->SetAttribute( attrib->Name(), attrib->Value() );
+        }
+        current->LinkEndChild( element );
+        current = element;
+        break;
+      }
+      case TiXmlReader::TIXML_READ_END_ELEMENT:
+        if ( limits )
+          limits->LeaveElement();
+        current = current->Parent();
+        break;
+      case TiXmlReader::TIXML_READ_TEXT:
+      {
+        if ( limits )
+        {
+          int err = ChargeNode( sizeof( TiXmlText ) );
+          if ( err )
+            return Fail( err );
+        }
+        TiXmlText* text = new( arena ) TiXmlText( reader.Value() );
+        text->SetCDATA( reader.IsCDATA() );
+        node = text;
+        break;
+      }
+      case TiXmlReader::TIXML_READ_COMMENT:
+        if ( limits )
+        {
+          int err = ChargeNode( sizeof( TiXmlComment ) );
+          if ( err )
+            return Fail( err );
+        }
+        node = new( arena ) TiXmlComment( reader.Value() );
+        break;
+      case TiXmlReader::TIXML_READ_DECLARATION:
+        if ( limits )
+        {
+          int err = ChargeNode( sizeof( TiXmlDeclaration ) );
+          if ( err )
+            return Fail( err );
+        }
+        node = new( arena ) TiXmlDeclaration( reader.DeclarationNode() );
+        break;
+      case TiXmlReader::TIXML_READ_UNKNOWN:
+        if ( limits )
+        {
+          int err = ChargeNode( sizeof( TiXmlUnknown ) );
+          if ( err )
+            return Fail( err );
+        }
+        node = new( arena ) TiXmlUnknown();
+        node->SetValue( reader.Value() );
+        break;
+      case TiXmlReader::TIXML_READ_ERROR:
+        return Fail( reader.ErrorId() );
+      default:
+        /* 这一块读完了，或者文档结束了 */
+        return true;
+    }
+    if ( node )
+      current->LinkEndChild( node );
+  }
+}
+
+/* 和TiXmlElement::Parse()一样：节点、名字，然后是每个属性和它的名字、值 */
+int TiXmlIncrementalParser::ChargeElement()
+{
+  const size_t nameLength = strlen( reader.Name() );
+  int err = limits->AddNode( sizeof( TiXmlElement ), true );
+  if ( !err )
+    err = limits->AddString( nameLength, nameLength + 1 );
+  for ( int i = 0; !err && i < reader.AttributeCount(); ++i )
+  {
+    const TiXmlAttribute* attrib = reader.AttributeAt( i );
+    const size_t attribNameLength = strlen( attrib->Name() );
+    const size_t attribValueLength = strlen( attrib->Value() );
+    err = limits->AddAttribute( i + 1, sizeof( TiXmlAttribute ) );
+    if ( !err )
+      err = limits->AddString( attribNameLength, attribNameLength + 1 );
+    if ( !err )
+      err = limits->AddString( attribValueLength, attribValueLength + 1 );
+  }
+  return err;
+}
+
+/* 文本、注释、声明和未知节点：节点和它的值 */
+int TiXmlIncrementalParser::ChargeNode( size_t size )
+{
+  const size_t valueLength = reader.ValueLength();
+  int err = limits->AddNode( size, false );
+  if ( !err )
+    err = limits->AddString( valueLength, valueLength + 1 );
+  return err;
+}
+
+/* 返回buffer中最后一个完整标记的结尾，0表示还没有完整的标记。
+ * 标记前面的文本跟着标记一起交出去，这样reader读文本时总能看到结尾的'<'
+ */
+size_t TiXmlIncrementalParser::FindBoundary()
+{
+  static const char cdataHeader[] = "<![CDATA[";
+  static const char commentHeader[] = "<!--";
+
+  size_t complete = 0;
+  for ( ;; )
+  {
+    if ( token == TOKEN_NONE || token == TOKEN_TEXT )
+    {
+      if ( token == TOKEN_NONE )
+      {
+        scan = stringStart = tokenStart;
+        token = TOKEN_TEXT;
+      }
+      const char* lt = scan < length ? (const char*)memchr( buffer + scan, '<', length - scan ) : 0;
+      if ( !lt )
+      {
+        scan = length;
+        return complete;
+      }
+      tokenStart = scan = stringStart = lt - buffer;
+
+      /* 前缀还没收全时无法判断是哪种标记 */
+      size_t avail = length - tokenStart;
+      const char* q = buffer + tokenStart;
+      if ( ( avail < sizeof( cdataHeader ) - 1 && memcmp( q, cdataHeader, avail ) == 0 )
+        || ( avail < sizeof( commentHeader ) - 1 && memcmp( q, commentHeader, avail ) == 0 ) )
+        return complete;
+
+      if ( memcmp( q, commentHeader, sizeof( commentHeader ) - 1 ) == 0 )
+      {
+        token = TOKEN_COMMENT;
+        scan = tokenStart + sizeof( commentHeader ) - 1;
+      }
+      else if ( memcmp( q, cdataHeader, sizeof( cdataHeader ) - 1 ) == 0 )
+      {
+        token = TOKEN_CDATA;
+        scan = tokenStart + sizeof( cdataHeader ) - 1;
+      }
+      else if ( avail >= 2 && q[1] == '!' )
+      {
+        token = TOKEN_DTD;
+        scan = tokenStart + 2;
+      }
+      else
+      {
+        token = TOKEN_TAG;
+        quote = 0;
+        scan = tokenStart + 1;
+      }
+    }
+
+    size_t end = 0;
+    if ( token == TOKEN_COMMENT || token == TOKEN_CDATA )
+    {
+      const char* terminator = ( token == TOKEN_COMMENT ) ? "-->" : "]]>";
+      size_t i = scan;
+      for ( ; i + 3 <= length; ++i )
+      {
+        const char* gt = (const char*)memchr( buffer + i + 2, '>', length - i - 2 );
+        if ( !gt )
+        {
+          i = length - 2;
+          break;
+        }
+        i = gt - buffer - 2;
+        if ( memcmp( buffer + i, terminator, 3 ) == 0 )
+        {
+          end = i + 3;
+          break;
+        }
+      }
+      if ( !end )
+        scan = ( i > scan ) ? i : scan;
+    }
+    else if ( token == TOKEN_DTD )
+    {
+      const char* gt = scan < length ? (const char*)memchr( buffer + scan, '>', length - scan ) : 0;
+      if ( gt )
+        end = gt - buffer + 1;
+      else
+        scan = length;
+    }
+    else
+    {
+      size_t i = scan;
+      for ( ; i < length; ++i )
+      {
+        char c = buffer[i];
+        if ( quote )
+        {
+          if ( c == quote )
+          {
+            quote = 0;
+            stringStart = i + 1;
+          }
+        }
+        else if ( c == '"' || c == '\'' )
+        {
+          quote = c;
+          stringStart = i + 1;
+        }
+        else if ( c == '>' )
+        {
+          end = i + 1;
+          break;
+        }
+      }
+      if ( !end )
+        scan = length;
+    }
+
+    if ( !end )
+      return complete;
+
+    complete = end;
+    token = TOKEN_NONE;
+    tokenStart = end;
+  }
+}
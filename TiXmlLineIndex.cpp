@@ -0,0 +1,292 @@
+/* 类 */
+
+/* 文档的行索引。解析时节点只记下自己在输入中的字节偏移，Row()/Column()被调用时才由这里换算成行列号。
+ * Build()在解析结束时扫描一遍输入，只找换行符并检查每一行是否“简单”(只有ASCII字符、没有'\t')：
+ * 简单的行中列号就是字节数；其他的行不保存内容，只记下列号和字节数不再一一对应的位置(Mark)，
+ * 规则和TiXmlParsingData::Stamp()相同，所以结果和逐个节点Stamp()完全相同。
+ * 连续的同样长度的多字节字符只记一次，UTF-8的文本通常只需要很少的Mark
+ */
+class TiXmlLineIndex
+{
+public:
+  TiXmlLineIndex() : lines( 0 ), count( 0 ), capacity( 0 ), marks( 0 ), markCount( 0 ), markCapacity( 0 ),
+                     generation( 0 ), baseRow( 0 ), baseCol( 0 ) {}
+  ~TiXmlLineIndex() { delete [] lines; delete [] marks; }
+
+  /* 为第generation次解析的输入[p, end)建立索引。p处的行列号是(row, col) */
+  void Build( const char* p, const char* end, const TiXmlParseOptions& options, TiXmlEncoding encoding, int row, int col, int generation );
+  void Clear();
+  /* 接管other的索引，other变成空的。TiXmlDocument移动时使用 */
+  void TakeOver( TiXmlLineIndex& other );
+
+  bool Empty() const { return count == 0; }
+
+  /* 第generation次解析中相对于p的偏移offset处的行列号，从0开始。超出范围时是最后一行；
+   * generation和建立索引的那次解析不同时是(-1, -1)
+   */
+  TiXmlCursor Locate( size_t offset, int generation ) const;
+
+  /* 索引占用的内存 */
+  size_t BytesUsed() const { return capacity * sizeof( Line ) + markCapacity * sizeof( Mark ); }
+
+private:
+  /* 不允许拷贝 */
+  TiXmlLineIndex( const TiXmlLineIndex& );
+  void operator=( const TiXmlLineIndex& );
+
+  struct Line
+  {
+    size_t  start;    /* 行首的偏移 */
+    size_t  mark;     /* 这一行的第一个Mark，到下一行的mark为止。简单的行没有Mark */
+  };
+
+  /* 从行内字节offset开始列号是col，之后每width个字节(一个字符)占一列，直到下一个Mark */
+  struct Mark
+  {
+    size_t        offset;
+    int           col;
+    unsigned int  width;
+  };
+
+  void AddLine( size_t start );
+  void AddMark( size_t line, size_t offset, int col, unsigned int width );
+  /* 按Stamp()的规则为[p, stop)记下Mark，col是行首的列号 */
+  void MarkLine( const char* p, const char* stop, int col, TiXmlEncoding encoding );
+
+  Line*   lines;
+  size_t  count;
+  size_t  capacity;
+  Mark*   marks;
+  size_t  markCount;
+  size_t  markCapacity;
+  int     generation;     /* 建立索引的那次解析，0表示没有 */
+
+  int     baseRow;
+  int     baseCol;        /* 只作用于第一行 */
+  int     tabSize;
+};
+
+/* 方法 */
+
+void TiXmlLineIndex::Clear()
+{
+  delete [] lines;
+  lines = 0;
+  count = capacity = 0;
+  delete [] marks;
+  marks = 0;
+  markCount = markCapacity = 0;
+  generation = 0;
+}
+
+void TiXmlLineIndex::TakeOver( TiXmlLineIndex& other )
+{
+  Clear();
+  lines = other.lines;
+  count = other.count;
+  capacity = other.capacity;
+  marks = other.marks;
+  markCount = other.markCount;
+  markCapacity = other.markCapacity;
+  generation = other.generation;
+  baseRow = other.baseRow;
+  baseCol = other.baseCol;
+  tabSize = other.tabSize;
+
+  other.lines = 0;
+  other.count = other.capacity = 0;
+  other.marks = 0;
+  other.markCount = other.markCapacity = 0;
+  other.generation = 0;
+}
+
+void TiXmlLineIndex::AddLine( size_t start )
+{
+  if ( count == capacity )
+  {
+    size_t newCapacity = capacity ? capacity * 2 : 256;
+    Line* newLines = new Line[ newCapacity ];
+    if ( count )
+      memcpy( newLines, lines, count * sizeof( Line ) );
+    delete [] lines;
+    lines = newLines;
+    capacity = newCapacity;
+  }
+  lines[count].start = start;
+  lines[count].mark = markCount;
+  ++count;
+}
+
+void TiXmlLineIndex::AddMark( size_t line, size_t offset, int col, unsigned int width )
+{
+  /* 同一个位置的Mark只保留最后一个(零宽字符后面紧跟着多字节字符时) */
+  if ( markCount > lines[line].mark && marks[markCount - 1].offset == offset )
+  {
+    marks[markCount - 1].col = col;
+    marks[markCount - 1].width = width;
+    return;
+  }
+  if ( markCount == markCapacity )
+  {
+    size_t newCapacity = markCapacity ? markCapacity * 2 : 64;
+    Mark* newMarks = new Mark[ newCapacity ];
+    if ( markCount )
+      memcpy( newMarks, marks, markCount * sizeof( Mark ) );
+    delete [] marks;
+    marks = newMarks;
+    markCapacity = newCapacity;
+  }
+  marks[markCount].offset = offset;
+  marks[markCount].col = col;
+  marks[markCount].width = width;
+  ++markCount;
+}
+
+void TiXmlLineIndex::MarkLine( const char* begin, const char* stop, int col, TiXmlEncoding encoding )
+{
+  const size_t line = count - 1;
+  const bool utf8 = ( encoding == TIXML_ENCODING_UTF8 );
+  unsigned int width = 1;   /* 当前这一段每个字符的字节数，行首是ASCII */
+  const char* p = begin;
+
+  while ( p < stop )
+  {
+    const unsigned char* pU = (const unsigned char*)p;
+    unsigned int step = 1;
+    int advance = 1;
+
+    if ( *pU == '\t' )
+    {
+      /* 跳到下一个制表位，后面的字符从新的列号开始 */
+      col = ( col / tabSize + 1 ) * tabSize;
+      ++p;
+      AddMark( line, p - begin, col, 1 );
+      width = 1;
+      continue;
+    }
+    if ( utf8 && *pU >= 0x80 )
+    {
+      if ( *pU == TIXML_UTF_LEAD_0 )
+      {
+        if ( stop - p > 2 )
+        {
+          step = 3;
+          /* BOM等零宽字符不占列 */
+          if ( ( pU[1] == TIXML_UTF_LEAD_1 && pU[2] == TIXML_UTF_LEAD_2 )
+            || ( pU[1] == 0xbfU && ( pU[2] == 0xbeU || pU[2] == 0xbfU ) ) )
+            advance = 0;
+        }
+      }
+      else
+      {
+        step = TiXmlBase::utf8ByteTable[ *pU ];
+        if ( step == 0 )
+          step = 1;
+        /* 行尾不完整的字符：Stamp()不会越过行尾以后再数列号 */
+        if ( step > (unsigned int)( stop - p ) )
+          step = (unsigned int)( stop - p );
+      }
+    }
+
+    if ( !advance )
+    {
+      p += step;
+      AddMark( line, p - begin, col, 1 );
+      width = 1;
+      continue;
+    }
+    if ( step != width )
+    {
+      AddMark( line, p - begin, col, step );
+      width = step;
+    }
+    p += step;
+    col += advance;
+  }
+}
+
+void TiXmlLineIndex::Build( const char* begin, const char* end, const TiXmlParseOptions& options, TiXmlEncoding encoding, int row, int col, int _generation )
+{
+  Clear();
+  generation = _generation;
+  tabSize = options.TabSize();
+  baseRow = row;
+  baseCol = col;
+
+  /* 只有UTF-8中>= 0x80的字节不是一个字节一列 */
+  const unsigned char highMask = ( encoding == TIXML_ENCODING_UTF8 ) ? 0x80 : 0;
+  const char* p = begin;
+  for ( ;; )
+  {
+    /* 这一行到'\n'或单独的'\r'为止。LoadFile()已经把'\r'换掉了，通常找不到 */
+    const char* nl = (const char*)memchr( p, '\n', end - p );
+    const char* stop = nl ? nl : end;
+    const char* cr = (const char*)memchr( p, '\r', stop - p );
+    if ( cr )
+      stop = cr;
+
+    /* 没有分支的循环，编译器可以向量化 */
+    unsigned char special = 0;
+    for ( const char* q = p; q < stop; ++q )
+    {
+      unsigned char c = (unsigned char)*q;
+      special |= (unsigned char)( ( c & highMask ) | ( c == '\t' ) );
+    }
+
+    AddLine( p - begin );
+    if ( special )
+      MarkLine( p, stop, ( p == begin ) ? baseCol : 0, encoding );
+
+    if ( stop == end )
+      break;
+    /* "\r\n"只算一个换行 */
+    p = stop + 1;
+    if ( *stop == '\r' && p < end && *p == '\n' )
+      ++p;
+  }
+}
+
+TiXmlCursor TiXmlLineIndex::Locate( size_t offset, int _generation ) const
+{
+  TiXmlCursor cursor;
+  cursor.Clear();
+  if ( !count || _generation != generation )
+    return cursor;
+
+  /* 二分查找offset所在的行 */
+  size_t lo = 0, hi = count;
+  while ( hi - lo > 1 )
+  {
+    size_t mid = lo + ( hi - lo ) / 2;
+    if ( lines[mid].start <= offset )
+      lo = mid;
+    else
+      hi = mid;
+  }
+
+  const Line& line = lines[lo];
+  const size_t inLine = offset - line.start;
+  cursor.row = baseRow + (int)lo;
+
+  /* 再在这一行的Mark中二分查找offset前面最近的一个 */
+  size_t first = line.mark;
+  size_t last = ( lo + 1 < count ) ? lines[lo + 1].mark : markCount;
+  if ( first == last || marks[first].offset > inLine )
+  {
+    cursor.col = ( ( lo == 0 ) ? baseCol : 0 ) + (int)inLine;
+    return cursor;
+  }
+  while ( last - first > 1 )
+  {
+    size_t mid = first + ( last - first ) / 2;
+    if ( marks[mid].offset <= inLine )
+      first = mid;
+    else
+      last = mid;
+  }
+
+  /* 和Stamp()一样，停在字符中间时这个字符也算上 */
+  const Mark& mark = marks[first];
+  cursor.col = mark.col + (int)( ( inLine - mark.offset + mark.width - 1 ) / mark.width );
+  return cursor;
+}
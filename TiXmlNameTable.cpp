@@ -0,0 +1,144 @@
+/* 类 */
+
+/* 元素名和属性名的字符串池(intern table)。文档里节点很多，但不同的名字通常只有几百个：
+ * 每个名字在这里只存一份，节点只保存指向它的指针，同名的节点共享同一个指针。
+ * 这样按名字查找时指针相同就能确定相等，不需要strcmp()。
+ * 名字的内存在表析构时才释放，所以用到这个表的节点不能比它活得更久。
+ * 可以由几个文档共享(TiXmlDocument::SetNameTable())，但不是线程安全的
+ */
+class TiXmlNameTable
+{
+public:
+  TiXmlNameTable() : slots( 0 ), capacity( 0 ), count( 0 ) {}
+  ~TiXmlNameTable() { delete [] slots; }
+
+  /* 返回[p, p+length)在表中的那一份，以'\0'结尾。表中没有时先加进去 */
+  const char* Intern( const char* p, size_t length );
+  /* 只查找，不添加。表中没有时返回0 */
+  const char* Find( const char* name ) const;
+  const char* Find( const char* p, size_t length ) const;
+
+  /* 把other中的名字都加进来 */
+  void Merge( const TiXmlNameTable& other );
+
+  /* 表中不同名字的个数 */
+  size_t Count() const { return count; }
+  /* 名字占用的内存 */
+  size_t BytesUsed() const { return strings.BytesUsed(); }
+
+  /* FNV-1a，TiXmlAttributeSet的索引也用它 */
+  static size_t Hash( const char* p, size_t length )
+  {
+    size_t h = 2166136261u;
+    for ( size_t i = 0; i < length; ++i )
+    {
+      h ^= (unsigned char)p[i];
+      h *= 16777619u;
+    }
+    return h;
+  }
+
+private:
+  /* 不允许拷贝 */
+  TiXmlNameTable( const TiXmlNameTable& );
+  void operator=( const TiXmlNameTable& );
+
+  struct Slot
+  {
+    const char* str;    /* 0表示空位 */
+    size_t      length;
+    size_t      hash;
+  };
+
+  const Slot* Lookup( const char* p, size_t length, size_t hash ) const;
+  void Grow();
+
+  Slot*       slots;      /* 开放定址，容量是2的幂 */
+  size_t      capacity;
+  size_t      count;
+  TiXmlArena  strings;    /* 名字本身顺序存放在内存池中 */
+};
+
+/* 方法 */
+
+/* 线性探测，返回名字所在的位置，没有时返回应该插入的空位 */
+const TiXmlNameTable::Slot* TiXmlNameTable::Lookup( const char* p, size_t length, size_t hash ) const
+{
+  size_t mask = capacity - 1;
+  for ( size_t i = hash & mask; ; i = ( i + 1 ) & mask )
+  {
+    const Slot* slot = slots + i;
+    if ( !slot->str )
+      return slot;
+    if ( slot->hash == hash && slot->length == length && memcmp( slot->str, p, length ) == 0 )
+      return slot;
+  }
+}
+
+const char* TiXmlNameTable::Intern( const char* p, size_t length )
+{
+  /* 装填因子不超过1/2 */
+  if ( ( count + 1 ) * 2 > capacity )
+    Grow();
+
+  size_t hash = Hash( p, length );
+  Slot* slot = const_cast< Slot* >( Lookup( p, length, hash ) );
+  if ( slot->str )
+    return slot->str;
+
+  char* str = (char*) strings.Alloc( length + 1 );
+  if ( !str )
+    return 0;
+  memcpy( str, p, length );
+  str[length] = 0;
+
+  slot->str = str;
+  slot->length = length;
+  slot->hash = hash;
+  ++count;
+  return str;
+}
+
+const char* TiXmlNameTable::Find( const char* name ) const
+{
+  return Find( name, strlen( name ) );
+}
+
+const char* TiXmlNameTable::Find( const char* p, size_t length ) const
+{
+  if ( !count )
+    return 0;
+  return Lookup( p, length, Hash( p, length ) )->str;
+}
+
+void TiXmlNameTable::Merge( const TiXmlNameTable& other )
+{
+  for ( size_t i = 0; i < other.capacity; ++i )
+  {
+    if ( other.slots[i].str )
+      Intern( other.slots[i].str, other.slots[i].length );
+  }
+}
+
+void TiXmlNameTable::Grow()
+{
+  size_t newCapacity = capacity ? capacity * 2 : 256;
+  Slot* newSlots = new Slot[ newCapacity ];
+  memset( newSlots, 0, newCapacity * sizeof( Slot ) );
+
+  /* 重新插入，已有的名字不会重复，不需要比较 */
+  size_t mask = newCapacity - 1;
+  for ( size_t i = 0; i < capacity; ++i )
+  {
+    if ( !slots[i].str )
+      continue;
+    size_t j = slots[i].hash & mask;
+    while ( newSlots[j].str )
+      j = ( j + 1 ) & mask;
+    newSlots[j] = slots[i];
+  }
+
+  delete [] slots;
+  slots = newSlots;
+  capacity = newCapacity;
+}
@@ -5,6 +5,10 @@ class TiXmlNode : public TiXmlBase
 {
   friend class TiXmlDocument;
   friend class TiXmlElement;
+  friend class TiXmlWriter;
+  friend class TiXmlParallelParser;
+  friend class TiXmlSnapshot;
+  friend class TiXmlQueryIterator;
 public:
   /** The types of XML nodes supported by TinyXml. (All the
       unsupported types are picked up by UNKNOWN.)
@@ -23,7 +27,10 @@ public:
   virtual ~TiXmlNode();
   
   const char *Value() const { return value.c_str (); }
-  const TIXML_STRING& ValueTStr() const { return value; }
+  /* 就地解析或使用名字表的文档中，第一次调用时拷贝一份缓存在节点中(见TiXmlStringRef::Str()) */
+  const TIXML_STRING& ValueTStr() const { return value.Str(); }
+  /* value本身。就地解析过程中还没有补'\0'，这时应该按长度使用它 */
+  const TiXmlStringRef& ValueRef() const { return value; }
 
   /*Changes the value of the node. (不同的子类，对应的value是不同的)
     Defined as:
@@ -34,6 +41,10 @@ public:
     Text:   the text string
   */
   void SetValue(const char * _value) { value = _value;}
+#if defined( TIXML_HAS_MOVE ) && defined( TIXML_USE_STL )
+  /* 直接接管_value的内存，不再拷贝 */
+  void SetValue( std::string&& _value ) { value = std::move( _value ); }
+#endif
   
   /* 删除当前节点所有的子节点，但是对当前节点没有影响 */
   void Clear();
@@ -98,6 +109,34 @@ public:
   /* 删除当前子节点 */
   bool RemoveChild( TiXmlNode* removeThis );
 
+#ifdef TIXML_HAS_MOVE
+  /* 以上插入函数的移动版本：addThis的值、属性和子节点整个移到新节点中，不做深拷贝，之后addThis是空的。
+   * 返回新节点；位置不对或者addThis是文档时返回0，这时addThis不变。addThis不能是当前节点的祖先
+   */
+  TiXmlNode* InsertEndChild( TiXmlNode&& addThis );
+  TiXmlNode* InsertBeforeChild( TiXmlNode* beforeThis, TiXmlNode&& addThis );
+  TiXmlNode* InsertAfterChild( TiXmlNode* afterThis, TiXmlNode&& addThis );
+  TiXmlNode* ReplaceChild( TiXmlNode* replaceThis, TiXmlNode&& withThis );
+
+  /* 接管unique_ptr中的节点，和LinkEndChild()一样不拷贝。失败时节点被删除，返回0 */
+  template< class T > T* InsertEndChild( std::unique_ptr< T > addThis )
+  {
+    return static_cast< T* >( LinkEndChild( addThis.release() ) );
+  }
+  template< class T > T* InsertBeforeChild( TiXmlNode* beforeThis, std::unique_ptr< T > addThis )
+  {
+    return static_cast< T* >( LinkBeforeChild( beforeThis, addThis.release() ) );
+  }
+  template< class T > T* InsertAfterChild( TiXmlNode* afterThis, std::unique_ptr< T > addThis )
+  {
+    return static_cast< T* >( LinkAfterChild( afterThis, addThis.release() ) );
+  }
+  template< class T > T* ReplaceChild( TiXmlNode* replaceThis, std::unique_ptr< T > withThis )
+  {
+    return static_cast< T* >( LinkReplaceChild( replaceThis, withThis.release() ) );
+  }
+#endif
+
   /* 同级的前一个节点 */
   const TiXmlNode* PreviousSibling() const { return prev; }
   TiXmlNode* PreviousSibling() { return prev; }
@@ -185,9 +224,59 @@ public:
 
   void CopyTo( TiXmlNode* target ) const;
 
+#ifdef TIXML_HAS_MOVE
+  /* 移动构造和移动赋值使用：接管other的值、userData和全部子节点。调用前当前节点不能有子节点 */
+  void MoveFrom( TiXmlNode& other );
+  /* 把自己的内容移到一个新建的节点中，不调用Localize()。默认是Clone()，有移动构造函数的子类直接移动 */
+  virtual TiXmlNode* MoveOut() { return Clone(); }
+  /* 移动之后调用，from是内容原来所在的文档。当前节点不在from中时，把接管过来的内容和from断开：
+   * 引用缓冲区的字符串拷贝成自己的，名字放进当前文档的名字表(没有表时也拷贝)，
+   * from内存池中的子节点和属性换成堆上的拷贝。这样from析构或重新加载以后，移过来的内容仍然有效。
+   * Insert*()在链接以后才调用，这时知道目标文档，在同一个文档中移动时什么都不做
+   */
+  void Localize( const TiXmlDocument* from );
+  /* 名字和from断开：names不为0时放进这个表，否则拷贝成自己的 */
+  static void LocalizeName( TiXmlStringRef& name, TiXmlNameTable* names );
+#endif
+
   /* 验证当前节点是否符合XML格式 */
   TiXmlNode* Identify( const char* start, TiXmlEncoding encoding );
 
+  /* 节点对象本身的大小，按类型计算 */
+  size_t SizeOf() const;
+  /* 解析时的资源限制。err是TiXmlParsingData::AddNode()等的结果，不是TIXML_NO_ERROR时
+   * 以p为出错位置设置文档的错误并返回false
+   */
+  bool CheckLimit( int err, const char* p, TiXmlParsingData* data, TiXmlEncoding encoding );
+
+  /* value是否等于_value。names是文档的名字表，interned是_value在其中的那一份(表中没有时为0)。
+   * 文档中放进名字表的名字都来自文档自己的表(换表只能在没有子节点时进行，移到别的文档时
+   * 重新放进目标文档的表或拷贝出来)，所以value在表中时只比较指针，指针不同就一定不相等
+   */
+  bool ValueIs( const char* _value, const TiXmlNameTable* names, const char* interned ) const
+  {
+    if ( names && value.IsInterned() )
+      return value.c_str() == interned;
+    return strcmp( value.c_str(), _value ) == 0;
+  }
+
+  /* 按名字查找时使用。第一次遇到放在名字表中的节点时才找文档、在表中查一次名字，
+   * 之后把结果传给ValueIs()；没有名字表的文档一次也不查，和逐个strcmp()一样
+   */
+  class NameMatch
+  {
+  public:
+    NameMatch( const TiXmlNode* _from, const char* _name )
+      : from( _from ), name( _name ), names( 0 ), interned( 0 ), looked( false ) {}
+    bool operator()( const TiXmlNode* node );
+  private:
+    const TiXmlNode*      from;
+    const char*           name;
+    const TiXmlNameTable* names;
+    const char*           interned;
+    bool                  looked;
+  };
+
   /* 数据成员 */
   TiXmlNode*  parent;
   NodeType    type;
@@ -195,7 +284,8 @@ public:
   TiXmlNode*  firstChild;
   TiXmlNode*  lastChild;
 
-  TIXML_STRING  value;
+  /* 就地解析时只引用文档的缓冲区，修改时才拷贝 */
+  TiXmlStringRef  value;
 
   TiXmlNode*  prev;
   TiXmlNode*  next;
@@ -204,6 +294,16 @@ private:
   /* 拷贝构造函数和复制运算符不允许调用 */
   TiXmlNode( const TiXmlNode& );
   void operator=( const TiXmlNode& base ); 
+
+  virtual const TiXmlDocument* LocationDocument() const { return GetDocument(); }
+
+  /* addThis能否成为子节点。文档不能，这时在所属文档中设置TIXML_ERROR_DOCUMENT_TOP_ONLY */
+  bool AcceptsChild( const TiXmlNode& addThis );
+
+  /* 和LinkEndChild()一样接管node，失败时删除node并返回0 */
+  TiXmlNode* LinkBeforeChild( TiXmlNode* beforeThis, TiXmlNode* node );
+  TiXmlNode* LinkAfterChild( TiXmlNode* afterThis, TiXmlNode* node );
+  TiXmlNode* LinkReplaceChild( TiXmlNode* replaceThis, TiXmlNode* node );
 };
 
 /* 方法 */
@@ -213,6 +313,10 @@ TiXmlNode* TiXmlNode::Identify( const char* p, TiXmlEncoding encoding )
 {
   TiXmlNode* returnNode = 0;
 
+  /* 文档开启了内存池时，新节点从内存池中分配 */
+  TiXmlDocument* doc = GetDocument();
+  TiXmlArena* arena = doc ? doc->Arena() : 0;
+
   p = SkipWhiteSpace( p, encoding );
   if( !p || !*p || *p != '<' )
   {
@@ -236,21 +340,21 @@ TiXmlNode* TiXmlNode::Identify( const char* p, TiXmlEncoding encoding )
     #ifdef DEBUG_PARSER
       TIXML_LOG( "XML parsing Declaration\n" );
     #endif
-    returnNode = new TiXmlDeclaration();
+    returnNode = new( arena ) TiXmlDeclaration();
   }
   else if ( StringEqual( p, commentHeader, false, encoding ) )
   {
     #ifdef DEBUG_PARSER
       TIXML_LOG( "XML parsing Comment\n" );
     #endif
-    returnNode = new TiXmlComment();
+    returnNode = new( arena ) TiXmlComment();
   }
   else if ( StringEqual( p, cdataHeader, false, encoding ) )
   {
     #ifdef DEBUG_PARSER
       TIXML_LOG( "XML parsing CDATA\n" );
     #endif
-    TiXmlText* text = new TiXmlText( "" );
+    TiXmlText* text = new( arena ) TiXmlText( "" );
     text->SetCDATA( true );
     returnNode = text;
   }
@@ -259,28 +363,349 @@ TiXmlNode* TiXmlNode::Identify( const char* p, TiXmlEncoding encoding )
     #ifdef DEBUG_PARSER
       TIXML_LOG( "XML parsing Unknown(1)\n" );
     #endif
-    returnNode = new TiXmlUnknown();
+    returnNode = new( arena ) TiXmlUnknown();
   }
   else if (IsAlpha( *(p+1), encoding ) || *(p+1) == '_' )
   {
     #ifdef DEBUG_PARSER
       TIXML_LOG( "XML parsing Element\n" );
     #endif
-    returnNode = new TiXmlElement( "" );
+    returnNode = new( arena ) TiXmlElement( "" );
   }
   else
   {
     #ifdef DEBUG_PARSER
       TIXML_LOG( "XML parsing Unknown(2)\n" );
     #endif
-    returnNode = new TiXmlUnknown();
+    returnNode = new( arena ) TiXmlUnknown();
   }
 
   if (returnNode)
   {
     // Set the parent, so it can report errors
     returnNode->parent = this;
+
+    /* 设置了资源限制时，在这里给新节点记账。普通文本节点不经过这里，在TiXmlText::Parse()中记账 */
+    TiXmlParsingData* data = doc ? doc->ParsingLimits() : 0;
+    if ( data && !CheckLimit( data->AddNode( returnNode->SizeOf(), returnNode->type == TINYXML_ELEMENT ), p, data, encoding ) )
+    {
+      delete returnNode;
+      return 0;
+    }
+#ifdef TIXML_USE_STATS
+    TiXmlParseStats::CountNode( returnNode->type );
+#endif
   }
   return returnNode;
 }
 
+size_t TiXmlNode::SizeOf() const
+{
+  switch ( type )
+  {
+    case TINYXML_DOCUMENT:    return sizeof( TiXmlDocument );
+    case TINYXML_ELEMENT:     return sizeof( TiXmlElement );
+    case TINYXML_COMMENT:     return sizeof( TiXmlComment );
+    case TINYXML_UNKNOWN:     return sizeof( TiXmlUnknown );
+    case TINYXML_TEXT:        return sizeof( TiXmlText );
+    case TINYXML_DECLARATION: return sizeof( TiXmlDeclaration );
+    default:                  return sizeof( TiXmlNode );
+  }
+}
+
+bool TiXmlNode::CheckLimit( int err, const char* p, TiXmlParsingData* data, TiXmlEncoding encoding )
+{
+  if ( err == TIXML_NO_ERROR )
+    return true;
+  TiXmlDocument* document = GetDocument();
+  if ( document )
+    document->SetError( err, p, data, encoding );
+  return false;
+}
+
+bool TiXmlNode::NameMatch::operator()( const TiXmlNode* node )
+{
+  if ( !looked && node->value.IsInterned() )
+  {
+    const TiXmlDocument* doc = from->GetDocument();
+    names = doc ? doc->NameTable() : 0;
+    interned = names ? names->Find( name ) : 0;
+    looked = true;
+  }
+  return node->ValueIs( name, names, interned );
+}
+
+/* 以下按名字查找的函数最多在名字表中查一次，之后名字表中的节点只比较指针 */
+const TiXmlNode* TiXmlNode::FirstChild( const char * _value ) const
+{
+  NameMatch match( this, _value );
+  for ( const TiXmlNode* node = firstChild; node; node = node->next )
+  {
+    if ( match( node ) )
+      return node;
+  }
+  return 0;
+}
+
+const TiXmlNode* TiXmlNode::LastChild( const char * _value ) const
+{
+  NameMatch match( this, _value );
+  for ( const TiXmlNode* node = lastChild; node; node = node->prev )
+  {
+    if ( match( node ) )
+      return node;
+  }
+  return 0;
+}
+
+const TiXmlNode* TiXmlNode::PreviousSibling( const char * _value ) const
+{
+  NameMatch match( this, _value );
+  for ( const TiXmlNode* node = prev; node; node = node->prev )
+  {
+    if ( match( node ) )
+      return node;
+  }
+  return 0;
+}
+
+const TiXmlNode* TiXmlNode::NextSibling( const char * _value ) const
+{
+  NameMatch match( this, _value );
+  for ( const TiXmlNode* node = next; node; node = node->next )
+  {
+    if ( match( node ) )
+      return node;
+  }
+  return 0;
+}
+
+const TiXmlElement* TiXmlNode::FirstChildElement( const char * _value ) const
+{
+  NameMatch match( this, _value );
+  for ( const TiXmlNode* node = firstChild; node; node = node->next )
+  {
+    if ( node->ToElement() && match( node ) )
+      return node->ToElement();
+  }
+  return 0;
+}
+
+const TiXmlElement* TiXmlNode::NextSiblingElement( const char * _value ) const
+{
+  NameMatch match( this, _value );
+  for ( const TiXmlNode* node = next; node; node = node->next )
+  {
+    if ( node->ToElement() && match( node ) )
+      return node->ToElement();
+  }
+  return 0;
+}
+
+/* 共享的字符串(TiXmlDocument::ShareStrings())拷贝时只增加引用计数 */
+void TiXmlNode::CopyTo( TiXmlNode* target ) const
+{
+  target->value = value;
+  target->userData = userData;
+}
+
+#ifdef TIXML_HAS_MOVE
+/* 按先序走接管过来的子树。来自内存池的子节点整个换成Clone()，拷贝都在堆上，字符串也都是自己的 */
+void TiXmlNode::Localize( const TiXmlDocument* from )
+{
+  TiXmlDocument* target = GetDocument();
+  if ( !from || from == target )
+    return;
+  TiXmlNameTable* names = target ? target->NameTable() : 0;
+
+  TiXmlNode* node = this;
+  while ( node )
+  {
+    TiXmlElement* element = node->ToElement();
+    if ( element )
+    {
+      LocalizeName( node->value, names );
+      element->LocalizeAttributes( names );
+    }
+    else
+      node->value.Own();
+
+    for ( TiXmlNode* child = node->firstChild; child; child = child->next )
+    {
+      if ( !child->InArena() )
+        continue;
+
+      TiXmlNode* copy = child->Clone();
+      copy->parent = node;
+      copy->prev = child->prev;
+      copy->next = child->next;
+      if ( copy->prev )
+        copy->prev->next = copy;
+      else
+        node->firstChild = copy;
+      if ( copy->next )
+        copy->next->prev = copy;
+      else
+        node->lastChild = copy;
+      child->parent = 0;
+      child->prev = child->next = 0;
+      delete child;
+      child = copy;
+    }
+
+    if ( node->firstChild )
+    {
+      node = node->firstChild;
+      continue;
+    }
+    while ( node != this && !node->next )
+      node = node->parent;
+    node = ( node != this ) ? node->next : 0;
+  }
+}
+
+void TiXmlNode::LocalizeName( TiXmlStringRef& name, TiXmlNameTable* names )
+{
+  if ( names )
+    name.Intern( names->Intern( name.c_str(), name.length() ), name.length() );
+  else
+    name.Own();
+}
+
+void TiXmlNode::MoveFrom( TiXmlNode& other )
+{
+  assert( !firstChild );
+  value = std::move( other.value );
+  userData = other.userData;
+
+  firstChild = other.firstChild;
+  lastChild = other.lastChild;
+  other.firstChild = other.lastChild = 0;
+  for ( TiXmlNode* node = firstChild; node; node = node->next )
+    node->parent = this;
+}
+
+/* 先检查位置，确定能插入以后才移动addThis，失败时addThis保持原样。链接以后再和原来的文档断开 */
+TiXmlNode* TiXmlNode::InsertEndChild( TiXmlNode&& addThis )
+{
+  if ( !AcceptsChild( addThis ) )
+    return 0;
+  const TiXmlDocument* from = addThis.GetDocument();
+  TiXmlNode* node = LinkEndChild( addThis.MoveOut() );
+  if ( node )
+    node->Localize( from );
+  return node;
+}
+
+TiXmlNode* TiXmlNode::InsertBeforeChild( TiXmlNode* beforeThis, TiXmlNode&& addThis )
+{
+  if ( !beforeThis || beforeThis->parent != this || !AcceptsChild( addThis ) )
+    return 0;
+  const TiXmlDocument* from = addThis.GetDocument();
+  TiXmlNode* node = LinkBeforeChild( beforeThis, addThis.MoveOut() );
+  if ( node )
+    node->Localize( from );
+  return node;
+}
+
+TiXmlNode* TiXmlNode::InsertAfterChild( TiXmlNode* afterThis, TiXmlNode&& addThis )
+{
+  if ( !afterThis || afterThis->parent != this || !AcceptsChild( addThis ) )
+    return 0;
+  const TiXmlDocument* from = addThis.GetDocument();
+  TiXmlNode* node = LinkAfterChild( afterThis, addThis.MoveOut() );
+  if ( node )
+    node->Localize( from );
+  return node;
+}
+
+TiXmlNode* TiXmlNode::ReplaceChild( TiXmlNode* replaceThis, TiXmlNode&& withThis )
+{
+  if ( !replaceThis || replaceThis->parent != this || !AcceptsChild( withThis ) )
+    return 0;
+  const TiXmlDocument* from = withThis.GetDocument();
+  TiXmlNode* node = LinkReplaceChild( replaceThis, withThis.MoveOut() );
+  if ( node )
+    node->Localize( from );
+  return node;
+}
+#endif
+
+bool TiXmlNode::AcceptsChild( const TiXmlNode& addThis )
+{
+  if ( addThis.Type() != TINYXML_DOCUMENT )
+    return true;
+  TiXmlDocument* document = GetDocument();
+  if ( document )
+    document->SetError( TIXML_ERROR_DOCUMENT_TOP_ONLY, 0, 0, TIXML_ENCODING_UNKNOWN );
+  return false;
+}
+
+TiXmlNode* TiXmlNode::LinkBeforeChild( TiXmlNode* beforeThis, TiXmlNode* node )
+{
+  if ( !node )
+    return 0;
+  if ( !beforeThis || beforeThis->parent != this || !AcceptsChild( *node ) )
+  {
+    delete node;
+    return 0;
+  }
+
+  node->parent = this;
+  node->next = beforeThis;
+  node->prev = beforeThis->prev;
+  if ( beforeThis->prev )
+    beforeThis->prev->next = node;
+  else
+    firstChild = node;
+  beforeThis->prev = node;
+  return node;
+}
+
+TiXmlNode* TiXmlNode::LinkAfterChild( TiXmlNode* afterThis, TiXmlNode* node )
+{
+  if ( !node )
+    return 0;
+  if ( !afterThis || afterThis->parent != this || !AcceptsChild( *node ) )
+  {
+    delete node;
+    return 0;
+  }
+
+  node->parent = this;
+  node->prev = afterThis;
+  node->next = afterThis->next;
+  if ( afterThis->next )
+    afterThis->next->prev = node;
+  else
+    lastChild = node;
+  afterThis->next = node;
+  return node;
+}
+
+/* 被替换的节点连同它的子节点一起删除 */
+TiXmlNode* TiXmlNode::LinkReplaceChild( TiXmlNode* replaceThis, TiXmlNode* node )
+{
+  if ( !node || node == replaceThis )
+    return node;
+  if ( !replaceThis || replaceThis->parent != this || !AcceptsChild( *node ) )
+  {
+    delete node;
+    return 0;
+  }
+
+  node->parent = this;
+  node->prev = replaceThis->prev;
+  node->next = replaceThis->next;
+  if ( replaceThis->next )
+    replaceThis->next->prev = node;
+  else
+    lastChild = node;
+  if ( replaceThis->prev )
+    replaceThis->prev->next = node;
+  else
+    firstChild = node;
+
+  delete replaceThis;
+  return node;
+}
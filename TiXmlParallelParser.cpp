@@ -0,0 +1,438 @@
+/* 类 */
+
+#if defined( TIXML_USE_THREADS ) && ( defined( __unix__ ) || defined( __APPLE__ ) )
+  #define TIXML_PARALLEL_PTHREAD
+  #include <pthread.h>
+#endif
+
+/* 根元素内容的并行解析，由TiXmlDocument::SetParseThreads()开启。
+ * 适合一个根元素下面有大量兄弟节点的文档(<feed><record/>...<record/></feed>)：
+ * 1. 先做一遍只看标记结构的扫描，在根元素的直接子节点之间找分割点。分割点放在两个子节点之间
+ *    只有空白的地方，并且紧跟在一个换行之后
+ * 2. 每一段交给一个线程，解析到一个临时的文档下面，节点和名字用临时文档自己的内存池和名字表。
+ *    节点记下的是相对于整个输入开头的偏移，不需要再修正行列号
+ * 3. 按文档顺序把各段的节点接到根元素下面，内存池和名字表并入主文档
+ * 任何一段出错，或者解析停下的位置和扫描的结果不一致，就丢掉所有结果，从头串行解析根元素的内容，
+ * 所以树的结构、行列号和错误信息都和串行解析完全相同
+ */
+class TiXmlParallelParser
+{
+public:
+  TiXmlParallelParser( TiXmlDocument* document, TiXmlElement* root, TiXmlEncoding encoding );
+  ~TiXmlParallelParser();
+
+  /* 代替root->ReadValue()：p是根元素开始标签之后的位置，返回根元素结束标签的位置 */
+  const char* ReadValue( const char* p, TiXmlParsingData* data );
+
+  /* 当前平台是否支持多线程解析 */
+  static bool Supported();
+
+  enum
+  {
+    MIN_SEGMENT = 1024 * 1024,  /* 每段至少这么多字节，太小时线程的开销不划算 */
+    MAX_SEGMENTS = 256
+  };
+
+private:
+  /* 不允许拷贝 */
+  TiXmlParallelParser( const TiXmlParallelParser& );
+  void operator=( const TiXmlParallelParser& );
+
+  struct Segment
+  {
+    TiXmlParallelParser* parser;
+    const char*     start;
+    const char*     end;        /* 下一段的开头；最后一段是根元素的结束标签 */
+    const char*     expect;     /* 正确解析时应该停下的位置 */
+    TiXmlDocument*  document;   /* 这一段的节点先挂在这个临时文档下面 */
+    bool            ok;
+#ifdef TIXML_USE_STATS
+    TiXmlParseStats::Counters counters;   /* 这一段在执行它的线程中增加的计数 */
+#endif
+  };
+
+  /* 步骤1：找分割点。找不到两段以上时返回false */
+  bool Split( const char* content );
+  /* 在[p, end)中找s */
+  static const char* Find( const char* p, const char* end, const char* s, size_t n );
+
+  /* 步骤2：解析一段，和TiXmlElement::ReadValue()的流程相同 */
+  void ParseSegment( Segment* segment );
+  /* 步骤3：修正一段节点的父节点、属性所属的文档以及名字表中的名字 */
+  void FixSegment( Segment* segment );
+  void FixString( TiXmlStringRef* str ) const;
+
+  /* 每一段调用一次fn，第0段在当前线程中执行 */
+  void RunAll( void (TiXmlParallelParser::*fn)( Segment* ) );
+  static void* RunOne( void* arg );
+  void (TiXmlParallelParser::*phase)( Segment* );
+
+  /* 丢掉各段的临时文档 */
+  void Discard();
+
+  TiXmlDocument*  document;
+  TiXmlElement*   root;
+  TiXmlEncoding   encoding;
+  TiXmlParseOptions options;
+  const TiXmlParsingData* mainData;   /* 各段复制一份，偏移都相对于它的开头 */
+
+  Segment*        segments;
+  int             count;
+  const char*     rootEnd;    /* 根元素结束标签"</"的位置 */
+};
+
+/* 方法 */
+
+bool TiXmlParallelParser::Supported()
+{
+#ifdef TIXML_PARALLEL_PTHREAD
+  return true;
+#else
+  return false;
+#endif
+}
+
+TiXmlParallelParser::TiXmlParallelParser( TiXmlDocument* _document, TiXmlElement* _root, TiXmlEncoding _encoding )
+  : phase( 0 ), document( _document ), root( _root ), encoding( _encoding ),
+    options( _document->ParseOptions() ), mainData( 0 ), segments( 0 ), count( 0 ), rootEnd( 0 )
+{
+}
+
+TiXmlParallelParser::~TiXmlParallelParser()
+{
+  Discard();
+}
+
+void TiXmlParallelParser::Discard()
+{
+  for ( int i = 0; i < count; ++i )
+    delete segments[i].document;
+  delete [] segments;
+  segments = 0;
+  count = 0;
+}
+
+const char* TiXmlParallelParser::ReadValue( const char* p, TiXmlParsingData* data )
+{
+  if ( !Supported() || !Split( p ) )
+    return root->ReadValue( p, data, encoding );
+
+  mainData = data;
+
+  /* 临时文档的设置和主文档一样，但内存池和名字表是自己的，各线程之间互不影响 */
+  for ( int i = 0; i < count; ++i )
+  {
+    TiXmlDocument* part = new TiXmlDocument();
+    part->SetParseOptions( options );
+    if ( document->Arena() )
+      part->UseArena( true );
+    if ( document->NameTable() )
+      part->UseNameTable( true );
+    part->parsingInSitu = document->parsingInSitu;
+    segments[i].document = part;
+  }
+
+  RunAll( &TiXmlParallelParser::ParseSegment );
+
+  for ( int i = 0; i < count; ++i )
+  {
+    if ( !segments[i].ok )
+    {
+      /* 就地解析在这个阶段不修改缓冲区，可以放心地重新解析 */
+      Discard();
+      return root->ReadValue( p, data, encoding );
+    }
+  }
+
+  /* 先把各段的名字并入主文档的名字表，FixSegment()只读它 */
+  TiXmlNameTable* names = document->NameTable();
+  if ( names )
+  {
+    for ( int i = 0; i < count; ++i )
+      names->Merge( *segments[i].document->NameTable() );
+  }
+
+  RunAll( &TiXmlParallelParser::FixSegment );
+
+  /* 按顺序把各段的节点接到根元素下面，每段只改首尾两个指针 */
+  for ( int i = 0; i < count; ++i )
+  {
+    TiXmlDocument* part = segments[i].document;
+    if ( part->firstChild )
+    {
+      if ( root->lastChild )
+        root->lastChild->next = part->firstChild;
+      else
+        root->firstChild = part->firstChild;
+      part->firstChild->prev = root->lastChild;
+      root->lastChild = part->lastChild;
+      part->firstChild = part->lastChild = 0;
+    }
+    if ( part->Arena() )
+      document->Arena()->Adopt( part->Arena() );
+  }
+
+  Discard();
+  return rootEnd;
+}
+
+/* 只识别标记的边界：注释、CDATA、<!...>、<?...>整个跳过，开始标签中引号里的'>'不算结尾。
+ * depth为0表示在根元素的直接子节点之间
+ */
+bool TiXmlParallelParser::Split( const char* content )
+{
+  const size_t length = strlen( content );
+  int threads = document->ParseThreads();
+  if ( threads > MAX_SEGMENTS )
+    threads = MAX_SEGMENTS;
+  if ( (size_t)threads > length / MIN_SEGMENT )
+    threads = (int)( length / MIN_SEGMENT );
+  if ( threads < 2 )
+    return false;
+
+  segments = new Segment[ threads ];
+  memset( segments, 0, threads * sizeof( Segment ) );
+  segments[0].start = content;
+  count = 1;
+
+  const char* end = content + length;
+  const size_t step = length / threads;
+  const char* target = content + step;
+  const char* q = content;
+  int depth = 0;
+
+  for ( ;; )
+  {
+    const char* lt = (const char*)memchr( q, '<', end - q );
+    if ( !lt )
+      break;
+
+    if ( lt[1] == '/' )
+    {
+      if ( depth == 0 )
+      {
+        rootEnd = lt;
+        break;
+      }
+      --depth;
+      q = (const char*)memchr( lt, '>', end - lt );
+    }
+    else if ( strncmp( lt, "<!--", 4 ) == 0 )
+    {
+      q = Find( lt + 4, end, "-->", 3 );
+    }
+    else if ( strncmp( lt, "<![CDATA[", 9 ) == 0 )
+    {
+      q = Find( lt + 9, end, "]]>", 3 );
+    }
+    else if ( lt[1] == '!' || lt[1] == '?' )
+    {
+      q = (const char*)memchr( lt, '>', end - lt );
+    }
+    else
+    {
+      char quote = 0;
+      for ( q = lt + 1; q < end; ++q )
+      {
+        if ( quote )
+        {
+          if ( *q == quote )
+            quote = 0;
+        }
+        else if ( *q == '"' || *q == '\'' )
+          quote = *q;
+        else if ( *q == '>' )
+          break;
+      }
+      if ( q < end && q[-1] != '/' )
+        ++depth;
+    }
+
+    /* 这时q指向标记结尾的'>' */
+    if ( !q || q >= end )
+      break;
+    ++q;
+
+    /* 一个直接子节点刚结束，而且已经过了下一个分割目标 */
+    if ( depth == 0 && q >= target && count < threads )
+    {
+      const char* next = (const char*)memchr( q, '<', end - q );
+      if ( !next )
+        break;
+      const char* newline = 0;
+      const char* s;
+      for ( s = q; s < next && TiXmlBase::IsWhiteSpace( *s ); ++s )
+      {
+        if ( *s == '\n' )
+          newline = s;
+      }
+      /* 中间夹着文本，或者不换行，就等下一个子节点 */
+      if ( s == next && newline && next[1] != '/' )
+      {
+        segments[ count - 1 ].end = newline + 1;
+        segments[ count - 1 ].expect = next;
+        segments[ count ].start = newline + 1;
+        ++count;
+        target = newline + 1 + step;
+      }
+      q = next;
+    }
+  }
+
+  /* 根元素没有正常结束，或者没有分出两段：交给串行解析去处理(包括报错) */
+  if ( !rootEnd || count < 2 )
+  {
+    Discard();
+    return false;
+  }
+  segments[ count - 1 ].end = rootEnd;
+  segments[ count - 1 ].expect = rootEnd;
+  for ( int i = 0; i < count; ++i )
+    segments[i].parser = this;
+  return true;
+}
+
+const char* TiXmlParallelParser::Find( const char* p, const char* end, const char* s, size_t n )
+{
+  while ( p + n <= end )
+  {
+    const char* hit = (const char*)memchr( p, s[0], end - p );
+    if ( !hit || hit + n > end )
+      return 0;
+    if ( memcmp( hit, s, n ) == 0 )
+      return hit + n - 1;
+    p = hit + 1;
+  }
+  return 0;
+}
+
+void TiXmlParallelParser::ParseSegment( Segment* segment )
+{
+  TiXmlDocument* part = segment->document;
+  TiXmlArena* arena = part->Arena();
+  TiXmlParsingData data( *mainData );
+
+  const char* p = segment->start;
+  const char* pWithWhiteSpace = p;
+  p = TiXmlBase::SkipWhiteSpace( p, encoding );
+
+  while ( p && *p && p < segment->end )
+  {
+    if ( *p != '<' )
+    {
+      TiXmlText* text = new( arena ) TiXmlText( "" );
+      text->parent = part;
+      p = text->Parse( options.IsWhiteSpaceCondensed() ? p : pWithWhiteSpace, &data, encoding );
+      if ( !text->Blank() )
+        part->LinkEndChild( text );
+      else
+        delete text;
+    }
+    else
+    {
+      if ( TiXmlBase::StringEqual( p, "</", false, encoding ) )
+        break;
+      TiXmlNode* node = part->Identify( p, encoding );
+      if ( !node )
+      {
+        p = 0;
+        break;
+      }
+      p = node->Parse( p, &data, encoding );
+      part->LinkEndChild( node );
+    }
+    pWithWhiteSpace = p;
+    p = TiXmlBase::SkipWhiteSpace( p, encoding );
+  }
+
+  segment->ok = p && p == segment->expect && !part->Error();
+}
+
+void TiXmlParallelParser::FixString( TiXmlStringRef* str ) const
+{
+  if ( str->IsInterned() )
+    str->Intern( document->NameTable()->Find( str->c_str(), str->length() ), str->length() );
+}
+
+/* 先序遍历这一段的节点 */
+void TiXmlParallelParser::FixSegment( Segment* segment )
+{
+  TiXmlDocument* part = segment->document;
+  const bool names = document->NameTable() != 0;
+
+  TiXmlNode* node = part->firstChild;
+  while ( node )
+  {
+    if ( node->parent == part )
+      node->parent = root;
+    if ( names )
+      FixString( &node->value );
+
+    TiXmlElement* element = node->ToElement();
+    if ( element )
+    {
+      for ( TiXmlAttribute* attrib = element->FirstAttribute(); attrib; attrib = attrib->Next() )
+      {
+        attrib->document = document;
+        if ( names )
+          FixString( &attrib->name );
+      }
+    }
+
+    if ( node->firstChild )
+    {
+      node = node->firstChild;
+      continue;
+    }
+    while ( node->parent != root && !node->next )
+      node = node->parent;
+    node = node->next;
+  }
+}
+
+void* TiXmlParallelParser::RunOne( void* arg )
+{
+  Segment* segment = (Segment*)arg;
+  TiXmlParallelParser* parser = segment->parser;
+#ifdef TIXML_USE_STATS
+  /* 每一段都是根元素的内容，在第1层元素里面 */
+  const int depth = TiXmlParseStats::counters.depth;
+  TiXmlParseStats::counters.depth = 1;
+  const TiXmlParseStats::Counters before = TiXmlParseStats::counters;
+#endif
+  ( parser->*( parser->phase ) )( segment );
+#ifdef TIXML_USE_STATS
+  segment->counters = TiXmlParseStats::Since( before );
+  TiXmlParseStats::counters.depth = depth;
+#endif
+  return 0;
+}
+
+void TiXmlParallelParser::RunAll( void (TiXmlParallelParser::*fn)( Segment* ) )
+{
+  phase = fn;
+#ifdef TIXML_PARALLEL_PTHREAD
+  pthread_t threads[ MAX_SEGMENTS ];
+  bool started[ MAX_SEGMENTS ];
+  for ( int i = 1; i < count; ++i )
+    started[i] = pthread_create( &threads[i], 0, RunOne, &segments[i] ) == 0;
+  RunOne( &segments[0] );
+  for ( int i = 1; i < count; ++i )
+  {
+    /* 线程没有建起来时在当前线程中补上 */
+    if ( started[i] )
+    {
+      pthread_join( threads[i], 0 );
+#ifdef TIXML_USE_STATS
+      /* 别的线程里的计数并到当前线程，文档在Parse()前后取的差才包括所有的段 */
+      TiXmlParseStats::Merge( segments[i].counters );
+#endif
+    }
+    else
+      RunOne( &segments[i] );
+  }
+#else
+  for ( int i = 0; i < count; ++i )
+    RunOne( &segments[i] );
+#endif
+}
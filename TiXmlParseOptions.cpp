@@ -0,0 +1,74 @@
+/* 类 */
+
+/* 解析选项。每个文档有自己的一份，解析时由TiXmlParsingData带到各个Parse()和ReadText()中，
+ * 不读任何全局状态，不同设置的文档可以在不同的线程中同时解析：
+ *
+ *   TiXmlParseOptions options;
+ *   options.SetCondenseWhiteSpace( false );
+ *   options.SetTrackLocation( true );
+ *   doc.LoadFile( "feed.xml", options );
+ */
+class TiXmlParseOptions
+{
+public:
+  TiXmlParseOptions()
+    : encoding( TIXML_DEFAULT_ENCODING ), condenseWhiteSpace( true ), tabSize( 4 ), trackLocation( false ),
+      maxMemory( 0 ), maxNodes( 0 ), maxDepth( 0 ), maxAttributes( 0 ), maxStringLength( 0 ) {}
+
+  /* 文档的编码。TIXML_ENCODING_UNKNOWN时由声明和BOM决定 */
+  void SetEncoding( TiXmlEncoding _encoding )   { encoding = _encoding; }
+  TiXmlEncoding Encoding() const                { return encoding; }
+
+  /* 文本中连续的空白是否合并成一个' '，默认合并。
+   * 如：<school>沈  阳  工  业  大  学</school>实际显示为<school>沈 阳 工 业 大 学</school>
+   */
+  void SetCondenseWhiteSpace( bool condense )   { condenseWhiteSpace = condense; }
+  bool IsWhiteSpaceCondensed() const            { return condenseWhiteSpace; }
+
+  /* 计算列号时一个'\t'占几列，默认4 */
+  void SetTabSize( int _tabSize )               { tabSize = _tabSize; }
+  int TabSize() const                           { return tabSize; }
+
+  /* 是否记录节点的行列号(Row()、Column())，默认不记录，解析时只记下字节偏移。
+   * 打开后解析结束时再扫描一遍输入建立行索引(TiXmlLineIndex)，不打开时节点的行列号是0。
+   * 错误的行列号(ErrorRow())不受影响，总是在出错时计算。TabSize()小于1时两者都不记录
+   */
+  void SetTrackLocation( bool track )           { trackLocation = track; }
+  bool TrackLocation() const                    { return trackLocation && tabSize >= 1; }
+
+  /* 解析不可信的输入时的资源限制，0表示不限制(默认)。限制在建立节点的过程中检查，
+   * 超过时解析马上停止，错误码是TIXML_ERROR_MEMORY_LIMIT等，行列号指向超限的节点、属性或字符串的开头。
+   * 设置了任何一项限制时不做并行解析(SetParseThreads())
+   */
+  /* 节点、属性和它们的字符串占用的内存，算法和TiXmlDocument::BytesUsed()相同，不包括输入本身 */
+  void SetMaxMemory( size_t bytes )             { maxMemory = bytes; }
+  size_t MaxMemory() const                      { return maxMemory; }
+  /* 节点的个数 */
+  void SetMaxNodes( size_t count )              { maxNodes = count; }
+  size_t MaxNodes() const                       { return maxNodes; }
+  /* 元素的嵌套层数，文档的直接子元素是第1层 */
+  void SetMaxDepth( int depth )                 { maxDepth = depth; }
+  int MaxDepth() const                          { return maxDepth; }
+  /* 每个元素的属性个数 */
+  void SetMaxAttributes( int count )            { maxAttributes = count; }
+  int MaxAttributes() const                     { return maxAttributes; }
+  /* 元素名、属性名、属性值和文本的长度(字节)。就地解析时按解码前的长度计算 */
+  void SetMaxStringLength( size_t length )      { maxStringLength = length; }
+  size_t MaxStringLength() const                { return maxStringLength; }
+
+  bool HasLimits() const
+  {
+    return maxMemory || maxNodes || maxDepth > 0 || maxAttributes > 0 || maxStringLength;
+  }
+
+private:
+  TiXmlEncoding encoding;
+  bool  condenseWhiteSpace;
+  int   tabSize;
+  bool  trackLocation;
+  size_t  maxMemory;
+  size_t  maxNodes;
+  int     maxDepth;
+  int     maxAttributes;
+  size_t  maxStringLength;
+};
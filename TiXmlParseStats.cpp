@@ -0,0 +1,228 @@
+/* 类 */
+
+/* 统计默认不编译进来。定义TIXML_USE_STATS以后，解析和分配的路径上只多几次线程局部计数器的自增，
+ * 计时只在文档挂了统计对象(TiXmlDocument::SetStats())时才做
+ */
+#if defined( _WIN32 )
+  #include <windows.h>
+#else
+  #include <time.h>
+#endif
+
+/* 解析统计。挂到文档上以后，LoadFile()、LoadFileMapped()、Parse()和SaveFile()把各自的数据累加进来，
+ * 直到Reset()。一个统计对象可以挂在几个文档上汇总，但不能同时在几个线程中使用：
+ *
+ *   TiXmlParseStats stats;
+ *   document.SetStats( &stats );
+ *   document.LoadFile( "feed.xml" );
+ *   stats.Print( stderr );
+ *
+ * 需要定义TIXML_USE_STATS，否则接口还在，但什么都不记录。
+ * 节点个数、属性个数和最大深度也在解析时累计，不再遍历树；出错时包括出错之前解析出的节点。
+ * 分配次数只包括节点和属性(TiXmlBase::operator new)，不包括字符串自己的内存
+ */
+class TiXmlParseStats
+{
+  friend class TiXmlDocument;
+public:
+  TiXmlParseStats() { Reset(); }
+
+  void Reset();
+
+  /* 从文件读入的字节数和交给解析器的字节数 */
+  size_t BytesRead() const            { return bytesRead; }
+  size_t BytesParsed() const          { return bytesParsed; }
+
+  /* 读文件、规范化换行符、解析和保存各用了多少秒 */
+  double IoSeconds() const            { return ioSeconds; }
+  double NormalizeSeconds() const     { return normalizeSeconds; }
+  double ParseSeconds() const         { return parseSeconds; }
+  double SaveSeconds() const          { return saveSeconds; }
+
+  /* 某一类型(TiXmlNode::NodeType)的节点个数，以及所有节点的个数 */
+  unsigned long Nodes( int type ) const;
+  unsigned long NodeCount() const;
+  unsigned long Attributes() const    { return attributes; }
+  /* 解码的实体引用和字符引用。不认识的实体引用原样保留，不算在内 */
+  unsigned long Entities() const      { return entities; }
+  unsigned long Allocations() const   { return allocations; }
+  size_t BytesAllocated() const       { return bytesAllocated; }
+  /* 最深的节点在第几层，文档的直接子节点是第1层 */
+  int MaxDepth() const                { return maxDepth; }
+
+  /* 调用了几次 */
+  unsigned long Parses() const        { return parses; }
+  unsigned long Saves() const         { return saves; }
+
+  /* 每项一行 */
+  void Print( FILE* cfile ) const;
+
+  /* 单调时钟，单位是秒 */
+  static double Now();
+
+#ifdef TIXML_USE_STATS
+  /* [internal use] 每个线程自己的计数器，只增不减。解析前后各取一次，差就是这次解析的数量。
+   * depth和maxDepth例外：depth是正在解析的元素有几层，maxDepth是新节点所在层数的最大值，由Begin()重新开始
+   */
+  struct Counters
+  {
+    unsigned long entities;
+    unsigned long allocations;
+    size_t        bytesAllocated;
+    unsigned long nodes[ TiXmlNode::TINYXML_TYPECOUNT ];
+    unsigned long attributes;
+    int           depth;
+    int           maxDepth;
+  };
+  static TIXML_THREAD_LOCAL Counters counters;
+
+  /* [internal use] 解析出一个节点，它在当前元素的下一层 */
+  static void CountNode( int type )
+  {
+    ++counters.nodes[ type ];
+    if ( counters.depth + 1 > counters.maxDepth )
+      counters.maxDepth = counters.depth + 1;
+  }
+  /* [internal use] 开始一次解析的统计，返回现在的计数 */
+  static Counters Begin();
+  /* [internal use] before以来的增量，maxDepth取现在的值 */
+  static Counters Since( const Counters& before );
+  /* [internal use] 别的线程的增量并到当前线程 */
+  static void Merge( const Counters& delta );
+#endif
+
+private:
+#ifdef TIXML_USE_STATS
+  /* 一次解析的增量累加进来 */
+  void Add( const Counters& delta );
+#endif
+
+  size_t        bytesRead;
+  size_t        bytesParsed;
+  double        ioSeconds;
+  double        normalizeSeconds;
+  double        parseSeconds;
+  double        saveSeconds;
+  unsigned long nodes[ TiXmlNode::TINYXML_TYPECOUNT ];
+  unsigned long attributes;
+  unsigned long entities;
+  unsigned long allocations;
+  size_t        bytesAllocated;
+  int           maxDepth;
+  unsigned long parses;
+  unsigned long saves;
+};
+
+/* 方法 */
+
+#ifdef TIXML_USE_STATS
+TIXML_THREAD_LOCAL TiXmlParseStats::Counters TiXmlParseStats::counters;
+
+TiXmlParseStats::Counters TiXmlParseStats::Begin()
+{
+  counters.maxDepth = counters.depth;
+  return counters;
+}
+
+TiXmlParseStats::Counters TiXmlParseStats::Since( const Counters& before )
+{
+  Counters delta;
+  delta.entities = counters.entities - before.entities;
+  delta.allocations = counters.allocations - before.allocations;
+  delta.bytesAllocated = counters.bytesAllocated - before.bytesAllocated;
+  for ( int i = 0; i < TiXmlNode::TINYXML_TYPECOUNT; ++i )
+    delta.nodes[i] = counters.nodes[i] - before.nodes[i];
+  delta.attributes = counters.attributes - before.attributes;
+  delta.depth = 0;
+  delta.maxDepth = counters.maxDepth;
+  return delta;
+}
+
+void TiXmlParseStats::Merge( const Counters& delta )
+{
+  counters.entities += delta.entities;
+  counters.allocations += delta.allocations;
+  counters.bytesAllocated += delta.bytesAllocated;
+  for ( int i = 0; i < TiXmlNode::TINYXML_TYPECOUNT; ++i )
+    counters.nodes[i] += delta.nodes[i];
+  counters.attributes += delta.attributes;
+  if ( delta.maxDepth > counters.maxDepth )
+    counters.maxDepth = delta.maxDepth;
+}
+
+void TiXmlParseStats::Add( const Counters& delta )
+{
+  entities += delta.entities;
+  allocations += delta.allocations;
+  bytesAllocated += delta.bytesAllocated;
+  for ( int i = 0; i < TiXmlNode::TINYXML_TYPECOUNT; ++i )
+    nodes[i] += delta.nodes[i];
+  attributes += delta.attributes;
+  if ( delta.maxDepth > maxDepth )
+    maxDepth = delta.maxDepth;
+}
+#endif
+
+void TiXmlParseStats::Reset()
+{
+  bytesRead = bytesParsed = 0;
+  ioSeconds = normalizeSeconds = parseSeconds = saveSeconds = 0;
+  memset( nodes, 0, sizeof( nodes ) );
+  attributes = entities = allocations = 0;
+  bytesAllocated = 0;
+  maxDepth = 0;
+  parses = saves = 0;
+}
+
+unsigned long TiXmlParseStats::Nodes( int type ) const
+{
+  return ( type >= 0 && type < TiXmlNode::TINYXML_TYPECOUNT ) ? nodes[type] : 0;
+}
+
+unsigned long TiXmlParseStats::NodeCount() const
+{
+  unsigned long total = 0;
+  for ( int i = 0; i < TiXmlNode::TINYXML_TYPECOUNT; ++i )
+    total += nodes[i];
+  return total;
+}
+
+double TiXmlParseStats::Now()
+{
+#if defined( _WIN32 )
+  LARGE_INTEGER frequency, counter;
+  QueryPerformanceFrequency( &frequency );
+  QueryPerformanceCounter( &counter );
+  return (double)counter.QuadPart / (double)frequency.QuadPart;
+#elif defined( CLOCK_MONOTONIC )
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+#else
+  return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+void TiXmlParseStats::Print( FILE* cfile ) const
+{
+  static const char* const names[ TiXmlNode::TINYXML_TYPECOUNT ] =
+  {
+    "documents", "elements", "comments", "unknowns", "texts", "declarations"
+  };
+
+  fprintf( cfile, "bytes read         %lu\n", (unsigned long)bytesRead );
+  fprintf( cfile, "bytes parsed       %lu\n", (unsigned long)bytesParsed );
+  fprintf( cfile, "io seconds         %.6f\n", ioSeconds );
+  fprintf( cfile, "normalize seconds  %.6f\n", normalizeSeconds );
+  fprintf( cfile, "parse seconds      %.6f\n", parseSeconds );
+  fprintf( cfile, "save seconds       %.6f\n", saveSeconds );
+  for ( int i = 0; i < TiXmlNode::TINYXML_TYPECOUNT; ++i )
+    fprintf( cfile, "%-18s %lu\n", names[i], nodes[i] );
+  fprintf( cfile, "attributes         %lu\n", attributes );
+  fprintf( cfile, "entities           %lu\n", entities );
+  fprintf( cfile, "allocations        %lu\n", allocations );
+  fprintf( cfile, "bytes allocated    %lu\n", (unsigned long)bytesAllocated );
+  fprintf( cfile, "max depth          %d\n", maxDepth );
+  fprintf( cfile, "parses             %lu\n", parses );
+  fprintf( cfile, "saves              %lu\n", saves );
+}
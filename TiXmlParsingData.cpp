@@ -0,0 +1,253 @@
+/* 类 */
+
+/* 解析过程中的位置。节点只用Offset()记下字节偏移，行列号由文档的TiXmlLineIndex按需计算。
+ * Stamp()从上一次记录的位置扫描到now，累加经过的行数和列数，只在出错时使用，TiXmlLineIndex按同样的规则换算。
+ * 同时带着这次解析的选项，各个Parse()从这里读取，而不是读全局的设置
+ */
+class TiXmlParsingData
+{
+  friend class TiXmlDocument;
+  friend class TiXmlParallelParser;
+  friend class TiXmlIncrementalParser;
+public:
+  void Stamp( const char* now, TiXmlEncoding encoding );
+
+  /* p相对于这次解析开头的字节偏移 */
+  size_t Offset( const char* p ) const { return p - start; }
+  /* 这次解析的编号，每次解析都不同。节点和偏移一起记下，文档的行索引只换算同一次解析的偏移 */
+  int Generation() const { return generation; }
+
+  const TiXmlCursor& Cursor() const { return cursor; }
+  const TiXmlParseOptions& Options() const { return options; }
+
+  /* 资源限制(TiXmlParseOptions::SetMaxNodes()等)的记账。超过限制时返回对应的错误码，否则返回TIXML_NO_ERROR。
+   * 没有设置限制时Limited()为false，调用处直接跳过
+   */
+  bool Limited() const { return limited; }
+  /* 新建一个size字节的节点。element为true时还检查嵌套层数 */
+  int AddNode( size_t size, bool element );
+  /* 给元素加上第count个属性 */
+  int AddAttribute( int count, size_t size );
+  /* 解析出一个长度为length的字符串，占用size字节 */
+  int AddString( size_t length, size_t size );
+  /* 进入、离开一个元素的内容 */
+  void EnterElement() { ++depth; }
+  void LeaveElement() { --depth; }
+  /* 分段解析中还没收完的原文：正在读的字符串已经有length个字节，缓冲区占用size字节。
+   * 只检查不记账，这些内存在解析出节点以后就还回去了
+   */
+  int CheckPending( size_t length, size_t size ) const;
+  /* 下一个字符串最多还能有多长，再长AddString()一定失败，作为ReadText()的maxLength。
+   * copied为false时字符串只引用缓冲区(就地解析)，不受内存限制
+   */
+  size_t StringBudget( bool copied ) const;
+
+  /* 解码前的原文最多是解码后的几倍：最长的预定义实体引用"&quot;"和"&apos;"是6个字节 */
+  enum { MAX_RAW_RATIO = 6 };
+
+private:
+  /* 只有TiXmlDocument可以创建 */
+  TiXmlParsingData( const char* _start, const TiXmlParseOptions& _options, int row, int col )
+    : options( _options )
+  {
+    assert( _start );
+    start = _start;
+    stamp = _start;
+    tabsize = options.TabSize();
+    track = ( tabsize >= 1 );
+    cursor.row = row;
+    cursor.col = col;
+    limited = options.HasLimits();
+    nodes = 0;
+    bytes = 0;
+    depth = 0;
+    generation = (int)NextGeneration();
+  }
+
+  /* 从1开始的全局计数，几个线程同时解析时也不重复 */
+  static long NextGeneration();
+
+  TiXmlParseOptions options;
+  TiXmlCursor   cursor;
+  const char*   start;    /* 这次解析的开头 */
+  const char*   stamp;    /* 上一次记录的位置 */
+  int           tabsize;  /* 一个'\t'占几列 */
+  bool          track;    /* TabSize()小于1时不计算行列 */
+
+  bool          limited;
+  size_t        nodes;    /* 已经建立的节点数 */
+  size_t        bytes;    /* 已经建立的节点、属性和字符串的内存 */
+  int           depth;    /* 当前所在元素的层数，文档下面是0 */
+  int           generation;
+};
+
+/* 方法 */
+
+long TiXmlParsingData::NextGeneration()
+{
+  static volatile long last = 0;
+#if defined( __GNUC__ )
+  return __sync_add_and_fetch( &last, 1 );
+#elif defined( _MSC_VER )
+  return _InterlockedIncrement( &last );
+#else
+  return ++last;
+#endif
+}
+
+int TiXmlParsingData::AddNode( size_t size, bool element )
+{
+  if ( options.MaxNodes() && ++nodes > options.MaxNodes() )
+    return TiXmlBase::TIXML_ERROR_NODE_LIMIT;
+  if ( element && options.MaxDepth() > 0 && depth >= options.MaxDepth() )
+    return TiXmlBase::TIXML_ERROR_DEPTH_LIMIT;
+  bytes += size;
+  if ( options.MaxMemory() && bytes > options.MaxMemory() )
+    return TiXmlBase::TIXML_ERROR_MEMORY_LIMIT;
+  return TiXmlBase::TIXML_NO_ERROR;
+}
+
+int TiXmlParsingData::AddAttribute( int count, size_t size )
+{
+  if ( options.MaxAttributes() > 0 && count > options.MaxAttributes() )
+    return TiXmlBase::TIXML_ERROR_ATTRIBUTE_LIMIT;
+  bytes += size;
+  if ( options.MaxMemory() && bytes > options.MaxMemory() )
+    return TiXmlBase::TIXML_ERROR_MEMORY_LIMIT;
+  return TiXmlBase::TIXML_NO_ERROR;
+}
+
+int TiXmlParsingData::AddString( size_t length, size_t size )
+{
+  if ( options.MaxStringLength() && length > options.MaxStringLength() )
+    return TiXmlBase::TIXML_ERROR_STRING_LIMIT;
+  bytes += size;
+  if ( options.MaxMemory() && bytes > options.MaxMemory() )
+    return TiXmlBase::TIXML_ERROR_MEMORY_LIMIT;
+  return TiXmlBase::TIXML_NO_ERROR;
+}
+
+int TiXmlParsingData::CheckPending( size_t length, size_t size ) const
+{
+  if ( options.MaxStringLength() && length / MAX_RAW_RATIO > options.MaxStringLength() )
+    return TiXmlBase::TIXML_ERROR_STRING_LIMIT;
+  if ( options.MaxMemory() && bytes + size > options.MaxMemory() )
+    return TiXmlBase::TIXML_ERROR_MEMORY_LIMIT;
+  return TiXmlBase::TIXML_NO_ERROR;
+}
+
+size_t TiXmlParsingData::StringBudget( bool copied ) const
+{
+  size_t budget = options.MaxStringLength() ? options.MaxStringLength() : (size_t)-1;
+  if ( copied && options.MaxMemory() )
+  {
+    /* 长度为length的字符串占用length + 1个字节 */
+    size_t left = bytes < options.MaxMemory() ? options.MaxMemory() - bytes - 1 : 0;
+    if ( left < budget )
+      budget = left;
+  }
+  return budget;
+}
+
+/* 换行符按XML的规则计算："\r\n"和单独的'\r'都算一个换行。
+ * LoadFileMapped()没有预先把'\r'换成'\n'，这里的计算结果必须和预先替换过的缓冲区一样
+ */
+void TiXmlParsingData::Stamp( const char* now, TiXmlEncoding encoding )
+{
+  assert( now );
+
+  if ( !track )
+  {
+    return;
+  }
+
+  int row = cursor.row;
+  int col = cursor.col;
+  const char* p = stamp;
+  assert( p );
+
+  while ( p < now )
+  {
+    const unsigned char* pU = (const unsigned char*)p;
+
+    switch (*pU) {
+      case 0:
+        /* 不会走到这里，以防万一，不能越过结尾的'\0' */
+        return;
+
+      case '\r':
+        /* 换到下一行，"\r\n"只算一次 */
+        ++row;
+        col = 0;
+        ++p;
+        if (*p == '\n') {
+          ++p;
+        }
+        break;
+
+      case '\n':
+        /* 换到下一行。"\n\r"是两个换行，后面的'\r'由下一轮处理 */
+        ++row;
+        col = 0;
+        ++p;
+        break;
+
+      case '\t':
+        ++p;
+        /* 跳到下一个制表位 */
+        col = (col / tabsize + 1) * tabsize;
+        break;
+
+      case TIXML_UTF_LEAD_0:
+        if ( encoding == TIXML_ENCODING_UTF8 )
+        {
+          if ( *(p+1) && *(p+2) )
+          {
+            /* BOM等零宽字符不占列 */
+            if ( *(pU+1)==TIXML_UTF_LEAD_1 && *(pU+2)==TIXML_UTF_LEAD_2 )
+              p += 3;
+            else if ( *(pU+1)==0xbfU && *(pU+2)==0xbeU )
+              p += 3;
+            else if ( *(pU+1)==0xbfU && *(pU+2)==0xbfU )
+              p += 3;
+            else
+              { p +=3; ++col; }
+          }
+          else
+          {
+            /* 不完整的字符，不能停在原地 */
+            ++p;
+            ++col;
+          }
+        }
+        else
+        {
+          ++p;
+          ++col;
+        }
+        break;
+
+      default:
+        if ( encoding == TIXML_ENCODING_UTF8 )
+        {
+          /* 一个UTF-8字符占1到4个字节，只算一列 */
+          int step = TiXmlBase::utf8ByteTable[*((const unsigned char*)p)];
+          if ( step == 0 )
+            step = 1;
+          p += step;
+          ++col;
+        }
+        else
+        {
+          ++p;
+          ++col;
+        }
+        break;
+    }
+  }
+  cursor.row = row;
+  cursor.col = col;
+  assert( cursor.row >= -1 );
+  assert( cursor.col >= -1 );
+  stamp = p;
+}
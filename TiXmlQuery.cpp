@@ -0,0 +1,290 @@
+/* 类 */
+
+/* 编译好的路径查询，支持XPath的一个子集：
+ *   /a/b        从文档开始的绝对路径        a/b、./a/b  从给定节点开始的相对路径
+ *   //b、a//b   任意层的后代                *           任意元素
+ *   b[@id]      有id属性                    b[@id='3']、b[@id!="3"]  属性等于/不等于
+ *   b[2]        同一个父节点下第2个符合条件的b(从1开始)，和前面的谓词一起计数：b[@id][2]是有id的第2个b
+ * 只匹配元素。表达式只解析一次，编译结果是只读的，可以反复使用，也可以在几个线程中同时使用：
+ *
+ *   static TiXmlQuery query( "items/item[@type='book']" );
+ *   TiXmlQueryIterator it( query, root );
+ *   while ( TiXmlElement* item = it.Next() )
+ *     ...
+ *
+ * 结果由TiXmlQueryIterator逐个求出，不需要的结果不会被计算；同一个节点只返回一次。
+ * 名字比较使用文档的名字表(TiXmlDocument::UseNameTable())，按属性名查找使用元素的属性索引
+ */
+class TiXmlQuery
+{
+  friend class TiXmlQueryIterator;
+public:
+  TiXmlQuery();
+  /* 编译expression，失败时Valid()返回false */
+  explicit TiXmlQuery( const char* expression );
+  ~TiXmlQuery();
+
+  /* 编译expression，替换原来的查询。语法错误时返回false，ErrorOffset()是出错的位置 */
+  bool Compile( const char* expression );
+  bool Valid() const        { return stepCount > 0; }
+  int ErrorOffset() const   { return errorOffset; }
+
+  /* 第一个结果，没有时返回0 */
+  const TiXmlElement* First( const TiXmlNode* node ) const;
+  TiXmlElement* First( TiXmlNode* node ) const
+  {
+    return const_cast< TiXmlElement* >( First( const_cast< const TiXmlNode* >( node ) ) );
+  }
+  /* 结果的个数 */
+  size_t Count( const TiXmlNode* node ) const;
+
+  enum
+  {
+    MAX_STEPS = 16,       /* 一个路径最多几步 */
+    MAX_PREDICATES = 4    /* 每一步最多几个谓词 */
+  };
+
+private:
+  /* 不允许拷贝 */
+  TiXmlQuery( const TiXmlQuery& );
+  void operator=( const TiXmlQuery& );
+
+  enum Axis
+  {
+    AXIS_CHILD,
+    AXIS_DESCENDANT
+  };
+
+  enum PredicateKind
+  {
+    PREDICATE_POSITION,         /* [n] */
+    PREDICATE_HAS_ATTRIBUTE,    /* [@name] */
+    PREDICATE_ATTRIBUTE_EQUALS, /* [@name='value'] */
+    PREDICATE_ATTRIBUTE_DIFFERS /* [@name!='value'] */
+  };
+
+  struct Predicate
+  {
+    PredicateKind kind;
+    int           position;
+    const char*   name;     /* 都指向text */
+    const char*   value;
+  };
+
+  struct Step
+  {
+    Axis        axis;
+    const char* name;       /* 指向text，*时为0 */
+    int         predicateCount;
+    Predicate   predicates[ MAX_PREDICATES ];
+    bool        unique;     /* 这一步的上下文可能互相嵌套，需要去重 */
+  };
+
+  void Reset();
+  /* 读名字，返回名字的结尾，没有名字时返回0 */
+  static const char* ReadName( const char* p );
+  static const char* SkipSpace( const char* p );
+  bool Fail( const char* p );
+
+  char*   text;             /* expression的拷贝，名字和值的结尾补了'\0' */
+  bool    absolute;         /* 从文档开始 */
+  int     stepCount;
+  Step    steps[ MAX_STEPS ];
+  int     errorOffset;
+};
+
+/* 方法 */
+
+TiXmlQuery::TiXmlQuery() : text( 0 )
+{
+  Reset();
+}
+
+TiXmlQuery::TiXmlQuery( const char* _expression ) : text( 0 )
+{
+  Compile( _expression );
+}
+
+TiXmlQuery::~TiXmlQuery()
+{
+  delete [] text;
+}
+
+void TiXmlQuery::Reset()
+{
+  delete [] text;
+  text = 0;
+  absolute = false;
+  stepCount = 0;
+  errorOffset = -1;
+}
+
+bool TiXmlQuery::Fail( const char* p )
+{
+  const int offset = (int)( p - text );
+  Reset();
+  errorOffset = offset;
+  return false;
+}
+
+const char* TiXmlQuery::SkipSpace( const char* p )
+{
+  while ( *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' )
+    ++p;
+  return p;
+}
+
+/* 名字到下一个分隔符为止 */
+const char* TiXmlQuery::ReadName( const char* p )
+{
+  const char* start = p;
+  while ( *p && !strchr( "/[]@=!'\"* \t\r\n", *p ) )
+    ++p;
+  return p != start ? p : 0;
+}
+
+/* 先记下每个名字和值的结尾，整个表达式解析完以后再补'\0'，补早了会覆盖后面的分隔符 */
+bool TiXmlQuery::Compile( const char* _expression )
+{
+  Reset();
+  const size_t length = strlen( _expression );
+  text = new char[ length + 1 ];
+  memcpy( text, _expression, length + 1 );
+
+  char* ends[ MAX_STEPS * ( MAX_PREDICATES * 2 + 1 ) ];
+  int endCount = 0;
+
+  /* 相对路径的第一步前面没有'/' */
+  const char* p = SkipSpace( text );
+  bool slash = true;
+  if ( *p == '/' )
+    absolute = true;
+  else if ( p[0] == '.' && p[1] == '/' )
+    ++p;
+  else
+    slash = false;
+
+  while ( *p )
+  {
+    if ( stepCount == MAX_STEPS )
+      return Fail( p );
+    Step& step = steps[ stepCount ];
+    step.axis = AXIS_CHILD;
+    step.predicateCount = 0;
+
+    if ( slash )
+    {
+      if ( *p != '/' )
+        return Fail( p );
+      ++p;
+      if ( *p == '/' )
+      {
+        step.axis = AXIS_DESCENDANT;
+        ++p;
+      }
+    }
+    slash = true;
+
+    if ( *p == '*' )
+    {
+      step.name = 0;
+      ++p;
+    }
+    else
+    {
+      const char* end = ReadName( p );
+      if ( !end )
+        return Fail( p );
+      step.name = p;
+      ends[ endCount++ ] = text + ( end - text );
+      p = end;
+    }
+
+    while ( *p == '[' )
+    {
+      if ( step.predicateCount == MAX_PREDICATES )
+        return Fail( p );
+      Predicate& predicate = step.predicates[ step.predicateCount++ ];
+      p = SkipSpace( p + 1 );
+      if ( *p >= '0' && *p <= '9' )
+      {
+        predicate.kind = PREDICATE_POSITION;
+        predicate.position = 0;
+        while ( *p >= '0' && *p <= '9' )
+        {
+          predicate.position = predicate.position * 10 + ( *p - '0' );
+          if ( predicate.position > 100000000 )
+            return Fail( p );
+          ++p;
+        }
+        if ( predicate.position == 0 )
+          return Fail( p );
+      }
+      else if ( *p == '@' )
+      {
+        const char* end = ReadName( p + 1 );
+        if ( !end )
+          return Fail( p + 1 );
+        predicate.kind = PREDICATE_HAS_ATTRIBUTE;
+        predicate.name = p + 1;
+        ends[ endCount++ ] = text + ( end - text );
+        p = SkipSpace( end );
+
+        if ( *p == '=' || ( p[0] == '!' && p[1] == '=' ) )
+        {
+          predicate.kind = ( *p == '=' ) ? PREDICATE_ATTRIBUTE_EQUALS : PREDICATE_ATTRIBUTE_DIFFERS;
+          p = SkipSpace( p + ( *p == '=' ? 1 : 2 ) );
+          const char quote = *p;
+          if ( quote != '\'' && quote != '\"' )
+            return Fail( p );
+          const char* close = strchr( p + 1, quote );
+          if ( !close )
+            return Fail( p );
+          predicate.value = p + 1;
+          ends[ endCount++ ] = text + ( close - text );
+          p = close + 1;
+        }
+      }
+      else
+        return Fail( p );
+
+      p = SkipSpace( p );
+      if ( *p != ']' )
+        return Fail( p );
+      ++p;
+    }
+    ++stepCount;
+    p = SkipSpace( p );
+  }
+
+  if ( stepCount == 0 )
+    return Fail( p );
+
+  for ( int i = 0; i < endCount; ++i )
+    *ends[i] = 0;
+
+  /* 前面有过后代轴时，这一步的上下文可能一个套在另一个里面 */
+  bool descendant = false;
+  for ( int i = 0; i < stepCount; ++i )
+  {
+    steps[i].unique = descendant && steps[i].axis == AXIS_DESCENDANT;
+    if ( steps[i].axis == AXIS_DESCENDANT )
+      descendant = true;
+  }
+  return true;
+}
+
+const TiXmlElement* TiXmlQuery::First( const TiXmlNode* node ) const
+{
+  TiXmlQueryIterator it( *this, const_cast< TiXmlNode* >( node ) );
+  return it.Next();
+}
+
+size_t TiXmlQuery::Count( const TiXmlNode* node ) const
+{
+  TiXmlQueryIterator it( *this, const_cast< TiXmlNode* >( node ) );
+  size_t count = 0;
+  while ( it.Next() )
+    ++count;
+  return count;
+}
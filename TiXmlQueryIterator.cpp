@@ -0,0 +1,248 @@
+/* 类 */
+
+/* 在node上执行一个TiXmlQuery，每次Next()求出下一个结果，没有了返回0。
+ * 每一步保存一个Frame：这一步的上下文节点、正在检查哪个父节点的哪个子节点，以及位置谓词的计数，
+ * 所以求下一个结果时从上次停下的地方接着走，不需要先把所有结果收集起来。
+ * 迭代过程中不能修改这棵树；query要比迭代器活得更久
+ */
+class TiXmlQueryIterator
+{
+public:
+  TiXmlQueryIterator( const TiXmlQuery& query, TiXmlNode* node );
+  ~TiXmlQueryIterator();
+
+  TiXmlElement* Next();
+
+private:
+  /* 不允许拷贝 */
+  TiXmlQueryIterator( const TiXmlQueryIterator& );
+  void operator=( const TiXmlQueryIterator& );
+
+  enum Result
+  {
+    SKIP,     /* 这个节点不匹配 */
+    MATCH,
+    DONE      /* 这个父节点下剩下的子节点都不会匹配了 */
+  };
+
+  struct Frame
+  {
+    TiXmlNode*  root;       /* 这一步的上下文 */
+    TiXmlNode*  parent;     /* 正在检查它的子节点，child轴时就是root */
+    TiXmlNode*  child;      /* 下一个要检查的子节点 */
+    int         counts[ TiXmlQuery::MAX_PREDICATES ];
+  };
+
+  /* 一个已经处理过的上下文。后代轴的上下文互相嵌套时，里面的那个不用再处理 */
+  struct Entry
+  {
+    const TiXmlNode*  node;
+    int               level;
+  };
+
+  bool Enter( int level, TiXmlNode* context );
+  TiXmlElement* Advance( int level );
+  Result Test( int level, TiXmlNode* node );
+  /* root子树中node的下一个节点(先序)，descend为false时跳过node的子树 */
+  static TiXmlNode* NextParent( TiXmlNode* node, const TiXmlNode* root, bool descend );
+
+  bool Seen( int level, const TiXmlNode* node ) const;
+  void Remember( int level, const TiXmlNode* node );
+  static size_t Hash( const TiXmlNode* node, int level )
+  {
+    return ( (size_t)node / sizeof( void* ) ) ^ ( (size_t)level * 0x9e3779b9u );
+  }
+
+  const TiXmlQuery& query;
+  int         depth;        /* 正在执行第几步，-1表示结束 */
+  Frame       frames[ TiXmlQuery::MAX_STEPS ];
+  const TiXmlNameTable* names;                    /* 文档的名字表 */
+  const char* interned[ TiXmlQuery::MAX_STEPS ];  /* 每一步的名字在names中的那一份 */
+
+  Entry*      seen;         /* 开放定址，只有路径中有两个以上的//时才会用到 */
+  size_t      seenCount;
+  size_t      seenCapacity;
+};
+
+/* 方法 */
+
+/* 名字在这里查一次名字表，之后名字表中的节点只比较指针 */
+TiXmlQueryIterator::TiXmlQueryIterator( const TiXmlQuery& _query, TiXmlNode* node )
+  : query( _query ), depth( -1 ), names( 0 ), seen( 0 ), seenCount( 0 ), seenCapacity( 0 )
+{
+  if ( !query.Valid() || !node )
+    return;
+
+  TiXmlNode* start = node;
+  if ( query.absolute )
+  {
+    while ( start->Parent() )
+      start = start->Parent();
+  }
+
+  const TiXmlDocument* document = start->GetDocument();
+  names = document ? document->NameTable() : 0;
+  for ( int i = 0; i < query.stepCount; ++i )
+    interned[i] = ( names && query.steps[i].name ) ? names->Find( query.steps[i].name ) : 0;
+
+  depth = 0;
+  Enter( 0, start );
+}
+
+TiXmlQueryIterator::~TiXmlQueryIterator()
+{
+  delete [] seen;
+}
+
+TiXmlElement* TiXmlQueryIterator::Next()
+{
+  const int last = query.stepCount - 1;
+  while ( depth >= 0 )
+  {
+    TiXmlElement* match = Advance( depth );
+    if ( !match )
+    {
+      --depth;
+      continue;
+    }
+    if ( depth == last )
+      return match;
+    if ( Enter( depth + 1, match ) )
+      ++depth;
+  }
+  return 0;
+}
+
+bool TiXmlQueryIterator::Enter( int level, TiXmlNode* context )
+{
+  if ( query.steps[level].unique )
+  {
+    for ( const TiXmlNode* node = context; node; node = node->Parent() )
+    {
+      if ( Seen( level, node ) )
+        return false;
+    }
+    Remember( level, context );
+  }
+
+  Frame& frame = frames[level];
+  frame.root = frame.parent = context;
+  frame.child = context->FirstChild();
+  memset( frame.counts, 0, sizeof( frame.counts ) );
+  return true;
+}
+
+TiXmlElement* TiXmlQueryIterator::Advance( int level )
+{
+  const TiXmlQuery::Step& step = query.steps[level];
+  Frame& frame = frames[level];
+  for ( ;; )
+  {
+    while ( frame.child )
+    {
+      TiXmlNode* node = frame.child;
+      frame.child = node->NextSibling();
+      const Result result = Test( level, node );
+      if ( result == MATCH )
+        return static_cast< TiXmlElement* >( node );
+      if ( result == DONE )
+        frame.child = 0;
+    }
+    if ( step.axis == TiXmlQuery::AXIS_CHILD )
+      return 0;
+
+    /* 后代轴：按先序换到下一个有子节点的父节点，已经作为上下文处理过的子树整个跳过 */
+    TiXmlNode* parent = NextParent( frame.parent, frame.root, true );
+    while ( parent && ( !parent->FirstChild() || ( step.unique && Seen( level, parent ) ) ) )
+      parent = NextParent( parent, frame.root, false );
+    if ( !parent )
+      return 0;
+
+    frame.parent = parent;
+    frame.child = parent->FirstChild();
+    memset( frame.counts, 0, sizeof( frame.counts ) );
+  }
+}
+
+/* 谓词按顺序检查，位置谓词只数通过了前面所有条件的兄弟节点 */
+TiXmlQueryIterator::Result TiXmlQueryIterator::Test( int level, TiXmlNode* node )
+{
+  if ( node->Type() != TiXmlNode::TINYXML_ELEMENT )
+    return SKIP;
+  const TiXmlQuery::Step& step = query.steps[level];
+  if ( step.name && !node->ValueIs( step.name, names, interned[level] ) )
+    return SKIP;
+
+  const TiXmlElement* element = static_cast< const TiXmlElement* >( node );
+  for ( int i = 0; i < step.predicateCount; ++i )
+  {
+    const TiXmlQuery::Predicate& predicate = step.predicates[i];
+    if ( predicate.kind == TiXmlQuery::PREDICATE_POSITION )
+    {
+      /* 计数只增不减，超过以后这个父节点下不会再有匹配的 */
+      int& count = frames[level].counts[i];
+      if ( ++count != predicate.position )
+        return count > predicate.position ? DONE : SKIP;
+      continue;
+    }
+
+    const TiXmlAttribute* attribute = element->attributeSet.Find( predicate.name );
+    if ( !attribute )
+      return SKIP;
+    if ( predicate.kind == TiXmlQuery::PREDICATE_ATTRIBUTE_EQUALS && strcmp( attribute->Value(), predicate.value ) != 0 )
+      return SKIP;
+    if ( predicate.kind == TiXmlQuery::PREDICATE_ATTRIBUTE_DIFFERS && strcmp( attribute->Value(), predicate.value ) == 0 )
+      return SKIP;
+  }
+  return MATCH;
+}
+
+TiXmlNode* TiXmlQueryIterator::NextParent( TiXmlNode* node, const TiXmlNode* root, bool descend )
+{
+  if ( descend && node->FirstChild() )
+    return node->FirstChild();
+  while ( node != root && !node->NextSibling() )
+    node = node->Parent();
+  return ( node != root ) ? node->NextSibling() : 0;
+}
+
+bool TiXmlQueryIterator::Seen( int level, const TiXmlNode* node ) const
+{
+  if ( !seenCapacity )
+    return false;
+  size_t h = Hash( node, level ) & ( seenCapacity - 1 );
+  while ( seen[h].node )
+  {
+    if ( seen[h].node == node && seen[h].level == level )
+      return true;
+    h = ( h + 1 ) & ( seenCapacity - 1 );
+  }
+  return false;
+}
+
+void TiXmlQueryIterator::Remember( int level, const TiXmlNode* node )
+{
+  /* 装填因子不超过1/2 */
+  if ( ( seenCount + 1 ) * 2 > seenCapacity )
+  {
+    const size_t oldCapacity = seenCapacity;
+    Entry* old = seen;
+    seenCapacity = oldCapacity ? oldCapacity * 2 : 64;
+    seen = new Entry[ seenCapacity ];
+    memset( seen, 0, seenCapacity * sizeof( Entry ) );
+    seenCount = 0;
+    for ( size_t i = 0; i < oldCapacity; ++i )
+    {
+      if ( old[i].node )
+        Remember( old[i].level, old[i].node );
+    }
+    delete [] old;
+  }
+
+  size_t h = Hash( node, level ) & ( seenCapacity - 1 );
+  while ( seen[h].node )
+    h = ( h + 1 ) & ( seenCapacity - 1 );
+  seen[h].node = node;
+  seen[h].level = level;
+  ++seenCount;
+}
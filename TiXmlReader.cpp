@@ -0,0 +1,505 @@
+/* 类 */
+
+class TiXmlReader;
+
+/* SAX接口。TiXmlReader::Parse()每读到一个事件就调用对应的函数，返回false时停止解析。
+ * 元素名、属性和文本都通过reader读取，只在回调期间有效
+ */
+class TiXmlSaxHandler
+{
+public:
+  virtual ~TiXmlSaxHandler() {}
+
+  virtual bool StartElement( const TiXmlReader& /*reader*/ )  { return true; }
+  virtual bool EndElement( const TiXmlReader& /*reader*/ )    { return true; }
+  virtual bool Text( const TiXmlReader& /*reader*/ )          { return true; }  /* 包括CDATA，用reader.IsCDATA()区分 */
+  virtual bool Comment( const TiXmlReader& /*reader*/ )       { return true; }
+  virtual bool Declaration( const TiXmlReader& /*reader*/ )   { return true; }
+  virtual bool Unknown( const TiXmlReader& /*reader*/ )       { return true; }
+};
+
+/* 拉模式(pull)的流式解析器，不建立DOM树。
+ * 每次调用Read()前进到下一个事件：开始标签、结束标签、文本等。内存只和嵌套深度、
+ * 单个开始标签的属性个数有关，和文档大小无关，适合只关心少数字段的超大文件：
+ *
+ *   TiXmlReader reader;
+ *   reader.OpenFile( "feed.xml" );
+ *   while ( !reader.Done() )
+ *   {
+ *     if ( reader.Read() == TiXmlReader::TIXML_READ_START_ELEMENT && strcmp( reader.Name(), "item" ) == 0 ) { ... }
+ *   }
+ *
+ * 词法分析用的是和DOM解析相同的函数：ReadName()、ReadText()、GetEntity()、TiXmlAttribute::Parse()等，
+ * 所以两者对同一个文档的结果是一致的
+ */
+class TiXmlReader
+{
+public:
+  enum Event
+  {
+    TIXML_READ_NONE,            /* 还没有开始读 */
+    TIXML_READ_START_ELEMENT,   /* <name attr="..."> 或 <name/> */
+    TIXML_READ_END_ELEMENT,     /* </name>。<name/>之后也会有一个 */
+    TIXML_READ_TEXT,            /* 文本或CDATA */
+    TIXML_READ_COMMENT,
+    TIXML_READ_DECLARATION,
+    TIXML_READ_UNKNOWN,
+    TIXML_READ_END_DOCUMENT,
+    TIXML_READ_ERROR,
+    TIXML_READ_NEED_MORE        /* 用Continue()分段输入时，当前这段已经读完 */
+  };
+
+  TiXmlReader();
+  ~TiXmlReader();
+
+  /* 从以'\0'结尾的内存中读取。xml要在读取过程中一直有效 */
+  void Open( const char* xml, TiXmlEncoding encoding = TIXML_DEFAULT_ENCODING );
+  /* 映射文件后读取，不把文件读入内存。不支持mmap()的平台上返回false */
+  bool OpenFile( const char* filename, TiXmlEncoding encoding = TIXML_DEFAULT_ENCODING );
+  void Close();
+
+  /* 分段输入：第一块用Open()打开，之后每一块都用Continue()接着读，打开的元素、编码等状态都保留。
+   * more为true表示后面还有输入，读到这块的结尾时返回TIXML_READ_NEED_MORE，而不是结束或出错。
+   * 调用者要保证每块都在一个完整的标记之后结束
+   */
+  void Continue( const char* xml, bool more );
+
+  /* 前进到下一个事件 */
+  Event Read();
+  Event Current() const { return event; }
+  /* 文档读完或者出错了 */
+  bool Done() const     { return event == TIXML_READ_END_DOCUMENT || event == TIXML_READ_ERROR; }
+
+  /* SAX方式：从当前位置读到结尾，每个事件回调handler一次。正常读完返回true */
+  bool Parse( TiXmlSaxHandler* handler );
+
+  /* 是否合并文本中的空白，默认合并，和TiXmlDocument::SetCondenseWhiteSpace()一样 */
+  void SetCondenseWhiteSpace( bool _condense ) { condense = _condense; }
+  bool IsWhiteSpaceCondensed() const           { return condense; }
+
+  /* 开始/结束标签的元素名 */
+  const char* Name() const    { return name.c_str(); }
+  /* 文本、注释、未知标签的内容；声明的版本号 */
+  const char* Value() const;
+  size_t ValueLength() const;
+  bool IsCDATA() const        { return event == TIXML_READ_TEXT && text.CDATA(); }
+  /* 当前元素的嵌套深度，根元素为1 */
+  int Depth() const           { return depth; }
+
+  /* 开始标签的属性，只在TIXML_READ_START_ELEMENT时有效 */
+  int AttributeCount() const  { return attributeCount; }
+  const TiXmlAttribute* AttributeAt( int i ) const { return ( i >= 0 && i < attributeCount ) ? attributes[i] : 0; }
+  const char* Attribute( const char* attribName ) const;
+
+  /* 声明中的信息 */
+  const TiXmlDeclaration& DeclarationNode() const { return declaration; }
+
+  /* 错误信息，和TiXmlDocument一样 */
+  bool Error() const              { return errorId != TiXmlBase::TIXML_NO_ERROR; }
+  int ErrorId() const             { return errorId; }
+  const char* ErrorDesc() const   { return TiXmlBase::errorString[ errorId ]; }
+  /* 出错位置相对于输入开头的字节偏移 */
+  size_t ErrorOffset() const      { return errorOffset; }
+
+private:
+  /* 不允许拷贝 */
+  TiXmlReader( const TiXmlReader& );
+  void operator=( const TiXmlReader& );
+
+  Event ReadStartElement();
+  Event ReadEndElement();
+  Event SetError( int err, const char* at );
+
+  void PushName();
+  void ClearAttributes();
+  TiXmlAttribute* NextAttribute();
+
+  TiXmlFileMapping  mapping;
+  const char*       start;
+  const char*       p;          /* 当前读到的位置 */
+  TiXmlEncoding     encoding;
+  Event             event;
+  bool              emptyElement;  /* 刚读到<name/>，下一个事件是对应的结束标签 */
+  bool              more;          /* 后面还有输入 */
+  bool              condense;
+
+  TIXML_STRING      name;
+  TiXmlText         text;
+  TiXmlComment      comment;
+  TiXmlDeclaration  declaration;
+  TiXmlUnknown      unknown;
+
+  /* 打开的元素名组成的栈，用来检查结束标签 */
+  TIXML_STRING*     openNames;
+  int               depth;
+  int               openCapacity;
+
+  /* 当前开始标签的属性。属性对象在事件之间重复使用，不会每次都分配 */
+  TiXmlAttribute**  attributes;
+  int               attributeCount;
+  int               attributeCapacity;
+
+  int               errorId;
+  size_t            errorOffset;
+};
+
+/* 方法 */
+
+TiXmlReader::TiXmlReader()
+  : start( 0 ), p( 0 ), encoding( TIXML_DEFAULT_ENCODING ), event( TIXML_READ_NONE ), emptyElement( false ), more( false ), condense( true ),
+    text( "" ), openNames( 0 ), depth( 0 ), openCapacity( 0 ),
+    attributes( 0 ), attributeCount( 0 ), attributeCapacity( 0 ),
+    errorId( TiXmlBase::TIXML_NO_ERROR ), errorOffset( 0 )
+{
+}
+
+TiXmlReader::~TiXmlReader()
+{
+  Close();
+  for ( int i = 0; i < attributeCapacity; ++i )
+    delete attributes[i];
+  delete [] attributes;
+  delete [] openNames;
+}
+
+void TiXmlReader::Open( const char* xml, TiXmlEncoding _encoding )
+{
+  Close();
+  start = p = xml;
+  encoding = _encoding;
+
+  /* 和TiXmlDocument::Parse()一样，根据微软的BOM判断是UTF-8 */
+  const unsigned char* pU = (const unsigned char*)p;
+  if ( encoding == TIXML_ENCODING_UNKNOWN && pU
+    && pU[0] == TIXML_UTF_LEAD_0 && pU[1] == TIXML_UTF_LEAD_1 && pU[2] == TIXML_UTF_LEAD_2 )
+  {
+    encoding = TIXML_ENCODING_UTF8;
+  }
+
+  if ( !p || !*p )
+    SetError( TiXmlBase::TIXML_ERROR_DOCUMENT_EMPTY, p );
+}
+
+bool TiXmlReader::OpenFile( const char* filename, TiXmlEncoding _encoding )
+{
+  Close();
+  int err = mapping.Open( filename );
+  if ( err != TiXmlBase::TIXML_NO_ERROR )
+  {
+    SetError( err, 0 );
+    return false;
+  }
+  Open( mapping.Data(), _encoding );
+  return !Error();
+}
+
+void TiXmlReader::Close()
+{
+  mapping.Close();
+  start = p = 0;
+  event = TIXML_READ_NONE;
+  emptyElement = false;
+  more = false;
+  depth = 0;
+  name = "";
+  ClearAttributes();
+  errorId = TiXmlBase::TIXML_NO_ERROR;
+  errorOffset = 0;
+}
+
+void TiXmlReader::Continue( const char* xml, bool _more )
+{
+  start = p = xml;
+  more = _more;
+}
+
+TiXmlReader::Event TiXmlReader::SetError( int err, const char* at )
+{
+  errorId = err;
+  errorOffset = ( at && start ) ? (size_t)( at - start ) : 0;
+  event = TIXML_READ_ERROR;
+  return event;
+}
+
+const char* TiXmlReader::Value() const
+{
+  switch ( event )
+  {
+    case TIXML_READ_TEXT:         return text.Value();
+    case TIXML_READ_COMMENT:      return comment.Value();
+    case TIXML_READ_UNKNOWN:      return unknown.Value();
+    case TIXML_READ_DECLARATION:  return declaration.Version();
+    default:                      return "";
+  }
+}
+
+size_t TiXmlReader::ValueLength() const
+{
+  switch ( event )
+  {
+    case TIXML_READ_TEXT:         return text.ValueRef().length();
+    case TIXML_READ_COMMENT:      return comment.ValueRef().length();
+    case TIXML_READ_UNKNOWN:      return unknown.ValueRef().length();
+    default:                      return strlen( Value() );
+  }
+}
+
+const char* TiXmlReader::Attribute( const char* attribName ) const
+{
+  for ( int i = 0; i < attributeCount; ++i )
+  {
+    if ( strcmp( attributes[i]->Name(), attribName ) == 0 )
+      return attributes[i]->Value();
+  }
+  return 0;
+}
+
+/* 和TiXmlElement::ReadValue()、TiXmlDocument::Parse()的顺序一致：
+ * 先跳过空白，不是'<'就是文本，否则根据开头判断是哪一种标签
+ */
+TiXmlReader::Event TiXmlReader::Read()
+{
+  if ( event == TIXML_READ_ERROR || event == TIXML_READ_END_DOCUMENT )
+    return event;
+
+  /* <name/>读完后补一个结束标签 */
+  if ( emptyElement )
+  {
+    emptyElement = false;
+    --depth;
+    ClearAttributes();
+    event = TIXML_READ_END_ELEMENT;
+    return event;
+  }
+  ClearAttributes();
+
+  const char* pWithWhiteSpace = p;
+  p = TiXmlBase::SkipWhiteSpace( p, encoding );
+
+  if ( !p || !*p )
+  {
+    if ( more )
+    {
+      event = TIXML_READ_NEED_MORE;
+      return event;
+    }
+    /* 还有没关闭的元素 */
+    if ( depth > 0 )
+      return SetError( TiXmlBase::TIXML_ERROR_READING_END_TAG, p ? p : pWithWhiteSpace );
+    event = TIXML_READ_END_DOCUMENT;
+    return event;
+  }
+
+  if ( *p != '<' )
+  {
+    /* 根元素之外的文本，TiXmlDocument::Parse()在这里停止 */
+    if ( depth == 0 )
+    {
+      event = TIXML_READ_END_DOCUMENT;
+      return event;
+    }
+
+    /* 合并空白时开头的空白不要，否则从跳过空白之前的位置开始读 */
+    text.SetCDATA( false );
+    const char* pText = condense ? p : pWithWhiteSpace;
+    const char* next = text.Parse( pText, 0, encoding, condense );
+    if ( !next )
+      return SetError( TiXmlBase::TIXML_ERROR_READING_ELEMENT_VALUE, pText );
+    p = next;
+
+    /* 全是空白的文本和DOM中一样丢掉 */
+    if ( text.Blank() )
+      return Read();
+    event = TIXML_READ_TEXT;
+    return event;
+  }
+
+  if ( TiXmlBase::StringEqual( p, "</", false, encoding ) )
+    return ReadEndElement();
+
+  const char* pStart = p;
+  if ( TiXmlBase::StringEqual( p, "<?xml", true, encoding ) )
+  {
+    p = declaration.Parse( p, 0, encoding );
+    if ( !p )
+      return SetError( TiXmlBase::TIXML_ERROR_PARSING_DECLARATION, pStart );
+
+    /* 和TiXmlDocument::Parse()一样，从声明中得到编码 */
+    if ( encoding == TIXML_ENCODING_UNKNOWN )
+    {
+      const char* enc = declaration.Encoding();
+      if ( *enc == 0
+        || TiXmlBase::StringEqual( enc, "UTF-8", true, TIXML_ENCODING_UNKNOWN )
+        || TiXmlBase::StringEqual( enc, "UTF8", true, TIXML_ENCODING_UNKNOWN ) )
+        encoding = TIXML_ENCODING_UTF8;
+      else
+        encoding = TIXML_ENCODING_LEGACY;
+    }
+    event = TIXML_READ_DECLARATION;
+  }
+  else if ( TiXmlBase::StringEqual( p, "<!--", false, encoding ) )
+  {
+    p = comment.Parse( p, 0, encoding );
+    if ( !p )
+      return SetError( TiXmlBase::TIXML_ERROR_PARSING_COMMENT, pStart );
+    event = TIXML_READ_COMMENT;
+  }
+  else if ( TiXmlBase::StringEqual( p, "<![CDATA[", false, encoding ) )
+  {
+    text.SetCDATA( true );
+    p = text.Parse( p, 0, encoding );
+    if ( !p )
+      return SetError( TiXmlBase::TIXML_ERROR_PARSING_CDATA, pStart );
+    event = TIXML_READ_TEXT;
+  }
+  else if ( !TiXmlBase::StringEqual( p, "<!", false, encoding )
+         && ( TiXmlBase::IsAlpha( *(p+1), encoding ) || *(p+1) == '_' ) )
+  {
+    return ReadStartElement();
+  }
+  else
+  {
+    p = unknown.Parse( p, 0, encoding );
+    if ( !p )
+      return SetError( TiXmlBase::TIXML_ERROR_PARSING_UNKNOWN, pStart );
+    event = TIXML_READ_UNKNOWN;
+  }
+  return event;
+}
+
+/* 与TiXmlElement::Parse()读取开始标签的部分相同，只是不读取内容 */
+TiXmlReader::Event TiXmlReader::ReadStartElement()
+{
+  p = TiXmlBase::SkipWhiteSpace( p+1, encoding );
+
+  const char* pErr = p;
+  p = TiXmlBase::ReadName( p, &name, encoding );
+  if ( !p || !*p )
+    return SetError( TiXmlBase::TIXML_ERROR_FAILED_TO_READ_ELEMENT_NAME, pErr );
+
+  while ( p && *p )
+  {
+    pErr = p;
+    p = TiXmlBase::SkipWhiteSpace( p, encoding );
+    if ( !p || !*p )
+      return SetError( TiXmlBase::TIXML_ERROR_READING_ATTRIBUTES, pErr );
+
+    if ( *p == '/' )
+    {
+      ++p;
+      if ( *p != '>' )
+        return SetError( TiXmlBase::TIXML_ERROR_PARSING_EMPTY, p );
+      ++p;
+      /* 空元素也算打开过一次，下一次Read()返回它的结束标签 */
+      emptyElement = true;
+      ++depth;
+      event = TIXML_READ_START_ELEMENT;
+      return event;
+    }
+    else if ( *p == '>' )
+    {
+      ++p;
+      PushName();
+      event = TIXML_READ_START_ELEMENT;
+      return event;
+    }
+    else
+    {
+      TiXmlAttribute* attrib = NextAttribute();
+      pErr = p;
+      p = attrib->Parse( p, 0, encoding );
+      if ( !p || !*p )
+        return SetError( TiXmlBase::TIXML_ERROR_PARSING_ELEMENT, pErr );
+
+      /* 同名的属性出现了两次 */
+      for ( int i = 0; i < attributeCount - 1; ++i )
+      {
+        if ( strcmp( attributes[i]->Name(), attrib->Name() ) == 0 )
+          return SetError( TiXmlBase::TIXML_ERROR_PARSING_ELEMENT, pErr );
+      }
+    }
+  }
+  return SetError( TiXmlBase::TIXML_ERROR_PARSING_ELEMENT, pErr );
+}
+
+/* </name >和</name>都是合法的结束标签，名字必须和最近打开的元素一致 */
+TiXmlReader::Event TiXmlReader::ReadEndElement()
+{
+  const char* pErr = p;
+  if ( depth == 0 )
+    return SetError( TiXmlBase::TIXML_ERROR_READING_END_TAG, pErr );
+
+  const TIXML_STRING& open = openNames[ depth - 1 ];
+  p += 2;
+  if ( strncmp( p, open.c_str(), open.length() ) != 0 )
+    return SetError( TiXmlBase::TIXML_ERROR_READING_END_TAG, pErr );
+  p = TiXmlBase::SkipWhiteSpace( p + open.length(), encoding );
+  if ( !p || *p != '>' )
+    return SetError( TiXmlBase::TIXML_ERROR_READING_END_TAG, pErr );
+  ++p;
+
+  name = open;
+  --depth;
+  event = TIXML_READ_END_ELEMENT;
+  return event;
+}
+
+void TiXmlReader::PushName()
+{
+  if ( depth == openCapacity )
+  {
+    int capacity = openCapacity ? openCapacity * 2 : 16;
+    TIXML_STRING* names = new TIXML_STRING[ capacity ];
+    for ( int i = 0; i < depth; ++i )
+      names[i] = openNames[i];
+    delete [] openNames;
+    openNames = names;
+    openCapacity = capacity;
+  }
+  openNames[ depth++ ] = name;
+}
+
+void TiXmlReader::ClearAttributes()
+{
+  attributeCount = 0;
+}
+
+/* 取一个可以重用的属性对象，不够时再分配 */
+TiXmlAttribute* TiXmlReader::NextAttribute()
+{
+  if ( attributeCount == attributeCapacity )
+  {
+    int capacity = attributeCapacity ? attributeCapacity * 2 : 8;
+    TiXmlAttribute** attribs = new TiXmlAttribute*[ capacity ];
+    for ( int i = 0; i < attributeCapacity; ++i )
+      attribs[i] = attributes[i];
+    for ( int i = attributeCapacity; i < capacity; ++i )
+      attribs[i] = new TiXmlAttribute();
+    delete [] attributes;
+    attributes = attribs;
+    attributeCapacity = capacity;
+  }
+  return attributes[ attributeCount++ ];
+}
+
+bool TiXmlReader::Parse( TiXmlSaxHandler* handler )
+{
+  for ( ;; )
+  {
+    bool go = true;
+    switch ( Read() )
+    {
+      case TIXML_READ_START_ELEMENT:  go = handler->StartElement( *this );  break;
+      case TIXML_READ_END_ELEMENT:    go = handler->EndElement( *this );    break;
+      case TIXML_READ_TEXT:           go = handler->Text( *this );          break;
+      case TIXML_READ_COMMENT:        go = handler->Comment( *this );       break;
+      case TIXML_READ_DECLARATION:    go = handler->Declaration( *this );   break;
+      case TIXML_READ_UNKNOWN:        go = handler->Unknown( *this );       break;
+      case TIXML_READ_END_DOCUMENT:
+      case TIXML_READ_NEED_MORE:      return true;
+      default:                        return false;
+    }
+    if ( !go )
+      return !Error();
+  }
+}
@@ -0,0 +1,549 @@
+/* 类 */
+
+#if ( defined( __GNUC__ ) || defined( __clang__ ) ) && ( defined( __x86_64__ ) || defined( __i386__ ) )
+  #define TIXML_SCANNER_X86
+  #include <immintrin.h>
+#endif
+
+/* AddressSanitizer会把SIMD版本读到'\0'后面的字节报成越界，这时只用标量版本扫描以'\0'结尾的输入。
+ * 用valgrind等工具检查时也可以手工定义TIXML_SCAN_NO_OVERREAD
+ */
+#if defined( __SANITIZE_ADDRESS__ )
+  #define TIXML_SCAN_NO_OVERREAD
+#elif defined( __has_feature )
+  #if __has_feature( address_sanitizer )
+    #define TIXML_SCAN_NO_OVERREAD
+  #endif
+#endif
+
+/* 解析器热点循环中用到的扫描函数。有标量、SSE2、AVX2三套实现，第一次使用时根据CPU选定一套，
+ * 三套实现的结果完全相同。
+ * 输入都是以'\0'结尾的字符串，扫描遇到'\0'一定会停下。SIMD版本先逐字节走到对齐的位置，
+ * 之后只做对齐的加载：对齐的加载不会跨页，所以读到'\0'后面几个字节不会出错，
+ * 但这几个字节可能不属于输入(见TIXML_SCAN_NO_OVERREAD)。长度已知的函数只读[p, end)
+ */
+class TiXmlScanner
+{
+public:
+  /* FindText()的flags */
+  enum
+  {
+    TIXML_SCAN_SPACE     = 1    /* 遇到空白也停下 */
+  };
+
+  /* 可选的实现，Level()返回当前使用的是哪一个 */
+  enum ScanLevel
+  {
+    TIXML_SCAN_SCALAR,
+    TIXML_SCAN_SSE2,
+    TIXML_SCAN_AVX2
+  };
+
+  /* 跳过空白(' '、'\t'、'\n'、'\v'、'\f'、'\r'，即C locale下的isspace())，返回第一个非空白字符的位置 */
+  static const char* SkipSpace( const char* p )                 { return active->skipSpace( p ); }
+
+  /* 找到下一个delim、'&'、'\r'或'\0'。delim为'<'时就是找下一个标签或实体引用，为引号时就是找属性值的结尾 */
+  static const char* FindText( const char* p, char delim, int flags ) { return active->findText( p, delim, flags ); }
+
+  /* 跳过名字中的字符：ASCII字母、数字、'_'、'-'、'.'、':'，以及所有>= 127的字节(与IsAlphaNum()一致) */
+  static const char* NameEnd( const char* p )                   { return active->nameEnd( p ); }
+
+  /* 就地把buf[0, length)中的"\r\n"和单独的'\r'换成'\n'，遇到'\0'停止。返回处理后内容的结尾 */
+  static char* NormalizeNewlines( char* buf, size_t length )    { return active->normalizeNewlines( buf, length ); }
+
+  /* 在[p, end)中找到第一个需要转义的字符('&'、'<'、'>'、'"'、'\''以及小于32的控制字符，包括'\0')，
+   * 没有时返回end。长度已知，不依赖结尾的'\0'
+   */
+  static const char* FindEscape( const char* p, const char* end ) { return active->findEscape( p, end ); }
+
+  static ScanLevel Level() { return Current()->level; }
+  /* 强制使用某一套实现(例如测试时比较结果)。CPU不支持时返回false，不做修改 */
+  static bool SetLevel( ScanLevel level );
+
+private:
+  struct Kernels
+  {
+    ScanLevel   level;
+    const char* (*skipSpace)( const char* p );
+    const char* (*findText)( const char* p, char delim, int flags );
+    const char* (*nameEnd)( const char* p );
+    char*       (*normalizeNewlines)( char* buf, size_t length );
+    const char* (*findEscape)( const char* p, const char* end );
+  };
+
+  /* level对应的一套实现。CPU支持以外的不会用到 */
+  static const Kernels* Select( ScanLevel level );
+  static ScanLevel Detect();
+
+  /* 当前的一套实现，还没有选定时先选定 */
+  static const Kernels* Current();
+  /* 第一次使用时按Detect()的结果选定。另一个线程或SetLevel()已经选定时以它为准 */
+  static const Kernels* Init();
+  /* 选定以前active指向的一套：每个函数都先Init()，再转给选定的实现 */
+  static const char* SkipSpaceLazy( const char* p )                 { return Init()->skipSpace( p ); }
+  static const char* FindTextLazy( const char* p, char delim, int flags ) { return Init()->findText( p, delim, flags ); }
+  static const char* NameEndLazy( const char* p )                   { return Init()->nameEnd( p ); }
+  static char* NormalizeNewlinesLazy( char* buf, size_t length )    { return Init()->normalizeNewlines( buf, length ); }
+  static const char* FindEscapeLazy( const char* p, const char* end ) { return Init()->findEscape( p, end ); }
+
+  static bool IsSpace( unsigned char c )     { return c == ' ' || ( c >= '\t' && c <= '\r' ); }
+  static bool IsNameChar( unsigned char c )
+  {
+    return ( c >= 'a' && c <= 'z' ) || ( c >= 'A' && c <= 'Z' ) || ( c >= '0' && c <= '9' )
+        || c == '_' || c == '-' || c == '.' || c == ':' || c >= 127;
+  }
+  static bool IsEscape( unsigned char c )
+  {
+    return c < 32 || c == '&' || c == '<' || c == '>' || c == '\"' || c == '\'';
+  }
+  static bool IsTextStop( unsigned char c, char delim, int flags )
+  {
+    return c == (unsigned char)delim || c == '&' || c == '\r' || c == 0
+        || ( ( flags & TIXML_SCAN_SPACE ) && IsSpace( c ) );
+  }
+
+  /* 标量实现 */
+  static const char* SkipSpaceScalar( const char* p );
+  static const char* FindTextScalar( const char* p, char delim, int flags );
+  static const char* NameEndScalar( const char* p );
+  static char* NormalizeNewlinesScalar( char* buf, size_t length );
+  static const char* FindEscapeScalar( const char* p, const char* end );
+
+#ifdef TIXML_SCANNER_X86
+  static const char* SkipSpaceSSE2( const char* p );
+  static const char* FindTextSSE2( const char* p, char delim, int flags );
+  static const char* NameEndSSE2( const char* p );
+  static char* NormalizeNewlinesSSE2( char* buf, size_t length );
+  static const char* FindEscapeSSE2( const char* p, const char* end );
+
+  static const char* SkipSpaceAVX2( const char* p );
+  static const char* FindTextAVX2( const char* p, char delim, int flags );
+  static const char* NameEndAVX2( const char* p );
+  static char* NormalizeNewlinesAVX2( char* buf, size_t length );
+  static const char* FindEscapeAVX2( const char* p, const char* end );
+#endif
+
+  /* 几套实现都是常量初始化的只读表，不依赖静态初始化的顺序，其他编译单元的静态对象中也能用。
+   * active只在选定时原子地改一次指针，多线程使用是安全的
+   */
+  static const Kernels scalarKernels;
+  static const Kernels lazyKernels;
+#ifdef TIXML_SCANNER_X86
+  static const Kernels sse2Kernels;
+  static const Kernels avx2Kernels;
+#endif
+  static const Kernels* volatile active;
+};
+
+/* 方法 */
+
+const TiXmlScanner::Kernels TiXmlScanner::scalarKernels =
+{
+  TIXML_SCAN_SCALAR, SkipSpaceScalar, FindTextScalar, NameEndScalar, NormalizeNewlinesScalar, FindEscapeScalar
+};
+
+const TiXmlScanner::Kernels TiXmlScanner::lazyKernels =
+{
+  TIXML_SCAN_SCALAR, SkipSpaceLazy, FindTextLazy, NameEndLazy, NormalizeNewlinesLazy, FindEscapeLazy
+};
+
+#ifdef TIXML_SCANNER_X86
+/* TIXML_SCAN_NO_OVERREAD时，以'\0'结尾的三个函数换成标量版本，长度已知的两个仍然用SIMD */
+#ifdef TIXML_SCAN_NO_OVERREAD
+const TiXmlScanner::Kernels TiXmlScanner::sse2Kernels =
+{
+  TIXML_SCAN_SSE2, SkipSpaceScalar, FindTextScalar, NameEndScalar, NormalizeNewlinesSSE2, FindEscapeSSE2
+};
+const TiXmlScanner::Kernels TiXmlScanner::avx2Kernels =
+{
+  TIXML_SCAN_AVX2, SkipSpaceScalar, FindTextScalar, NameEndScalar, NormalizeNewlinesAVX2, FindEscapeAVX2
+};
+#else
+const TiXmlScanner::Kernels TiXmlScanner::sse2Kernels =
+{
+  TIXML_SCAN_SSE2, SkipSpaceSSE2, FindTextSSE2, NameEndSSE2, NormalizeNewlinesSSE2, FindEscapeSSE2
+};
+const TiXmlScanner::Kernels TiXmlScanner::avx2Kernels =
+{
+  TIXML_SCAN_AVX2, SkipSpaceAVX2, FindTextAVX2, NameEndAVX2, NormalizeNewlinesAVX2, FindEscapeAVX2
+};
+#endif
+#endif
+
+const TiXmlScanner::Kernels* volatile TiXmlScanner::active = &TiXmlScanner::lazyKernels;
+
+const TiXmlScanner::Kernels* TiXmlScanner::Current()
+{
+  const Kernels* k = active;
+  return ( k == &lazyKernels ) ? Init() : k;
+}
+
+const TiXmlScanner::Kernels* TiXmlScanner::Init()
+{
+  const Kernels* k = Select( Detect() );
+#if defined( __GNUC__ )
+  /* 只有还没有选定时才替换，SetLevel()的设置不会被覆盖 */
+  __sync_bool_compare_and_swap( &active, &lazyKernels, k );
+#else
+  if ( active == &lazyKernels )
+    active = k;
+#endif
+  return active;
+}
+
+TiXmlScanner::ScanLevel TiXmlScanner::Detect()
+{
+#ifdef TIXML_SCANNER_X86
+  __builtin_cpu_init();
+  if ( __builtin_cpu_supports( "avx2" ) )
+    return TIXML_SCAN_AVX2;
+  if ( __builtin_cpu_supports( "sse2" ) )
+    return TIXML_SCAN_SSE2;
+#endif
+  return TIXML_SCAN_SCALAR;
+}
+
+const TiXmlScanner::Kernels* TiXmlScanner::Select( ScanLevel level )
+{
+#ifdef TIXML_SCANNER_X86
+  if ( level == TIXML_SCAN_SSE2 )
+    return &sse2Kernels;
+  if ( level == TIXML_SCAN_AVX2 )
+    return &avx2Kernels;
+#else
+  (void)level;
+#endif
+  return &scalarKernels;
+}
+
+bool TiXmlScanner::SetLevel( ScanLevel level )
+{
+  if ( level > Detect() )
+    return false;
+  active = Select( level );
+  return true;
+}
+
+const char* TiXmlScanner::SkipSpaceScalar( const char* p )
+{
+  while ( IsSpace( (unsigned char)*p ) )
+    ++p;
+  return p;
+}
+
+const char* TiXmlScanner::FindTextScalar( const char* p, char delim, int flags )
+{
+  while ( !IsTextStop( (unsigned char)*p, delim, flags ) )
+    ++p;
+  return p;
+}
+
+const char* TiXmlScanner::NameEndScalar( const char* p )
+{
+  while ( IsNameChar( (unsigned char)*p ) )
+    ++p;
+  return p;
+}
+
+char* TiXmlScanner::NormalizeNewlinesScalar( char* buf, size_t length )
+{
+  const char* p = buf;    /* 读 */
+  char* q = buf;          /* 写 */
+  const char* end = buf + length;
+
+  while ( p < end && *p )
+  {
+    if ( *p == '\r' )
+    {
+      *q++ = '\n';
+      ++p;
+      if ( p < end && *p == '\n' )
+        ++p;
+    }
+    else
+    {
+      *q++ = *p++;
+    }
+  }
+  return q;
+}
+
+const char* TiXmlScanner::FindEscapeScalar( const char* p, const char* end )
+{
+  while ( p < end && !IsEscape( (unsigned char)*p ) )
+    ++p;
+  return p;
+}
+
+#ifdef TIXML_SCANNER_X86
+
+/* 逐字节走到align字节对齐的位置，途中遇到要停下的字符就直接返回 */
+#define TIXML_SCAN_HEAD( p, align, stop )             \
+  while ( ( (size_t)(p) & ( (align) - 1 ) ) != 0 )    \
+  {                                                   \
+    if ( stop )                                       \
+      return p;                                       \
+    ++p;                                              \
+  }
+
+/* c在[lo, hi]之间：把lo平移到-128，再做有符号比较 */
+#define TIXML_SSE2_RANGE( v, lo, hi ) \
+  _mm_cmplt_epi8( _mm_add_epi8( v, _mm_set1_epi8( (char)( 0x80 - (lo) ) ) ), _mm_set1_epi8( (char)( 0x80 + (hi) - (lo) + 1 ) ) )
+#define TIXML_AVX2_RANGE( v, lo, hi ) \
+  _mm256_cmpgt_epi8( _mm256_set1_epi8( (char)( 0x80 + (hi) - (lo) + 1 ) ), _mm256_add_epi8( v, _mm256_set1_epi8( (char)( 0x80 - (lo) ) ) ) )
+
+__attribute__(( target( "sse2" ) ))
+const char* TiXmlScanner::SkipSpaceSSE2( const char* p )
+{
+  TIXML_SCAN_HEAD( p, 16, !IsSpace( (unsigned char)*p ) );
+  for ( ;; )
+  {
+    __m128i v = _mm_load_si128( (const __m128i*)p );
+    __m128i space = _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( ' ' ) ), TIXML_SSE2_RANGE( v, '\t', '\r' ) );
+    unsigned mask = ~(unsigned)_mm_movemask_epi8( space ) & 0xFFFFu;
+    if ( mask )
+      return p + __builtin_ctz( mask );
+    p += 16;
+  }
+}
+
+__attribute__(( target( "sse2" ) ))
+const char* TiXmlScanner::FindTextSSE2( const char* p, char delim, int flags )
+{
+  TIXML_SCAN_HEAD( p, 16, IsTextStop( (unsigned char)*p, delim, flags ) );
+
+  const __m128i vDelim = _mm_set1_epi8( delim );
+  const __m128i vAmp   = _mm_set1_epi8( '&' );
+  const __m128i vCR    = _mm_set1_epi8( '\r' );
+  const __m128i vZero  = _mm_setzero_si128();
+  for ( ;; )
+  {
+    __m128i v = _mm_load_si128( (const __m128i*)p );
+    __m128i stop = _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( v, vDelim ), _mm_cmpeq_epi8( v, vAmp ) ),
+                                 _mm_or_si128( _mm_cmpeq_epi8( v, vCR ), _mm_cmpeq_epi8( v, vZero ) ) );
+    if ( flags & TIXML_SCAN_SPACE )
+      stop = _mm_or_si128( stop, _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( ' ' ) ), TIXML_SSE2_RANGE( v, '\t', '\r' ) ) );
+    unsigned mask = (unsigned)_mm_movemask_epi8( stop );
+    if ( mask )
+      return p + __builtin_ctz( mask );
+    p += 16;
+  }
+}
+
+__attribute__(( target( "sse2" ) ))
+const char* TiXmlScanner::NameEndSSE2( const char* p )
+{
+  TIXML_SCAN_HEAD( p, 16, !IsNameChar( (unsigned char)*p ) );
+  for ( ;; )
+  {
+    __m128i v = _mm_load_si128( (const __m128i*)p );
+    /* '-'、'.'、'0'-'9'、':'连在一起(0x2D-0x3A)，中间只有'/'不是 */
+    __m128i punct = _mm_andnot_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( '/' ) ), TIXML_SSE2_RANGE( v, '-', ':' ) );
+    __m128i lower = _mm_or_si128( v, _mm_set1_epi8( 0x20 ) );
+    __m128i alpha = TIXML_SSE2_RANGE( lower, 'a', 'z' );
+    /* >= 127：有符号数为负，或者等于127 */
+    __m128i high  = _mm_or_si128( _mm_cmplt_epi8( v, _mm_setzero_si128() ), _mm_cmpeq_epi8( v, _mm_set1_epi8( 127 ) ) );
+    __m128i name  = _mm_or_si128( _mm_or_si128( punct, alpha ), _mm_or_si128( high, _mm_cmpeq_epi8( v, _mm_set1_epi8( '_' ) ) ) );
+    unsigned mask = ~(unsigned)_mm_movemask_epi8( name ) & 0xFFFFu;
+    if ( mask )
+      return p + __builtin_ctz( mask );
+    p += 16;
+  }
+}
+
+/* 长度已知，用不对齐的加载，只处理完整的16字节块，剩下的交给标量版本 */
+__attribute__(( target( "sse2" ) ))
+char* TiXmlScanner::NormalizeNewlinesSSE2( char* buf, size_t length )
+{
+  const char* p = buf;
+  char* q = buf;
+  const char* end = buf + length;
+
+  while ( end - p >= 16 )
+  {
+    __m128i v = _mm_loadu_si128( (const __m128i*)p );
+    __m128i stop = _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( '\r' ) ), _mm_cmpeq_epi8( v, _mm_setzero_si128() ) );
+    unsigned mask = (unsigned)_mm_movemask_epi8( stop );
+    if ( !mask )
+    {
+      /* 整块没有'\r'，直接搬过去(还没遇到过'\r'时q == p，不需要写) */
+      if ( q != p )
+        _mm_storeu_si128( (__m128i*)q, v );
+      p += 16;
+      q += 16;
+      continue;
+    }
+    int n = __builtin_ctz( mask );
+    if ( q != p )
+      memmove( q, p, n );
+    p += n;
+    q += n;
+    if ( *p == 0 )
+      return q;
+    /* *p == '\r' */
+    *q++ = '\n';
+    ++p;
+    if ( p < end && *p == '\n' )
+      ++p;
+  }
+
+  /* 剩下不到16个字节 */
+  while ( p < end && *p )
+  {
+    if ( *p == '\r' )
+    {
+      *q++ = '\n';
+      ++p;
+      if ( p < end && *p == '\n' )
+        ++p;
+    }
+    else
+    {
+      *q++ = *p++;
+    }
+  }
+  return q;
+}
+
+/* 长度已知，用不对齐的加载 */
+__attribute__(( target( "sse2" ) ))
+const char* TiXmlScanner::FindEscapeSSE2( const char* p, const char* end )
+{
+  const __m128i vControl = _mm_set1_epi8( 31 );
+  while ( end - p >= 16 )
+  {
+    __m128i v = _mm_loadu_si128( (const __m128i*)p );
+    /* 无符号数c <= 31 */
+    __m128i stop = _mm_cmpeq_epi8( _mm_min_epu8( v, vControl ), v );
+    stop = _mm_or_si128( stop, _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( '&' ) ), _mm_cmpeq_epi8( v, _mm_set1_epi8( '<' ) ) ) );
+    stop = _mm_or_si128( stop, _mm_or_si128( _mm_cmpeq_epi8( v, _mm_set1_epi8( '>' ) ), _mm_cmpeq_epi8( v, _mm_set1_epi8( '\"' ) ) ) );
+    stop = _mm_or_si128( stop, _mm_cmpeq_epi8( v, _mm_set1_epi8( '\'' ) ) );
+    unsigned mask = (unsigned)_mm_movemask_epi8( stop );
+    if ( mask )
+      return p + __builtin_ctz( mask );
+    p += 16;
+  }
+  return FindEscapeScalar( p, end );
+}
+
+__attribute__(( target( "avx2" ) ))
+const char* TiXmlScanner::SkipSpaceAVX2( const char* p )
+{
+  TIXML_SCAN_HEAD( p, 32, !IsSpace( (unsigned char)*p ) );
+  for ( ;; )
+  {
+    __m256i v = _mm256_load_si256( (const __m256i*)p );
+    __m256i space = _mm256_or_si256( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( ' ' ) ), TIXML_AVX2_RANGE( v, '\t', '\r' ) );
+    unsigned mask = ~(unsigned)_mm256_movemask_epi8( space );
+    if ( mask )
+      return p + __builtin_ctz( mask );
+    p += 32;
+  }
+}
+
+__attribute__(( target( "avx2" ) ))
+const char* TiXmlScanner::FindTextAVX2( const char* p, char delim, int flags )
+{
+  TIXML_SCAN_HEAD( p, 32, IsTextStop( (unsigned char)*p, delim, flags ) );
+
+  const __m256i vDelim = _mm256_set1_epi8( delim );
+  const __m256i vAmp   = _mm256_set1_epi8( '&' );
+  const __m256i vCR    = _mm256_set1_epi8( '\r' );
+  const __m256i vZero  = _mm256_setzero_si256();
+  for ( ;; )
+  {
+    __m256i v = _mm256_load_si256( (const __m256i*)p );
+    __m256i stop = _mm256_or_si256( _mm256_or_si256( _mm256_cmpeq_epi8( v, vDelim ), _mm256_cmpeq_epi8( v, vAmp ) ),
+                                    _mm256_or_si256( _mm256_cmpeq_epi8( v, vCR ), _mm256_cmpeq_epi8( v, vZero ) ) );
+    if ( flags & TIXML_SCAN_SPACE )
+      stop = _mm256_or_si256( stop, _mm256_or_si256( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( ' ' ) ), TIXML_AVX2_RANGE( v, '\t', '\r' ) ) );
+    unsigned mask = (unsigned)_mm256_movemask_epi8( stop );
+    if ( mask )
+      return p + __builtin_ctz( mask );
+    p += 32;
+  }
+}
+
+__attribute__(( target( "avx2" ) ))
+const char* TiXmlScanner::NameEndAVX2( const char* p )
+{
+  TIXML_SCAN_HEAD( p, 32, !IsNameChar( (unsigned char)*p ) );
+  for ( ;; )
+  {
+    __m256i v = _mm256_load_si256( (const __m256i*)p );
+    __m256i punct = _mm256_andnot_si256( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '/' ) ), TIXML_AVX2_RANGE( v, '-', ':' ) );
+    __m256i lower = _mm256_or_si256( v, _mm256_set1_epi8( 0x20 ) );
+    __m256i alpha = TIXML_AVX2_RANGE( lower, 'a', 'z' );
+    __m256i high  = _mm256_or_si256( _mm256_cmpgt_epi8( _mm256_setzero_si256(), v ), _mm256_cmpeq_epi8( v, _mm256_set1_epi8( 127 ) ) );
+    __m256i name  = _mm256_or_si256( _mm256_or_si256( punct, alpha ), _mm256_or_si256( high, _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '_' ) ) ) );
+    unsigned mask = ~(unsigned)_mm256_movemask_epi8( name );
+    if ( mask )
+      return p + __builtin_ctz( mask );
+    p += 32;
+  }
+}
+
+__attribute__(( target( "avx2" ) ))
+char* TiXmlScanner::NormalizeNewlinesAVX2( char* buf, size_t length )
+{
+  const char* p = buf;
+  char* q = buf;
+  const char* end = buf + length;
+
+  while ( end - p >= 32 )
+  {
+    __m256i v = _mm256_loadu_si256( (const __m256i*)p );
+    __m256i stop = _mm256_or_si256( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\r' ) ), _mm256_cmpeq_epi8( v, _mm256_setzero_si256() ) );
+    unsigned mask = (unsigned)_mm256_movemask_epi8( stop );
+    if ( !mask )
+    {
+      if ( q != p )
+        _mm256_storeu_si256( (__m256i*)q, v );
+      p += 32;
+      q += 32;
+      continue;
+    }
+    int n = __builtin_ctz( mask );
+    if ( q != p )
+      memmove( q, p, n );
+    p += n;
+    q += n;
+    if ( *p == 0 )
+      return q;
+    *q++ = '\n';
+    ++p;
+    if ( p < end && *p == '\n' )
+      ++p;
+  }
+
+  /* 剩下的交给SSE2版本(它会再处理完整的16字节块和最后的零头) */
+  size_t rest = end - p;
+  if ( q != p )
+    memmove( q, p, rest );
+  return NormalizeNewlinesSSE2( q, rest );
+}
+
+__attribute__(( target( "avx2" ) ))
+const char* TiXmlScanner::FindEscapeAVX2( const char* p, const char* end )
+{
+  const __m256i vControl = _mm256_set1_epi8( 31 );
+  while ( end - p >= 32 )
+  {
+    __m256i v = _mm256_loadu_si256( (const __m256i*)p );
+    __m256i stop = _mm256_cmpeq_epi8( _mm256_min_epu8( v, vControl ), v );
+    stop = _mm256_or_si256( stop, _mm256_or_si256( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '&' ) ), _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '<' ) ) ) );
+    stop = _mm256_or_si256( stop, _mm256_or_si256( _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '>' ) ), _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\"' ) ) ) );
+    stop = _mm256_or_si256( stop, _mm256_cmpeq_epi8( v, _mm256_set1_epi8( '\'' ) ) );
+    unsigned mask = (unsigned)_mm256_movemask_epi8( stop );
+    if ( mask )
+      return p + __builtin_ctz( mask );
+    p += 32;
+  }
+  return FindEscapeSSE2( p, end );
+}
+
+#undef TIXML_SCAN_HEAD
+#undef TIXML_SSE2_RANGE
+#undef TIXML_AVX2_RANGE
+
+#endif /* TIXML_SCANNER_X86 */
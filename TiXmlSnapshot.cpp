@@ -0,0 +1,449 @@
+/* 类 */
+
+/* 文档树的二进制快照，由TiXmlDocument::SaveBinary()和LoadBinary()使用。
+ * 很少改变的大配置文件每次启动都要重新解析，保存成快照以后加载时不再做任何文本解析：
+ * 读入整个文件、校验、按记录建立节点，字符串直接引用读入的缓冲区。
+ *
+ * 文件布局，所有的段都按8字节对齐，可以直接mmap()后按结构访问：
+ *   Header
+ *   Node[nodeCount]            先序排列，第0个是文档本身
+ *   Attr[attributeCount]       各元素的属性依次排列
+ *   偏移[stringCount + 1]      第i个字符串是[offset[i], offset[i+1] - 1)，后面跟着'\0'
+ *   字符串                     相同的字符串只存一份
+ * 节点没有指针：end是它的子树结束的位置，第一个子节点是i + 1(如果i + 1 < end)，下一个兄弟是end。
+ * 整数按本机字节序存放，byteOrder不一致的快照不能加载。Header之后的内容有一个Fletcher-64校验和
+ */
+class TiXmlSnapshot
+{
+public:
+  /* 成功返回TIXML_NO_ERROR，否则返回错误码 */
+  static int Write( const TiXmlDocument& document, FILE* file );
+  /* buf是整个文件的内容，必须按8字节对齐，由文档保留：节点的字符串直接引用它 */
+  static int Read( TiXmlDocument* document, const char* buf, size_t length );
+
+  enum
+  {
+    VERSION = 1,
+    BYTE_ORDER_MARK = 0x01020304,
+    FLAG_CDATA = 1
+  };
+
+private:
+  struct Header
+  {
+    char                magic[8];       /* "TiXmlBin" */
+    unsigned int        version;
+    unsigned int        byteOrder;      /* 写入时的BYTE_ORDER_MARK */
+    unsigned long long  length;         /* 整个文件的长度 */
+    unsigned long long  checksum;       /* Header之后所有内容的校验和 */
+    unsigned int        nodeCount;
+    unsigned int        attributeCount;
+    unsigned int        stringCount;
+    unsigned int        reserved;
+    unsigned long long  stringBytes;    /* 字符串段的长度，不含对齐的填充 */
+  };
+
+  struct Node
+  {
+    unsigned short  type;             /* TiXmlNode::NodeType */
+    unsigned short  flags;            /* FLAG_CDATA */
+    unsigned int    value;            /* 字符串编号 */
+    unsigned int    end;              /* 子树结束的位置 */
+    unsigned int    firstAttribute;
+    unsigned int    attributeCount;   /* 声明固定是3个：version、encoding、standalone */
+  };
+
+  struct Attr
+  {
+    unsigned int  name;
+    unsigned int  value;
+  };
+
+  /* 写快照时收集节点、属性和去重后的字符串 */
+  class Builder
+  {
+  public:
+    Builder();
+    ~Builder();
+
+    unsigned int AddNode( const TiXmlNode* node );
+    void AddAttribute( const char* name, size_t nameLength, const char* value, size_t valueLength );
+
+    Node*               nodes;
+    unsigned int        nodeCount;
+    unsigned int        nodeCapacity;
+    Attr*               attrs;
+    unsigned int        attributeCount;
+    unsigned int        attributeCapacity;
+    TiXmlStringPool     strings;
+  };
+
+  /* Fletcher-64，按4字节一组累加。length必须是4的倍数 */
+  static void Checksum( const void* p, size_t length, unsigned long long* a, unsigned long long* b );
+
+  static size_t Align( size_t n ) { return ( n + 7 ) & ~(size_t)7; }
+
+  /* 把items扩大到至少能放下count + 1个 */
+  template< class T, class N >
+  static void Grow( T*& items, N& capacity, N count );
+};
+
+/* 方法 */
+
+template< class T, class N >
+void TiXmlSnapshot::Grow( T*& items, N& capacity, N count )
+{
+  if ( count < capacity )
+    return;
+  N newCapacity = capacity ? capacity * 2 : 256;
+  T* newItems = new T[ newCapacity ];
+  if ( count )
+    memcpy( newItems, items, count * sizeof( T ) );
+  delete [] items;
+  items = newItems;
+  capacity = newCapacity;
+}
+
+void TiXmlSnapshot::Checksum( const void* p, size_t length, unsigned long long* a, unsigned long long* b )
+{
+  assert( length % 4 == 0 );
+  const unsigned int* word = (const unsigned int*)p;
+  const unsigned int* end = word + length / 4;
+  unsigned long long sa = *a, sb = *b;
+  while ( word < end )
+  {
+    /* 累加一批再取模，sb在这么多次之内不会溢出 */
+    const unsigned int* stop = ( end - word > 4096 ) ? word + 4096 : end;
+    for ( ; word < stop; ++word )
+    {
+      sa += *word;
+      sb += sa;
+    }
+    sa %= 0xffffffffu;
+    sb %= 0xffffffffu;
+  }
+  *a = sa;
+  *b = sb;
+}
+
+TiXmlSnapshot::Builder::Builder()
+  : nodes( 0 ), nodeCount( 0 ), nodeCapacity( 0 ), attrs( 0 ), attributeCount( 0 ), attributeCapacity( 0 )
+{
+}
+
+TiXmlSnapshot::Builder::~Builder()
+{
+  delete [] nodes;
+  delete [] attrs;
+}
+
+void TiXmlSnapshot::Builder::AddAttribute( const char* name, size_t nameLength, const char* value, size_t valueLength )
+{
+  Grow( attrs, attributeCapacity, attributeCount );
+  Attr& attr = attrs[ attributeCount++ ];
+  attr.name = strings.Add( name, nameLength );
+  attr.value = strings.Add( value, valueLength );
+}
+
+unsigned int TiXmlSnapshot::Builder::AddNode( const TiXmlNode* node )
+{
+  Grow( nodes, nodeCapacity, nodeCount );
+  const unsigned int index = nodeCount++;
+  Node record;
+  memset( &record, 0, sizeof( record ) );
+  record.type = (unsigned short)node->Type();
+  record.value = strings.Add( node->value.c_str(), node->value.length() );
+  record.firstAttribute = attributeCount;
+
+  if ( node->ToText() && node->ToText()->CDATA() )
+    record.flags |= FLAG_CDATA;
+
+  if ( const TiXmlElement* element = node->ToElement() )
+  {
+    for ( const TiXmlAttribute* attrib = element->FirstAttribute(); attrib; attrib = attrib->Next() )
+      AddAttribute( attrib->name.c_str(), attrib->name.length(), attrib->value.c_str(), attrib->value.length() );
+  }
+  else if ( const TiXmlDeclaration* decl = node->ToDeclaration() )
+  {
+    AddAttribute( "version", 7, decl->Version(), strlen( decl->Version() ) );
+    AddAttribute( "encoding", 8, decl->Encoding(), strlen( decl->Encoding() ) );
+    AddAttribute( "standalone", 10, decl->Standalone(), strlen( decl->Standalone() ) );
+  }
+  record.attributeCount = attributeCount - record.firstAttribute;
+  nodes[index] = record;
+  return index;
+}
+
+int TiXmlSnapshot::Write( const TiXmlDocument& document, FILE* file )
+{
+  Builder builder;
+
+  /* 先序遍历，子树结束时补上end。open中是还没有结束的祖先 */
+  unsigned int* open = 0;
+  unsigned int openCount = 0, openCapacity = 0;
+
+  builder.AddNode( &document );
+  const TiXmlNode* node = document.FirstChild();
+  while ( node )
+  {
+    if ( builder.nodeCount == 0xffffffffu || builder.attributeCount > 0xfffffff0u || builder.strings.Count() > 0xfffffff0u )
+    {
+      delete [] open;
+      return TiXmlBase::TIXML_ERROR;
+    }
+    unsigned int index = builder.AddNode( node );
+    if ( node->FirstChild() )
+    {
+      Grow( open, openCapacity, openCount );
+      open[ openCount++ ] = index;
+      node = node->FirstChild();
+      continue;
+    }
+    builder.nodes[index].end = builder.nodeCount;
+    while ( !node->NextSibling() && openCount )
+    {
+      node = node->Parent();
+      builder.nodes[ open[ --openCount ] ].end = builder.nodeCount;
+    }
+    node = node->NextSibling();
+  }
+  delete [] open;
+  builder.nodes[0].end = builder.nodeCount;
+
+  /* 各段的长度，字符串段补齐到8字节 */
+  static const char padding[8] = { 0 };
+  const size_t nodeBytes = builder.nodeCount * sizeof( Node );
+  const size_t attrBytes = builder.attributeCount * sizeof( Attr );
+  const size_t offsetBytes = ( builder.strings.Count() + 1 ) * sizeof( unsigned long long );
+  const size_t byteCount = builder.strings.ByteCount();
+  const size_t stringPadding = Align( byteCount ) - byteCount;
+
+  Header header;
+  memset( &header, 0, sizeof( header ) );
+  memcpy( header.magic, "TiXmlBin", 8 );
+  header.version = VERSION;
+  header.byteOrder = BYTE_ORDER_MARK;
+  header.nodeCount = builder.nodeCount;
+  header.attributeCount = builder.attributeCount;
+  header.stringCount = builder.strings.Count();
+  header.stringBytes = byteCount;
+  header.length = sizeof( Header ) + Align( nodeBytes ) + Align( attrBytes ) + offsetBytes + Align( byteCount );
+
+  unsigned long long a = 0, b = 0;
+  Checksum( builder.nodes, nodeBytes, &a, &b );
+  Checksum( padding, Align( nodeBytes ) - nodeBytes, &a, &b );
+  Checksum( builder.attrs, attrBytes, &a, &b );
+  Checksum( builder.strings.Offsets(), offsetBytes, &a, &b );
+  /* 最后不足4字节的部分和填充一起算 */
+  const size_t whole = byteCount - byteCount % 4;
+  Checksum( builder.strings.Bytes(), whole, &a, &b );
+  char tail[8] = { 0 };
+  memcpy( tail, builder.strings.Bytes() + whole, byteCount % 4 );
+  Checksum( tail, Align( byteCount ) - whole, &a, &b );
+  header.checksum = ( b << 32 ) | a;
+
+  bool ok = fwrite( &header, sizeof( header ), 1, file ) == 1;
+  ok = ok && ( !nodeBytes || fwrite( builder.nodes, nodeBytes, 1, file ) == 1 );
+  ok = ok && fwrite( padding, 1, Align( nodeBytes ) - nodeBytes, file ) == Align( nodeBytes ) - nodeBytes;
+  ok = ok && ( !attrBytes || fwrite( builder.attrs, attrBytes, 1, file ) == 1 );
+  ok = ok && fwrite( builder.strings.Offsets(), offsetBytes, 1, file ) == 1;
+  ok = ok && ( !byteCount || fwrite( builder.strings.Bytes(), byteCount, 1, file ) == 1 );
+  ok = ok && fwrite( padding, 1, stringPadding, file ) == stringPadding;
+  return ok ? TiXmlBase::TIXML_NO_ERROR : TiXmlBase::TIXML_ERROR_OPENING_FILE;
+}
+
+int TiXmlSnapshot::Read( TiXmlDocument* document, const char* buf, size_t length )
+{
+  const int bad = TiXmlBase::TIXML_ERROR_BINARY_FORMAT;
+  if ( length < sizeof( Header ) )
+    return bad;
+
+  const Header* header = (const Header*)buf;
+  if ( memcmp( header->magic, "TiXmlBin", 8 ) != 0 || header->version != VERSION
+      || header->byteOrder != BYTE_ORDER_MARK || header->length != length || header->nodeCount == 0 )
+    return bad;
+
+  /* 先确认各段都在文件之内，再算校验和 */
+  const unsigned long long nodeBytes = (unsigned long long)header->nodeCount * sizeof( Node );
+  const unsigned long long attrBytes = (unsigned long long)header->attributeCount * sizeof( Attr );
+  const unsigned long long offsetBytes = ( (unsigned long long)header->stringCount + 1 ) * sizeof( unsigned long long );
+  const unsigned long long expected = sizeof( Header ) + Align( (size_t)nodeBytes ) + Align( (size_t)attrBytes )
+                                      + offsetBytes + Align( (size_t)header->stringBytes );
+  if ( header->stringCount == 0 || header->stringBytes > length || expected != length )
+    return bad;
+
+  unsigned long long a = 0, b = 0;
+  Checksum( buf + sizeof( Header ), length - sizeof( Header ), &a, &b );
+  if ( header->checksum != ( ( b << 32 ) | a ) )
+    return bad;
+
+  const Node* nodes = (const Node*)( buf + sizeof( Header ) );
+  const Attr* attrs = (const Attr*)( (const char*)nodes + Align( (size_t)nodeBytes ) );
+  const unsigned long long* offsets = (const unsigned long long*)( (const char*)attrs + Align( (size_t)attrBytes ) );
+  const char* strings = (const char*)( offsets + header->stringCount + 1 );
+  const unsigned int stringCount = header->stringCount;
+
+  /* 每个字符串都在段内，并且以'\0'结尾 */
+  if ( offsets[0] != 0 || offsets[ stringCount ] != header->stringBytes )
+    return bad;
+  for ( unsigned int i = 0; i < stringCount; ++i )
+  {
+    if ( offsets[i+1] <= offsets[i] || strings[ offsets[i+1] - 1 ] != 0 )
+      return bad;
+  }
+
+  if ( nodes[0].type != TiXmlNode::TINYXML_DOCUMENT || nodes[0].end != header->nodeCount )
+    return bad;
+
+  TiXmlArena* arena = document->Arena();
+  TiXmlNameTable* names = document->NameTable();
+
+  /* 同一个名字只放进名字表一次 */
+  const char** interned = 0;
+  if ( names )
+  {
+    interned = new const char*[ stringCount ];
+    memset( interned, 0, stringCount * sizeof( const char* ) );
+  }
+
+  /* parents[k]是当前第k层的父节点，ends[k]是它的子树结束的位置 */
+  TiXmlNode** parents = 0;
+  unsigned int* ends = 0;
+  unsigned int depth = 0, parentCapacity = 0, endCapacity = 0;
+  Grow( parents, parentCapacity, depth );
+  Grow( ends, endCapacity, depth );
+  parents[0] = document;
+  ends[0] = header->nodeCount;
+  depth = 1;
+
+  int result = TiXmlBase::TIXML_NO_ERROR;
+  for ( unsigned int i = 1; i < header->nodeCount; ++i )
+  {
+    while ( ends[ depth - 1 ] <= i )
+      --depth;
+
+    const Node& record = nodes[i];
+    if ( record.end <= i || record.end > ends[ depth - 1 ] || record.value >= stringCount
+        || record.firstAttribute > header->attributeCount
+        || record.attributeCount > header->attributeCount - record.firstAttribute )
+    {
+      result = bad;
+      break;
+    }
+
+    const char* value = strings + offsets[ record.value ];
+    const size_t valueLength = (size_t)( offsets[ record.value + 1 ] - offsets[ record.value ] - 1 );
+    const Attr* attr = attrs + record.firstAttribute;
+    for ( unsigned int k = 0; k < record.attributeCount; ++k )
+    {
+      if ( attr[k].name >= stringCount || attr[k].value >= stringCount )
+        result = bad;
+    }
+    if ( result != TiXmlBase::TIXML_NO_ERROR )
+      break;
+
+    TiXmlNode* node = 0;
+    switch ( record.type )
+    {
+      case TiXmlNode::TINYXML_ELEMENT:
+      {
+        TiXmlElement* element = new( arena ) TiXmlElement( "" );
+        for ( unsigned int k = 0; k < record.attributeCount; ++k )
+        {
+          TiXmlAttribute* attrib = new( arena ) TiXmlAttribute();
+          attrib->SetDocument( document );
+          const unsigned int name = attr[k].name;
+          const size_t nameLength = (size_t)( offsets[ name + 1 ] - offsets[ name ] - 1 );
+          if ( names )
+          {
+            if ( !interned[ name ] )
+              interned[ name ] = names->Intern( strings + offsets[ name ], nameLength );
+            attrib->name.Intern( interned[ name ], nameLength );
+          }
+          else
+          {
+            attrib->name.Refer( strings + offsets[ name ], nameLength );
+          }
+          attrib->value.Refer( strings + offsets[ attr[k].value ], (size_t)( offsets[ attr[k].value + 1 ] - offsets[ attr[k].value ] - 1 ) );
+          if ( element->attributeSet.Find( attrib->name ) )
+          {
+            delete attrib;
+            result = bad;
+            break;
+          }
+          element->attributeSet.Add( attrib );
+        }
+        if ( names )
+        {
+          if ( !interned[ record.value ] )
+            interned[ record.value ] = names->Intern( value, valueLength );
+          element->value.Intern( interned[ record.value ], valueLength );
+        }
+        else
+        {
+          element->value.Refer( value, valueLength );
+        }
+        node = element;
+        break;
+      }
+
+      case TiXmlNode::TINYXML_TEXT:
+      {
+        TiXmlText* text = new( arena ) TiXmlText( "" );
+        text->SetCDATA( ( record.flags & FLAG_CDATA ) != 0 );
+        text->value.Refer( value, valueLength );
+        node = text;
+        break;
+      }
+
+      case TiXmlNode::TINYXML_COMMENT:
+        node = new( arena ) TiXmlComment();
+        node->value.Refer( value, valueLength );
+        break;
+
+      case TiXmlNode::TINYXML_UNKNOWN:
+        node = new( arena ) TiXmlUnknown();
+        node->value.Refer( value, valueLength );
+        break;
+
+      case TiXmlNode::TINYXML_DECLARATION:
+        if ( record.attributeCount != 3 )
+        {
+          result = bad;
+          break;
+        }
+        node = new( arena ) TiXmlDeclaration( strings + offsets[ attr[0].value ],
+                                              strings + offsets[ attr[1].value ],
+                                              strings + offsets[ attr[2].value ] );
+        break;
+
+      default:
+        result = bad;
+        break;
+    }
+
+    if ( node )
+    {
+      /* 文本、注释等不能有子节点 */
+      if ( record.end > i + 1 && !node->ToElement() )
+        result = bad;
+      parents[ depth - 1 ]->LinkEndChild( node );
+    }
+    if ( result != TiXmlBase::TIXML_NO_ERROR )
+      break;
+
+    if ( record.end > i + 1 )
+    {
+      Grow( parents, parentCapacity, depth );
+      Grow( ends, endCapacity, depth );
+      parents[ depth ] = node;
+      ends[ depth ] = record.end;
+      ++depth;
+    }
+  }
+
+  delete [] interned;
+  delete [] parents;
+  delete [] ends;
+  return result;
+}
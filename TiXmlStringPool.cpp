@@ -0,0 +1,148 @@
+/* 类 */
+
+/* 按编号访问的字符串池。相同的字符串只存一份，编号从0开始连续分配；
+ * 所有字符串首尾相接地放在一块内存中，每个后面跟着'\0'，第i个的开头是Offsets()[i]。
+ * 和TiXmlNameTable的区别是它给出编号而不是指针，TiXmlSnapshot和TiXmlFrozenDocument用编号代替字符串。
+ * 建好以后只读(Find()、String())是线程安全的
+ */
+class TiXmlStringPool
+{
+public:
+  enum { NONE = 0xffffffffu };
+
+  TiXmlStringPool();
+  ~TiXmlStringPool();
+
+  /* 返回[p, p+length)的编号，池中没有时先加进去 */
+  unsigned int Add( const char* p, size_t length );
+  /* 只查找，没有时返回NONE */
+  unsigned int Find( const char* p, size_t length ) const;
+  unsigned int Find( const char* s ) const { return Find( s, strlen( s ) ); }
+
+  unsigned int Count() const { return count; }
+  const char* String( unsigned int id ) const { return bytes + offsets[id]; }
+  size_t Length( unsigned int id ) const      { return (size_t)( offsets[id+1] - offsets[id] - 1 ); }
+
+  /* Count() + 1个偏移，最后一个是ByteCount() */
+  const unsigned long long* Offsets() const { return offsets; }
+  const char* Bytes() const                 { return bytes; }
+  size_t ByteCount() const                  { return byteCount; }
+
+  /* 占用的内存 */
+  size_t BytesUsed() const
+  {
+    return byteCapacity + ( count + 1 ) * sizeof( unsigned long long ) + slotCapacity * sizeof( unsigned int );
+  }
+
+private:
+  /* 不允许拷贝 */
+  TiXmlStringPool( const TiXmlStringPool& );
+  void operator=( const TiXmlStringPool& );
+
+  void Rehash( size_t newCapacity );
+
+  unsigned long long* offsets;
+  unsigned int        count;
+  unsigned int        offsetCapacity;
+  char*               bytes;
+  size_t              byteCount;
+  size_t              byteCapacity;
+  unsigned int*       slots;        /* 开放定址，存编号+1，0表示空位。容量是2的幂 */
+  size_t              slotCapacity;
+};
+
+/* 方法 */
+
+TiXmlStringPool::TiXmlStringPool()
+  : offsets( 0 ), count( 0 ), offsetCapacity( 0 ), bytes( 0 ), byteCount( 0 ), byteCapacity( 0 ),
+    slots( 0 ), slotCapacity( 0 )
+{
+}
+
+TiXmlStringPool::~TiXmlStringPool()
+{
+  delete [] offsets;
+  delete [] bytes;
+  delete [] slots;
+}
+
+void TiXmlStringPool::Rehash( size_t newCapacity )
+{
+  unsigned int* newSlots = new unsigned int[ newCapacity ];
+  memset( newSlots, 0, newCapacity * sizeof( unsigned int ) );
+  for ( unsigned int id = 0; id < count; ++id )
+  {
+    size_t h = TiXmlNameTable::Hash( String( id ), Length( id ) ) & ( newCapacity - 1 );
+    while ( newSlots[h] )
+      h = ( h + 1 ) & ( newCapacity - 1 );
+    newSlots[h] = id + 1;
+  }
+  delete [] slots;
+  slots = newSlots;
+  slotCapacity = newCapacity;
+}
+
+unsigned int TiXmlStringPool::Find( const char* p, size_t length ) const
+{
+  if ( !slotCapacity )
+    return NONE;
+  size_t h = TiXmlNameTable::Hash( p, length ) & ( slotCapacity - 1 );
+  while ( slots[h] )
+  {
+    unsigned int id = slots[h] - 1;
+    if ( Length( id ) == length && memcmp( String( id ), p, length ) == 0 )
+      return id;
+    h = ( h + 1 ) & ( slotCapacity - 1 );
+  }
+  return NONE;
+}
+
+unsigned int TiXmlStringPool::Add( const char* p, size_t length )
+{
+  unsigned int id = Find( p, length );
+  if ( id != NONE )
+    return id;
+
+  /* 装填因子不超过1/2 */
+  if ( ( (size_t)count + 1 ) * 2 > slotCapacity )
+    Rehash( slotCapacity ? slotCapacity * 2 : 1024 );
+
+  /* offsets总是比字符串多一个，放下一个字符串的开头 */
+  if ( count + 2 > offsetCapacity )
+  {
+    unsigned int newCapacity = offsetCapacity ? offsetCapacity * 2 : 256;
+    unsigned long long* newOffsets = new unsigned long long[ newCapacity ];
+    if ( offsets )
+      memcpy( newOffsets, offsets, ( count + 1 ) * sizeof( unsigned long long ) );
+    else
+      newOffsets[0] = 0;
+    delete [] offsets;
+    offsets = newOffsets;
+    offsetCapacity = newCapacity;
+  }
+
+  if ( byteCount + length + 1 > byteCapacity )
+  {
+    size_t newCapacity = byteCapacity ? byteCapacity : 4096;
+    while ( newCapacity < byteCount + length + 1 )
+      newCapacity *= 2;
+    char* newBytes = new char[ newCapacity ];
+    if ( byteCount )
+      memcpy( newBytes, bytes, byteCount );
+    delete [] bytes;
+    bytes = newBytes;
+    byteCapacity = newCapacity;
+  }
+  memcpy( bytes + byteCount, p, length );
+  byteCount += length;
+  bytes[ byteCount++ ] = 0;
+
+  id = count++;
+  offsets[ count ] = byteCount;
+
+  size_t h = TiXmlNameTable::Hash( p, length ) & ( slotCapacity - 1 );
+  while ( slots[h] )
+    h = ( h + 1 ) & ( slotCapacity - 1 );
+  slots[h] = id + 1;
+  return id;
+}
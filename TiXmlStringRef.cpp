@@ -0,0 +1,280 @@
+/* 类 */
+
+#if defined( _MSC_VER )
+  #include <intrin.h>
+#endif
+
+/* 编译器支持C++11时，字符串、节点、属性和文档都提供移动构造和移动赋值，
+ * 另外有接受右值和std::unique_ptr的插入函数(见TiXmlNode)
+ */
+#if __cplusplus >= 201103L || ( defined( _MSC_VER ) && _MSC_VER >= 1900 )
+  #define TIXML_HAS_MOVE
+  #include <memory>
+  #include <utility>
+#endif
+
+/* 节点值、属性名和属性值使用的字符串。它有四种状态：
+ * 1. 引用：只保存指向文档缓冲区的指针和长度，自己不拥有内存。就地(in-situ)解析时使用
+ * 2. 拥有：和原来的TIXML_STRING一样，内容存放在str中
+ * 3. 名字：指向TiXmlNameTable中的名字，同名的字符串指针相同
+ * 4. 共享：指向一块带引用计数的内存(Shared)，由Share()生成，拷贝时只增加引用计数(copy-on-write)
+ * 解析得到的都是引用，用户修改(SetValue、赋值等)时才拷贝成自己的字符串
+ */
+class TiXmlStringRef
+{
+public:
+  /* 就地解析时，引用的内容在解析结束后还需要做的处理 */
+  enum Pending
+  {
+    TIXML_PENDING_NONE = 0,     /* 只需要在末尾补'\0' */
+    TIXML_PENDING_ENTITIES,     /* 需要解码实体引用、规范化换行符 */
+    TIXML_PENDING_CONDENSE      /* 需要解码实体引用，并且合并空白 */
+  };
+
+  TiXmlStringRef() : ref( 0 ), refLength( 0 ), pending( TIXML_PENDING_NONE ), interned( false ), shared( 0 ) {}
+  TiXmlStringRef( const char* s ) : ref( 0 ), refLength( 0 ), pending( TIXML_PENDING_NONE ), interned( false ), shared( 0 ), str( s ) {}
+  ~TiXmlStringRef() { Release(); }
+
+  /* 共享的字符串拷贝时只增加引用计数；其他的拷贝出来总是拥有自己的内存，不依赖原文档的缓冲区 */
+  TiXmlStringRef( const TiXmlStringRef& copy )
+    : ref( 0 ), refLength( 0 ), pending( TIXML_PENDING_NONE ), interned( false ), shared( 0 )
+  {
+    if ( copy.shared )
+      ShareWith( copy );
+    else
+      str.assign( copy.c_str(), copy.length() );
+  }
+
+#ifdef TIXML_HAS_MOVE
+  /* 接管other的全部状态，other变成空字符串 */
+  TiXmlStringRef( TiXmlStringRef&& other )
+    : ref( other.ref ), refLength( other.refLength ), pending( other.pending ), interned( other.interned ), shared( other.shared )
+  {
+    str.swap( other.str );
+    other.ref = 0;
+    other.refLength = 0;
+    other.shared = 0;
+  }
+  TiXmlStringRef& operator=( TiXmlStringRef&& other )
+  {
+    if ( this != &other )
+    {
+      Release();
+      ref = other.ref;
+      refLength = other.refLength;
+      pending = other.pending;
+      interned = other.interned;
+      shared = other.shared;
+      str = "";
+      str.swap( other.str );
+      other.ref = 0;
+      other.refLength = 0;
+      other.shared = 0;
+    }
+    return *this;
+  }
+  #ifdef TIXML_USE_STL
+  TiXmlStringRef& operator=( std::string&& s )        { str = std::move( s ); ref = 0; Release(); return *this; }
+  #endif
+#endif
+
+  /* 先拷贝再放弃共享的内存，s可能就指向它 */
+  TiXmlStringRef& operator=( const char* s )          { str = s; ref = 0; Release(); return *this; }
+  TiXmlStringRef& operator=( const TIXML_STRING& s )  { str = s; ref = 0; Release(); return *this; }
+  /* 赋值为[p, p+len)，不需要先把原来引用的内容拷贝出来 */
+  void Assign( const char* p, size_t len ) { str.assign( p, len ); ref = 0; Release(); }
+  TiXmlStringRef& operator=( const TiXmlStringRef& copy )
+  {
+    if ( this != &copy )
+    {
+      if ( copy.shared )
+      {
+        /* 先加引用再释放自己的，copy可能和自己共享同一块 */
+        Shared* keep = shared;
+        shared = 0;
+        ShareWith( copy );
+        if ( keep )
+          Unref( keep );
+        str = "";
+      }
+      else
+      {
+        TIXML_STRING tmp( copy.c_str(), copy.length() );
+        str = tmp;
+        ref = 0;
+        Release();
+      }
+    }
+    return *this;
+  }
+
+  /* 引用状态下，只有文档解析完成(补上'\0')以后c_str()才是以'\0'结尾的；解析过程中请用length() */
+  const char* c_str() const { return ref ? ref : str.c_str(); }
+  size_t length() const     { return ref ? refLength : str.length(); }
+  bool empty() const        { return length() == 0; }
+  char operator[]( size_t i ) const { return c_str()[i]; }
+
+  bool Equals( const char* p, size_t len ) const
+  {
+    return length() == len && memcmp( c_str(), p, len ) == 0;
+  }
+  bool operator==( const char* s ) const { return Equals( s, strlen( s ) ); }
+  bool operator!=( const char* s ) const { return !Equals( s, strlen( s ) ); }
+
+  /* 转换成TIXML_STRING，不改变c_str()指向哪里。拥有和共享状态下直接返回，不拷贝：
+   * 共享的内容在Share()时就放进了Shared中的TIXML_STRING，之后不再修改，几个线程同时读也没有问题。
+   * 引用和名字状态下第一次调用时把内容拷贝到str中缓存起来，这会写对象本身，
+   * 几个线程同时读同一个就地解析或使用名字表的文档时请用c_str()和length()
+   */
+  const TIXML_STRING& Str() const
+  {
+    if ( shared )
+      return shared->str;
+    if ( ref && str.length() != refLength )
+      str.assign( ref, refLength );
+    return str;
+  }
+
+  /* 返回可以直接修改的TIXML_STRING，引用、名字和共享状态下会先拷贝一份，之后变成拥有状态 */
+  TIXML_STRING* Mutable()
+  {
+    Detach();
+    return &str;
+  }
+
+  /* [internal use] 引用缓冲区中的[p, p+len) */
+  void Refer( const char* p, size_t len, Pending _pending = TIXML_PENDING_NONE )
+  {
+    Release();
+    str = "";
+    ref = p;
+    refLength = len;
+    pending = _pending;
+    interned = false;
+  }
+  bool IsReference() const    { return ref != 0 && !interned && !shared; }
+  Pending PendingWork() const { return IsReference() ? pending : TIXML_PENDING_NONE; }
+
+  /* [internal use] 指向名字表中的name。name以'\0'结尾，和名字表的生命周期一样长 */
+  void Intern( const char* name, size_t len )
+  {
+    Refer( name, len );
+    interned = true;
+  }
+  /* 是否指向名字表。是的话c_str()可以直接和名字表返回的指针比较 */
+  bool IsInterned() const     { return ref != 0 && interned; }
+
+  /* 引用缓冲区或名字表时拷贝成自己的字符串，之后不再依赖原来的文档。共享的字符串不变 */
+  void Own()
+  {
+    if ( ref && !shared )
+      Detach();
+  }
+
+  /* 把内容放进一块带引用计数的内存，之后的拷贝都共享它。名字表中的名字不变。
+   * 引用计数的增减是原子操作，同一个字符串可以在几个线程中同时被拷贝
+   */
+  void Share();
+  bool IsShared() const       { return shared != 0; }
+
+  /* 自己占用的堆内存(估计值)。引用缓冲区和名字表的不算，Str()的缓存算；
+   * 共享的按整块算，每个共享它的字符串各算一次
+   */
+  size_t HeapBytes() const
+  {
+    if ( shared )
+      return sizeof( Shared ) + refLength + 1;
+    return str.empty() ? 0 : str.length() + 1;
+  }
+
+private:
+  struct Shared
+  {
+    volatile long refs;
+    TIXML_STRING  str;
+  };
+
+  void Detach()
+  {
+    if ( ref )
+    {
+      str.assign( ref, refLength );
+      ref = 0;
+      Release();
+    }
+  }
+
+  /* 和copy共享同一块内存 */
+  void ShareWith( const TiXmlStringRef& copy )
+  {
+    AddRef( copy.shared );
+    shared = copy.shared;
+    ref = shared->str.c_str();
+    refLength = copy.refLength;
+    pending = TIXML_PENDING_NONE;
+    interned = false;
+  }
+
+  /* 放弃共享的内存，不修改ref */
+  void Release()
+  {
+    if ( shared )
+    {
+      Unref( shared );
+      shared = 0;
+    }
+  }
+
+  static void AddRef( Shared* block );
+  static void Unref( Shared* block );
+
+  const char*   ref;
+  size_t        refLength;
+  Pending       pending;
+  bool          interned;   /* ref指向名字表，不是文档的缓冲区 */
+  Shared*       shared;     /* 共享状态下ref指向shared->str */
+  mutable TIXML_STRING str; /* 拥有状态下的内容；引用和名字状态下是Str()的缓存 */
+};
+
+/* 方法 */
+
+void TiXmlStringRef::Share()
+{
+  if ( shared || IsInterned() )
+    return;
+
+  const size_t len = length();
+  Shared* block = new Shared;
+  block->refs = 1;
+  block->str.assign( c_str(), len );
+
+  str = "";
+  shared = block;
+  ref = block->str.c_str();
+  refLength = len;
+  pending = TIXML_PENDING_NONE;
+}
+
+void TiXmlStringRef::AddRef( Shared* block )
+{
+#if defined( __GNUC__ )
+  __sync_add_and_fetch( &block->refs, 1 );
+#elif defined( _MSC_VER )
+  _InterlockedIncrement( &block->refs );
+#else
+  ++block->refs;
+#endif
+}
+
+void TiXmlStringRef::Unref( Shared* block )
+{
+#if defined( __GNUC__ )
+  long left = __sync_sub_and_fetch( &block->refs, 1 );
+#elif defined( _MSC_VER )
+  long left = _InterlockedDecrement( &block->refs );
+#else
+  long left = --block->refs;
+#endif
+  if ( left == 0 )
+    delete block;
+}
@@ -0,0 +1,221 @@
+/* 类 */
+
+/* 文本节点，也用来表示CDATA(<![CDATA[...]]>)。value中存放的是文本内容 */
+class TiXmlText : public TiXmlNode
+{
+  friend class TiXmlElement;
+  friend class TiXmlReader;
+  friend class TiXmlParallelParser;
+public:
+  /* 构造函数 */
+  TiXmlText (const char * initValue ) : TiXmlNode (TiXmlNode::TINYXML_TEXT)
+  {
+    SetValue( initValue );
+    cdata = false;
+  }
+  virtual ~TiXmlText() {}
+
+  TiXmlText( const TiXmlText& copy ) : TiXmlNode( TiXmlNode::TINYXML_TEXT ) { copy.CopyTo( this ); }
+  TiXmlText& operator=( const TiXmlText& base ) { base.CopyTo( this ); return *this; }
+#ifdef TIXML_HAS_MOVE
+  /* 文本直接接管other的字符串 */
+  TiXmlText( TiXmlText&& other ) : TiXmlNode( TiXmlNode::TINYXML_TEXT )
+  {
+    const TiXmlDocument* from = other.GetDocument();
+    MoveFrom( other );
+    cdata = other.cdata;
+    Localize( from );
+  }
+  TiXmlText& operator=( TiXmlText&& other )
+  {
+    if ( this != &other )
+    {
+      const TiXmlDocument* from = other.GetDocument();
+      Clear();
+      MoveFrom( other );
+      cdata = other.cdata;
+      Localize( from );
+    }
+    return *this;
+  }
+#endif
+
+  virtual void Print( FILE* cfile, int depth ) const;
+
+  /* 是否是CDATA */
+  bool CDATA() const      { return cdata; }
+  void SetCDATA( bool _cdata )  { cdata = _cdata; }
+
+  /* 是否合并空白由解析选项决定(TiXmlParseOptions::SetCondenseWhiteSpace()) */
+  virtual const char* Parse( const char* p, TiXmlParsingData* data, TiXmlEncoding encoding );
+
+  virtual const TiXmlText* ToText() const { return this; }
+  virtual TiXmlText*       ToText()       { return this; }
+
+  virtual bool Accept( TiXmlVisitor* content ) const;
+
+protected :
+  virtual TiXmlNode* Clone() const;
+  void CopyTo( TiXmlText* target ) const;
+#ifdef TIXML_HAS_MOVE
+  virtual TiXmlNode* MoveOut()
+  {
+    TiXmlText* node = new TiXmlText( "" );
+    node->MoveFrom( *this );
+    node->cdata = cdata;
+    return node;
+  }
+#endif
+
+  /* 文本是否全是空白，全是空白的文本节点会被丢掉 */
+  bool Blank() const;
+
+  /* 同Parse()，condense为true时合并空白。TiXmlReader没有文档，直接用它 */
+  const char* Parse( const char* p, TiXmlParsingData* data, TiXmlEncoding encoding, bool condense );
+
+private:
+  bool cdata;
+};
+
+/* 方法 */
+
+const char* TiXmlText::Parse( const char* p, TiXmlParsingData* data, TiXmlEncoding encoding )
+{
+  if ( data )
+    return Parse( p, data, encoding, data->Options().IsWhiteSpaceCondensed() );
+  const TiXmlDocument* document = GetDocument();
+  return Parse( p, data, encoding, document ? document->IsWhiteSpaceCondensed() : true );
+}
+
+const char* TiXmlText::Parse( const char* p, TiXmlParsingData* data, TiXmlEncoding encoding, bool condense )
+{
+  value = "";
+  TiXmlDocument* document = GetDocument();
+  /* 就地解析时文本只引用文档的缓冲区，实体引用和空白在整个文档解析结束后再就地处理 */
+  const bool inSitu = document && document->IsParsingInSitu();
+
+  if ( data )
+  {
+    location = data->Offset( p );
+    generation = data->Generation();
+  }
+
+  /* CDATA节点由Identify()建立，已经记过账 */
+  const char* const start = p;
+  const bool identified = cdata;
+  /* 资源限制下最多读入多长，超过时不再往下读 */
+  const size_t budget = ( data && data->Limited() ) ? data->StringBudget( !inSitu ) : (size_t)-1;
+
+  const char* const startTag = "<![CDATA[";
+  const char* const endTag   = "]]>";
+
+  if ( cdata || StringEqual( p, startTag, false, encoding ) )
+  {
+    cdata = true;
+
+    if ( !StringEqual( p, startTag, false, encoding ) )
+    {
+      if ( document )
+        document->SetError( TIXML_ERROR_PARSING_CDATA, p, data, encoding );
+      return 0;
+    }
+    p += strlen( startTag );
+
+    /* CDATA中的内容原样保留，不处理空白和实体引用，只规范化换行符 */
+    const char* content = p;
+    while ( p && *p
+        && !StringEqual( p, endTag, false, encoding )
+        )
+    {
+      ++p;
+    }
+    /* 换行符规范化只会变短，原文超过限制时再算一下规范化以后的长度，超过就不拷贝了 */
+    size_t length = p - content;
+    if ( !inSitu && length > budget )
+    {
+      for ( const char* q = content; q + 1 < p; ++q )
+      {
+        if ( q[0] == '\r' && q[1] == '\n' )
+          --length;
+      }
+      if ( length > budget )
+      {
+        CheckLimit( data->AddString( length, length + 1 ), start, data, encoding );
+        return 0;
+      }
+    }
+    if ( inSitu )
+      value.Refer( content, p - content );
+    else
+      AppendNewlineNormalized( content, p - content, value.Mutable() );
+
+    TIXML_STRING dummy;
+    p = ReadText( p, &dummy, false, endTag, false, encoding );
+  }
+  else
+  {
+    const char* end = "<";
+    p = inSitu ? ReadTextInSitu( p, &value, condense, end, false, encoding, budget )
+               : ReadText( p, value.Mutable(), condense, end, false, encoding, budget );
+    if ( p && *p )
+      --p; /* 不要跳过'<' */
+    else
+      p = 0;
+  }
+
+#ifdef TIXML_USE_STATS
+  /* 普通文本节点只有空白的会被父元素丢掉，其余的在这里计数 */
+  if ( !identified && !Blank() )
+    TiXmlParseStats::CountNode( TINYXML_TEXT );
+#endif
+
+  /* 资源限制。普通文本节点由父元素直接建立，只有空白的会被父元素丢掉，其余的在这里记账。
+   * 超过budget时ReadText()已经停下来了，这里设置错误
+   */
+  if ( ( p || value.length() > budget ) && data && data->Limited() )
+  {
+    if ( !identified && !Blank() && !CheckLimit( data->AddNode( sizeof( TiXmlText ), false ), start, data, encoding ) )
+      return 0;
+    if ( !CheckLimit( data->AddString( value.length(), value.HeapBytes() ), start, data, encoding ) )
+      return 0;
+  }
+  return p;
+}
+
+void TiXmlText::Print( FILE* cfile, int depth ) const
+{
+  assert( cfile );
+  if ( cdata )
+  {
+    int i;
+    fprintf( cfile, "\n" );
+    for ( i=0; i<depth; i++ ) {
+      fprintf( cfile, "    " );
+    }
+    fprintf( cfile, "<![CDATA[%s]]>\n", value.c_str() );  /* CDATA原样输出 */
+  }
+  else if ( !NeedsEncoding( value.c_str(), value.length() ) )
+  {
+    /* 大部分文本不需要转义，直接写出去 */
+    fwrite( value.c_str(), 1, value.length(), cfile );
+  }
+  else
+  {
+    TIXML_STRING buffer;
+    EncodeString( value.c_str(), value.length(), &buffer );
+    fwrite( buffer.c_str(), 1, buffer.length(), cfile );
+  }
+}
+
+TiXmlNode* TiXmlText::Clone() const
+{
+  TiXmlText* clone = new TiXmlText( "" );
+  CopyTo( clone );
+  return clone;
+}
+
+void TiXmlText::CopyTo( TiXmlText* target ) const
+{
+  TiXmlNode::CopyTo( target );
+  target->cdata = cdata;
+}
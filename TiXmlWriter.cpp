@@ -0,0 +1,367 @@
+/* 类 */
+
+/* TiXmlWriter的输出目标。Write()每次收到一整块数据(默认64KB)，失败时返回false */
+class TiXmlSink
+{
+public:
+  virtual ~TiXmlSink() {}
+  virtual bool Write( const char* data, size_t length ) = 0;
+};
+
+/* 写到FILE*。每块只调用一次fwrite()，块比stdio的缓冲区大，会直接变成一次write() */
+class TiXmlFileSink : public TiXmlSink
+{
+public:
+  TiXmlFileSink( FILE* _file ) : file( _file ) {}
+  virtual bool Write( const char* data, size_t length )
+  {
+    return fwrite( data, 1, length, file ) == length;
+  }
+
+private:
+  FILE* file;
+};
+
+/* 把DOM树序列化成XML文本。整棵树只遍历一次(不递归)，所有内容直接写进一块缓冲区，
+ * 节点和属性都不生成临时字符串，需要转义的字符也是逐段写入。
+ * 没有设置sink时，结果留在缓冲区中，用CStr()/Size()取出；
+ * 设置了sink时，缓冲区每满一块就交给sink，内存占用是固定的。
+ * PRETTY模式每个节点一行并缩进，只有一个文本子节点的元素写在同一行；COMPACT模式不加任何空白：
+ *
+ *   TiXmlWriter writer( TiXmlWriter::COMPACT );
+ *   writer.Write( doc );
+ *   send( sock, writer.CStr(), writer.Size(), 0 );
+ */
+class TiXmlWriter
+{
+public:
+  enum Style
+  {
+    PRETTY,
+    COMPACT
+  };
+
+  TiXmlWriter( Style style = PRETTY );
+  ~TiXmlWriter();
+
+  /* 缩进和换行，COMPACT模式下都是空的 */
+  void SetIndent( const char* _indent )       { indent = _indent ? _indent : ""; indentLength = strlen( indent ); }
+  void SetLineBreak( const char* _lineBreak ) { lineBreak = _lineBreak ? _lineBreak : ""; lineBreakLength = strlen( lineBreak ); }
+
+  /* 设置输出目标。为0时写到内部的缓冲区 */
+  void SetSink( TiXmlSink* _sink );
+
+  /* 写出node以及它所有的子节点，node可以是文档。sink出错时返回false */
+  bool Write( const TiXmlNode& node );
+  /* 直接写入一段内容，例如BOM */
+  bool WriteRaw( const char* data, size_t length ) { Put( data, length ); return ok; }
+  /* 把缓冲区中剩下的内容交给sink */
+  bool Flush();
+
+  /* 没有sink时的结果，以'\0'结尾 */
+  const char* CStr() const  { return buffer ? buffer : ""; }
+  size_t Size() const       { return length; }
+  /* 清空结果，缓冲区保留下来重复使用 */
+  void Clear()              { length = 0; if ( buffer ) buffer[0] = 0; ok = true; }
+
+  enum { BLOCK_SIZE = 64 * 1024 };
+
+private:
+  /* 不允许拷贝 */
+  TiXmlWriter( const TiXmlWriter& );
+  void operator=( const TiXmlWriter& );
+
+  /* 写出节点的开头部分。返回true表示还要接着写它的子节点 */
+  bool Open( const TiXmlNode* node, int depth );
+  /* 子节点写完以后，写出结束标签 */
+  void Close( const TiXmlNode* node, int depth );
+
+  void Put( const char* data, size_t n );
+  void Put( const TiXmlStringRef& str ) { Put( str.c_str(), str.length() ); }
+  void Put( char c )
+  {
+    if ( length + 1 < capacity )
+    {
+      buffer[ length++ ] = c;
+      buffer[ length ] = 0;
+    }
+    else
+      Put( &c, 1 );
+  }
+  void PutEscaped( const char* p, size_t n );
+  void PutEscaped( const TiXmlStringRef& str ) { PutEscaped( str.c_str(), str.length() ); }
+  void PutIndent( int depth );
+  void PutLineBreak() { Put( lineBreak, lineBreakLength ); }
+  void Reserve( size_t n );
+
+  const char* indent;
+  size_t      indentLength;
+  const char* lineBreak;
+  size_t      lineBreakLength;
+
+  TiXmlSink*  sink;
+  char*       buffer;
+  size_t      length;
+  size_t      capacity;
+  bool        ok;         /* sink还没有出过错 */
+};
+
+/* 方法 */
+
+TiXmlWriter::TiXmlWriter( Style style )
+  : sink( 0 ), buffer( 0 ), length( 0 ), capacity( 0 ), ok( true )
+{
+  SetIndent( style == PRETTY ? "    " : "" );
+  SetLineBreak( style == PRETTY ? "\n" : "" );
+}
+
+TiXmlWriter::~TiXmlWriter()
+{
+  delete [] buffer;
+}
+
+void TiXmlWriter::SetSink( TiXmlSink* _sink )
+{
+  Flush();
+  sink = _sink;
+}
+
+bool TiXmlWriter::Flush()
+{
+  if ( sink && length )
+  {
+    if ( ok )
+      ok = sink->Write( buffer, length );
+    length = 0;
+  }
+  return ok;
+}
+
+/* 保证还能再放下n个字节和结尾的'\0' */
+void TiXmlWriter::Reserve( size_t n )
+{
+  size_t need = length + n + 1;
+  if ( need <= capacity )
+    return;
+
+  size_t newCapacity = capacity ? capacity : BLOCK_SIZE;
+  while ( newCapacity < need )
+    newCapacity *= 2;
+  char* newBuffer = new char[ newCapacity ];
+  if ( length )
+    memcpy( newBuffer, buffer, length );
+  delete [] buffer;
+  buffer = newBuffer;
+  capacity = newCapacity;
+}
+
+void TiXmlWriter::Put( const char* data, size_t n )
+{
+  if ( sink )
+  {
+    /* 块满了就交出去。比一块还大的内容不再拷贝，直接交给sink */
+    if ( length + n >= BLOCK_SIZE )
+    {
+      Flush();
+      if ( n >= BLOCK_SIZE )
+      {
+        if ( ok )
+          ok = sink->Write( data, n );
+        return;
+      }
+    }
+  }
+  Reserve( n );
+  memcpy( buffer + length, data, n );
+  length += n;
+  buffer[ length ] = 0;
+}
+
+/* 和TiXmlBase::EncodeString()一样转义，但直接写进缓冲区 */
+void TiXmlWriter::PutEscaped( const char* p, size_t n )
+{
+  const char* end = p + n;
+  while ( p < end )
+  {
+    const char* special = TiXmlScanner::FindEscape( p, end );
+    if ( special != p )
+      Put( p, special - p );
+    p = special;
+    if ( p == end )
+      break;
+
+    const char* out;
+    size_t outLength;
+    char scratch[ TiXmlBase::ENCODE_SCRATCH ];
+    p = TiXmlBase::EncodeSpecial( p, end, &out, &outLength, scratch );
+    Put( out, outLength );
+  }
+}
+
+void TiXmlWriter::PutIndent( int depth )
+{
+  if ( !indentLength )
+    return;
+  for ( int i = 0; i < depth; ++i )
+    Put( indent, indentLength );
+}
+
+/* 先序遍历，用Parent()/NextSibling()回溯，不用递归也不用栈 */
+bool TiXmlWriter::Write( const TiXmlNode& root )
+{
+  const TiXmlNode* node = &root;
+  int depth = 0;
+
+  for ( ;; )
+  {
+    if ( Open( node, depth ) && node->FirstChild() )
+    {
+      /* 文档的子节点不缩进 */
+      if ( !node->ToDocument() )
+        ++depth;
+      node = node->FirstChild();
+      continue;
+    }
+
+    while ( node != &root && !node->NextSibling() )
+    {
+      node = node->Parent();
+      if ( !node->ToDocument() )
+        --depth;
+      Close( node, depth );
+    }
+    if ( node == &root )
+      break;
+    node = node->NextSibling();
+  }
+
+  return ok;
+}
+
+bool TiXmlWriter::Open( const TiXmlNode* node, int depth )
+{
+  switch ( node->Type() )
+  {
+    case TiXmlNode::TINYXML_DOCUMENT:
+      return true;
+
+    case TiXmlNode::TINYXML_ELEMENT:
+    {
+      const TiXmlElement* element = node->ToElement();
+      PutIndent( depth );
+      Put( '<' );
+      Put( node->value );
+
+      for ( const TiXmlAttribute* attrib = element->FirstAttribute(); attrib; attrib = attrib->Next() )
+      {
+        /* 值里没有双引号时用双引号括起来，否则用单引号 */
+        const char quote = memchr( attrib->value.c_str(), '\"', attrib->value.length() ) ? '\'' : '\"';
+        Put( ' ' );
+        PutEscaped( attrib->name );
+        Put( '=' );
+        Put( quote );
+        PutEscaped( attrib->value );
+        Put( quote );
+      }
+
+      const TiXmlNode* child = node->FirstChild();
+      if ( !child )
+      {
+        Put( "/>", 2 );
+        PutLineBreak();
+        return false;
+      }
+
+      /* 只有一个文本子节点时写在同一行 */
+      const TiXmlText* text = child->ToText();
+      if ( text && !text->CDATA() && !child->NextSibling() )
+      {
+        Put( '>' );
+        PutEscaped( child->value );
+        Put( "</", 2 );
+        Put( node->value );
+        Put( '>' );
+        PutLineBreak();
+        return false;
+      }
+
+      Put( '>' );
+      PutLineBreak();
+      return true;
+    }
+
+    case TiXmlNode::TINYXML_TEXT:
+    {
+      PutIndent( depth );
+      if ( node->ToText()->CDATA() )
+      {
+        /* CDATA原样输出 */
+        Put( "<![CDATA[", 9 );
+        Put( node->value );
+        Put( "]]>", 3 );
+      }
+      else
+      {
+        PutEscaped( node->value );
+      }
+      PutLineBreak();
+      return false;
+    }
+
+    case TiXmlNode::TINYXML_COMMENT:
+      PutIndent( depth );
+      Put( "<!--", 4 );
+      Put( node->value );
+      Put( "-->", 3 );
+      PutLineBreak();
+      return false;
+
+    case TiXmlNode::TINYXML_DECLARATION:
+    {
+      const TiXmlDeclaration* decl = node->ToDeclaration();
+      PutIndent( depth );
+      Put( "<?xml ", 6 );
+      if ( *decl->Version() )
+      {
+        Put( "version=\"", 9 );
+        PutEscaped( decl->Version(), strlen( decl->Version() ) );
+        Put( "\" ", 2 );
+      }
+      if ( *decl->Encoding() )
+      {
+        Put( "encoding=\"", 10 );
+        PutEscaped( decl->Encoding(), strlen( decl->Encoding() ) );
+        Put( "\" ", 2 );
+      }
+      if ( *decl->Standalone() )
+      {
+        Put( "standalone=\"", 12 );
+        PutEscaped( decl->Standalone(), strlen( decl->Standalone() ) );
+        Put( "\" ", 2 );
+      }
+      Put( "?>", 2 );
+      PutLineBreak();
+      return false;
+    }
+
+    default:
+      /* TINYXML_UNKNOWN：原样输出 */
+      PutIndent( depth );
+      Put( '<' );
+      Put( node->value );
+      Put( '>' );
+      PutLineBreak();
+      return false;
+  }
+}
+
+void TiXmlWriter::Close( const TiXmlNode* node, int depth )
+{
+  if ( !node->ToElement() )
+    return;
+  PutIndent( depth );
+  Put( "</", 2 );
+  Put( node->value );
+  Put( '>' );
+  PutLineBreak();
+}
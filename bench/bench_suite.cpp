@@ -0,0 +1,505 @@
+/* 性能测试集。用固定种子生成几类合成文档，对每类文档分别测量：
+ *   parse       TiXmlDocument::Parse()
+ *   load        TiXmlDocument::LoadFile()(先把文档写到临时文件)
+ *   navigate    FirstChildElement()/NextSiblingElement()遍历所有元素
+ *   iterate     IterateChildren()遍历所有节点
+ *   attributes  对所有属性调用QueryIntValue()和QueryDoubleValue()
+ *   encode      对所有文本和属性值调用TiXmlBase::EncodeString()
+ *   print       Print()到临时文件
+ *   save        SaveFile()
+ * 文档的种类：
+ *   deep        很深的嵌套，每层只有少数几个子元素
+ *   wide        根元素下有大量平铺的子元素
+ *   attributes  每个元素带很多属性(整数、小数、字符串)
+ *   text        以大段文本为主
+ *   entities    文本和属性值中有大量实体引用和字符引用
+ * 每类都有UTF-8和legacy(ISO-8859-1)两种编码。相同的参数总是生成相同的文档，不同提交的结果可以直接对比。
+ *
+ * 每个结果输出一行JSON，包括耗时、MB/s、节点/s、这段时间内的内存分配次数和字节数，以及进程的峰值RSS(KB)。
+ * 峰值RSS是整个进程到这时为止的最大值，只会增加，比较时应该看同一个位置上的值。
+ * 程序只用公开的接口：
+ *
+ *   g++ -O2 bench/bench_suite.cpp tinyxml.cpp tinyxmlparser.cpp tinyxmlerror.cpp -I. -o bench_suite
+ *   ./bench_suite [--size MB] [--rounds N] [--corpus 名字] [--write-corpus 目录] > result.jsonl
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <new>
+#include <string>
+
+#if defined( _WIN32 )
+  #include <windows.h>
+  #include <psapi.h>
+#else
+  #include <sys/resource.h>
+#endif
+
+#include "tinyxml.h"
+
+/* 统计内存分配。替换全局的operator new/delete，只计数，不改变分配的方式 */
+static unsigned long long allocCount = 0;
+static unsigned long long allocBytes = 0;
+
+void* operator new( size_t size )
+{
+  ++allocCount;
+  allocBytes += size;
+  void* p = malloc( size ? size : 1 );
+  if ( !p )
+    throw std::bad_alloc();
+  return p;
+}
+#if __cplusplus >= 201103L
+  #define BENCH_NOTHROW noexcept
+#else
+  #define BENCH_NOTHROW throw()
+#endif
+void* operator new[]( size_t size )           { return operator new( size ); }
+void operator delete( void* p ) BENCH_NOTHROW   { free( p ); }
+void operator delete[]( void* p ) BENCH_NOTHROW { free( p ); }
+
+static long PeakRssKB()
+{
+#if defined( _WIN32 )
+  PROCESS_MEMORY_COUNTERS counters;
+  if ( GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) )
+    return (long)( counters.PeakWorkingSetSize / 1024 );
+  return -1;
+#else
+  struct rusage usage;
+  if ( getrusage( RUSAGE_SELF, &usage ) != 0 )
+    return -1;
+  #if defined( __APPLE__ )
+  return (long)( usage.ru_maxrss / 1024 );    /* macOS上是字节 */
+  #else
+  return (long)usage.ru_maxrss;
+  #endif
+#endif
+}
+
+/* 生成器用的随机数，线性同余，和平台无关 */
+class Random
+{
+public:
+  explicit Random( unsigned int seed ) : state( seed ) {}
+  unsigned int Next( unsigned int n )
+  {
+    state = state * 1103515245u + 12345u;
+    return ( state >> 16 ) % n;
+  }
+private:
+  unsigned int state;
+};
+
+enum CorpusKind
+{
+  CORPUS_DEEP,
+  CORPUS_WIDE,
+  CORPUS_ATTRIBUTES,
+  CORPUS_TEXT,
+  CORPUS_ENTITIES,
+  CORPUS_COUNT
+};
+
+static const char* const corpusNames[ CORPUS_COUNT ] = { "deep", "wide", "attributes", "text", "entities" };
+
+/* 生成文档用的词。UTF-8和legacy各一套，legacy中的非ASCII字符是ISO-8859-1的单字节 */
+static const char* const utf8Words[] =
+{
+  "alpha", "beta", "gamma", "delta", "\xe6\xb2\x88\xe9\x98\xb3", "caf\xc3\xa9", "epsilon", "\xe6\x96\x87\xe6\xa1\xa3"
+};
+static const char* const legacyWords[] =
+{
+  "alpha", "beta", "gamma", "delta", "na\xefve", "caf\xe9", "epsilon", "\xfcber"
+};
+static const char* const entityWords[] =
+{
+  "&amp;", "&lt;b&gt;", "&quot;q&quot;", "&apos;", "&#169;", "&#x41;", "a&amp;b", "plain"
+};
+static const char* const elementNames[] =
+{
+  "item", "entry", "record", "node", "value", "group", "field", "row"
+};
+
+class CorpusWriter
+{
+public:
+  CorpusWriter( CorpusKind _kind, bool _utf8 ) : kind( _kind ), utf8( _utf8 ), random( 1000 + _kind * 2 + ( _utf8 ? 1 : 0 ) ) {}
+
+  std::string Make( size_t bytes )
+  {
+    xml = utf8 ? "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n" : "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>\n";
+    xml += "<corpus>\n";
+    while ( xml.size() < bytes )
+    {
+      switch ( kind )
+      {
+        case CORPUS_DEEP:       Deep( 0 ); break;
+        case CORPUS_WIDE:       Wide(); break;
+        case CORPUS_ATTRIBUTES: Attributes(); break;
+        case CORPUS_TEXT:       Text(); break;
+        default:                Entities(); break;
+      }
+    }
+    xml += "</corpus>\n";
+    return xml;
+  }
+
+private:
+  const char* Word()
+  {
+    return ( utf8 ? utf8Words : legacyWords )[ random.Next( 8 ) ];
+  }
+  const char* Name()
+  {
+    return elementNames[ random.Next( 8 ) ];
+  }
+  void Number( bool fraction )
+  {
+    char buf[32];
+    if ( fraction )
+      sprintf( buf, "%u.%03u", random.Next( 100000 ), random.Next( 1000 ) );
+    else
+      sprintf( buf, "%u", random.Next( 1000000 ) );
+    xml += buf;
+  }
+  void Words( int count )
+  {
+    for ( int i = 0; i < count; ++i )
+    {
+      if ( i )
+        xml += ( i % 12 == 0 ) ? "\n    " : " ";
+      xml += Word();
+    }
+  }
+
+  /* 深度40左右，每层1到3个子元素 */
+  void Deep( int depth )
+  {
+    const char* name = Name();
+    xml += "<"; xml += name; xml += " level=\""; Number( false ); xml += "\">";
+    if ( depth < 40 )
+    {
+      const unsigned int children = 1 + ( depth % 8 == 0 ? random.Next( 3 ) : 0 );
+      for ( unsigned int i = 0; i < children; ++i )
+        Deep( depth + 1 );
+    }
+    else
+      xml += Word();
+    xml += "</"; xml += name; xml += ">";
+  }
+
+  /* 一个元素一行，都是根元素的直接子元素 */
+  void Wide()
+  {
+    const char* name = Name();
+    xml += "  <"; xml += name; xml += " id=\""; Number( false ); xml += "\">";
+    xml += Word();
+    xml += "</"; xml += name; xml += ">\n";
+  }
+
+  void Attributes()
+  {
+    xml += "  <"; xml += Name();
+    for ( int i = 0; i < 12; ++i )
+    {
+      char attr[16];
+      sprintf( attr, " a%d=\"", i );
+      xml += attr;
+      switch ( i % 3 )
+      {
+        case 0:   Number( false ); break;
+        case 1:   Number( true ); break;
+        default:  xml += Word(); break;
+      }
+      xml += "\"";
+    }
+    xml += "/>\n";
+  }
+
+  void Text()
+  {
+    const char* name = Name();
+    xml += "  <"; xml += name; xml += ">\n    ";
+    Words( 60 + random.Next( 60 ) );
+    xml += "\n  </"; xml += name; xml += ">\n";
+  }
+
+  void Entities()
+  {
+    xml += "  <entry title=\"";
+    xml += entityWords[ random.Next( 8 ) ];
+    xml += "\">";
+    for ( int i = 0; i < 24; ++i )
+    {
+      if ( i )
+        xml += " ";
+      xml += entityWords[ random.Next( 8 ) ];
+    }
+    xml += "</entry>\n";
+  }
+
+  CorpusKind  kind;
+  bool        utf8;
+  Random      random;
+  std::string xml;
+};
+
+/* 一次测量的结果 */
+struct Measure
+{
+  clock_t             start;
+  unsigned long long  allocs;
+  unsigned long long  bytes;
+
+  void Begin()
+  {
+    allocs = allocCount;
+    bytes = allocBytes;
+    start = clock();
+  }
+  /* items是处理的节点(或属性、字符串)个数，size是处理的字节数 */
+  void End( const char* corpus, const char* encoding, const char* bench, int rounds,
+            unsigned long long size, unsigned long long items )
+  {
+    double seconds = (double)( clock() - start ) / CLOCKS_PER_SEC;
+    const unsigned long long a = allocCount - allocs;
+    const unsigned long long b = allocBytes - bytes;
+    if ( seconds <= 0 )
+      seconds = 1e-9;
+    printf( "{\"corpus\":\"%s\",\"encoding\":\"%s\",\"bench\":\"%s\",\"rounds\":%d,"
+            "\"bytes\":%llu,\"items\":%llu,\"seconds\":%.6f,\"mb_per_s\":%.2f,\"items_per_s\":%.0f,"
+            "\"allocs\":%llu,\"alloc_bytes\":%llu,\"peak_rss_kb\":%ld}\n",
+            corpus, encoding, bench, rounds,
+            size, items, seconds, (double)size * rounds / ( 1024.0 * 1024.0 ) / seconds, (double)items * rounds / seconds,
+            a / rounds, b / rounds, PeakRssKB() );
+    fflush( stdout );
+  }
+};
+
+/* 遍历用的几个函数，返回访问到的节点数。结果累加到sink，防止被优化掉 */
+static unsigned long long sink = 0;
+
+static unsigned long long Navigate( const TiXmlElement* element )
+{
+  unsigned long long count = 1;
+  for ( const TiXmlElement* child = element->FirstChildElement(); child; child = child->NextSiblingElement() )
+    count += Navigate( child );
+  return count;
+}
+
+static unsigned long long Iterate( const TiXmlNode* node )
+{
+  unsigned long long count = 1;
+  const TiXmlNode* child = 0;
+  while ( ( child = node->IterateChildren( child ) ) != 0 )
+    count += Iterate( child );
+  return count;
+}
+
+static unsigned long long QueryAttributes( const TiXmlElement* element )
+{
+  unsigned long long count = 0;
+  for ( const TiXmlAttribute* attrib = element->FirstAttribute(); attrib; attrib = attrib->Next() )
+  {
+    int i = 0;
+    double d = 0;
+    if ( attrib->QueryIntValue( &i ) == TIXML_SUCCESS )
+      sink += i;
+    if ( attrib->QueryDoubleValue( &d ) == TIXML_SUCCESS )
+      sink += (unsigned long long)d;
+    ++count;
+  }
+  for ( const TiXmlElement* child = element->FirstChildElement(); child; child = child->NextSiblingElement() )
+    count += QueryAttributes( child );
+  return count;
+}
+
+/* 返回编码的字符串个数，*size累加输入的字节数 */
+static unsigned long long Encode( const TiXmlNode* node, unsigned long long* size )
+{
+  unsigned long long count = 0;
+  TIXML_STRING out;
+  if ( node->ToText() )
+  {
+    const char* value = node->Value();
+    const size_t length = strlen( value );
+    TiXmlBase::EncodeString( value, length, &out );
+    *size += length;
+    ++count;
+  }
+  if ( const TiXmlElement* element = node->ToElement() )
+  {
+    for ( const TiXmlAttribute* attrib = element->FirstAttribute(); attrib; attrib = attrib->Next() )
+    {
+      const size_t length = strlen( attrib->Value() );
+      out = "";
+      TiXmlBase::EncodeString( attrib->Value(), length, &out );
+      *size += length;
+      ++count;
+    }
+  }
+  sink += out.length();
+  for ( const TiXmlNode* child = node->FirstChild(); child; child = child->NextSibling() )
+    count += Encode( child, size );
+  return count;
+}
+
+static long FileSize( const char* filename )
+{
+  FILE* file = fopen( filename, "rb" );
+  if ( !file )
+    return 0;
+  fseek( file, 0, SEEK_END );
+  long size = ftell( file );
+  fclose( file );
+  return size;
+}
+
+static void Fail( const char* what, const TiXmlDocument& doc )
+{
+  fprintf( stderr, "%s failed: %s\n", what, doc.ErrorDesc() );
+  exit( 1 );
+}
+
+static void RunCorpus( CorpusKind kind, bool utf8, size_t bytes, int rounds, const char* corpusDir )
+{
+  const char* corpus = corpusNames[ kind ];
+  const char* encodingName = utf8 ? "utf-8" : "legacy";
+  const TiXmlEncoding encoding = utf8 ? TIXML_ENCODING_UTF8 : TIXML_ENCODING_LEGACY;
+
+  CorpusWriter writer( kind, utf8 );
+  const std::string xml = writer.Make( bytes );
+
+  std::string input = "bench_suite_input.xml";
+  if ( corpusDir )
+    input = std::string( corpusDir ) + "/" + corpus + "-" + encodingName + ".xml";
+  FILE* file = fopen( input.c_str(), "wb" );
+  if ( !file || fwrite( xml.data(), 1, xml.size(), file ) != xml.size() )
+  {
+    fprintf( stderr, "cannot write %s\n", input.c_str() );
+    exit( 1 );
+  }
+  fclose( file );
+
+  TiXmlParseOptions options;
+  options.SetEncoding( encoding );
+
+  Measure m;
+  unsigned long long nodes = 0;
+
+  m.Begin();
+  for ( int i = 0; i < rounds; ++i )
+  {
+    TiXmlDocument doc;
+    doc.Parse( xml.c_str(), options );
+    if ( doc.Error() )
+      Fail( "parse", doc );
+    if ( i == 0 )
+      nodes = Iterate( &doc );
+  }
+  m.End( corpus, encodingName, "parse", rounds, xml.size(), nodes );
+
+  m.Begin();
+  for ( int i = 0; i < rounds; ++i )
+  {
+    TiXmlDocument doc;
+    if ( !doc.LoadFile( input.c_str(), encoding ) )
+      Fail( "load", doc );
+  }
+  m.End( corpus, encodingName, "load", rounds, xml.size(), nodes );
+
+  /* 以下几项共用一个解析好的文档，只测遍历和转换本身 */
+  TiXmlDocument doc;
+  doc.Parse( xml.c_str(), options );
+  if ( doc.Error() )
+    Fail( "parse", doc );
+
+  unsigned long long items = 0;
+  m.Begin();
+  for ( int i = 0; i < rounds; ++i )
+    items = Navigate( doc.RootElement() );
+  m.End( corpus, encodingName, "navigate", rounds, 0, items );
+
+  m.Begin();
+  for ( int i = 0; i < rounds; ++i )
+    items = Iterate( &doc );
+  m.End( corpus, encodingName, "iterate", rounds, 0, items );
+
+  m.Begin();
+  for ( int i = 0; i < rounds; ++i )
+    items = QueryAttributes( doc.RootElement() );
+  m.End( corpus, encodingName, "attributes", rounds, 0, items );
+
+  unsigned long long encoded = 0;
+  m.Begin();
+  for ( int i = 0; i < rounds; ++i )
+  {
+    encoded = 0;
+    items = Encode( &doc, &encoded );
+  }
+  m.End( corpus, encodingName, "encode", rounds, encoded, items );
+
+  const char* output = "bench_suite_output.xml";
+  m.Begin();
+  for ( int i = 0; i < rounds; ++i )
+  {
+    FILE* out = fopen( output, "wb" );
+    if ( !out )
+      Fail( "print", doc );
+    doc.Print( out, 0 );
+    fclose( out );
+  }
+  m.End( corpus, encodingName, "print", rounds, FileSize( output ), nodes );
+
+  m.Begin();
+  for ( int i = 0; i < rounds; ++i )
+  {
+    if ( !doc.SaveFile( output ) )
+      Fail( "save", doc );
+  }
+  m.End( corpus, encodingName, "save", rounds, FileSize( output ), nodes );
+
+  remove( output );
+  if ( !corpusDir )
+    remove( input.c_str() );
+}
+
+int main( int argc, char** argv )
+{
+  size_t megabytes = 8;
+  int rounds = 5;
+  const char* only = 0;
+  const char* corpusDir = 0;
+
+  for ( int i = 1; i < argc; ++i )
+  {
+    if ( strcmp( argv[i], "--size" ) == 0 && i + 1 < argc )
+      megabytes = (size_t)atoi( argv[++i] );
+    else if ( strcmp( argv[i], "--rounds" ) == 0 && i + 1 < argc )
+      rounds = atoi( argv[++i] );
+    else if ( strcmp( argv[i], "--corpus" ) == 0 && i + 1 < argc )
+      only = argv[++i];
+    else if ( strcmp( argv[i], "--write-corpus" ) == 0 && i + 1 < argc )
+      corpusDir = argv[++i];
+    else
+    {
+      fprintf( stderr, "usage: %s [--size MB] [--rounds N] [--corpus deep|wide|attributes|text|entities] [--write-corpus DIR]\n", argv[0] );
+      return 2;
+    }
+  }
+  if ( rounds < 1 )
+    rounds = 1;
+
+  for ( int kind = 0; kind < CORPUS_COUNT; ++kind )
+  {
+    if ( only && strcmp( only, corpusNames[ kind ] ) != 0 )
+      continue;
+    RunCorpus( (CorpusKind)kind, true, megabytes * 1024 * 1024, rounds, corpusDir );
+    RunCorpus( (CorpusKind)kind, false, megabytes * 1024 * 1024, rounds, corpusDir );
+  }
+  fprintf( stderr, "checksum %llu\n", sink );
+  return 0;
+}
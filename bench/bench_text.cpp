@@ -0,0 +1,109 @@
+/* 文本解析的吞吐量测试。
+ * 生成三种以文本内容为主的文档：混合(大量空白、少量实体引用和多字节字符)、
+ * 以中文为主(几乎全是多字节字符)、实体引用密集(&amp;、&lt;、&#...;)，
+ * 分别按UTF-8/legacy编码、合并/不合并空白解析若干次，输出每种组合的MB/s。
+ * 程序只用公开的接口，可以和ReadText()特化之前的版本用同一份源码对比：
+ *
+ *   g++ -O2 bench/bench_text.cpp tinyxml.cpp tinyxmlparser.cpp tinyxmlerror.cpp -I. -o bench_text
+ *   ./bench_text [MB] [次数]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <string>
+
+#include "tinyxml.h"
+
+/* 每种文档的8个词 */
+static const char* const mixedWords[] =
+{
+  "alpha", "beta", "gamma", "delta", "\xe6\xb2\x88\xe9\x98\xb3", "&amp;", "epsilon", "&lt;tag&gt;"
+};
+static const char* const cjkWords[] =
+{
+  "\xe6\xb2\x88\xe9\x98\xb3", "\xe5\x8c\x97\xe4\xba\xac\xe5\xb8\x82", "\xe8\xa7\xa3\xe6\x9e\x90\xe5\x99\xa8",
+  "\xe6\x96\x87\xe6\xa1\xa3", "\xe8\x8a\x82\xe7\x82\xb9\xe5\x80\xbc", "\xe5\xb1\x9e\xe6\x80\xa7",
+  "\xe7\xbc\x96\xe7\xa0\x81", "\xe6\xb5\x8b\xe8\xaf\x95"
+};
+static const char* const entityWords[] =
+{
+  "&amp;", "&lt;", "&gt;", "&quot;", "&apos;", "&#169;", "&#x4E2D;", "a&amp;b"
+};
+
+static std::string MakeDocument( size_t bytes, const char* const* words )
+{
+  std::string xml = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<feed>\n";
+  unsigned int seed = 12345;
+  while ( xml.size() < bytes )
+  {
+    xml += "  <entry id=\"42\">";
+    for ( int i = 0; i < 40; ++i )
+    {
+      seed = seed * 1103515245u + 12345u;
+      xml += words[ ( seed >> 16 ) % 8 ];
+      xml += ( i % 8 == 7 ) ? "\n      " : "  ";
+    }
+    xml += "</entry>\n";
+  }
+  xml += "</feed>\n";
+  return xml;
+}
+
+static double Run( const std::string& xml, TiXmlEncoding encoding, bool condense, int rounds )
+{
+  TiXmlParseOptions options;
+  options.SetEncoding( encoding );
+  options.SetCondenseWhiteSpace( condense );
+
+  clock_t start = clock();
+  for ( int i = 0; i < rounds; ++i )
+  {
+    TiXmlDocument doc;
+    doc.Parse( xml.c_str(), options );
+    if ( doc.Error() )
+    {
+      printf( "parse error: %s\n", doc.ErrorDesc() );
+      exit( 1 );
+    }
+  }
+  double seconds = (double)( clock() - start ) / CLOCKS_PER_SEC;
+  return (double)xml.size() * rounds / ( 1024.0 * 1024.0 ) / seconds;
+}
+
+int main( int argc, char** argv )
+{
+  size_t megabytes = argc > 1 ? (size_t)atoi( argv[1] ) : 32;
+  int rounds = argc > 2 ? atoi( argv[2] ) : 5;
+
+  static const struct
+  {
+    const char*         name;
+    const char* const*  words;
+  } documents[] =
+  {
+    { "mixed",    mixedWords },
+    { "cjk",      cjkWords },
+    { "entities", entityWords },
+  };
+
+  static const struct
+  {
+    const char*   name;
+    TiXmlEncoding encoding;
+    bool          condense;
+  } cases[] =
+  {
+    { "utf-8,  condense", TIXML_ENCODING_UTF8,   true  },
+    { "utf-8,  preserve", TIXML_ENCODING_UTF8,   false },
+    { "legacy, condense", TIXML_ENCODING_LEGACY, true  },
+    { "legacy, preserve", TIXML_ENCODING_LEGACY, false },
+  };
+  for ( size_t d = 0; d < sizeof( documents ) / sizeof( documents[0] ); ++d )
+  {
+    std::string xml = MakeDocument( megabytes * 1024 * 1024, documents[d].words );
+    printf( "%s document: %lu bytes, %d rounds\n", documents[d].name, (unsigned long)xml.size(), rounds );
+    for ( size_t i = 0; i < sizeof( cases ) / sizeof( cases[0] ); ++i )
+      printf( "  %s  %8.1f MB/s\n", cases[i].name, Run( xml, cases[i].encoding, cases[i].condense, rounds ) );
+  }
+  return 0;
+}
@@ -0,0 +1,88 @@
+/* 测试程序共用的部分：CHECK宏、失败计数、写临时文件和最后的汇总。
+ * 仓库里每个类是一个TiXmlXxx.cpp，没有单独的头文件，这里按依赖顺序把它们都包含进来，
+ * 所以每个测试只需要编译自己：
+ *
+ *   g++ -O2 -I. test/test_xxx.cpp -o test_xxx
+ *   ./test_xxx
+ *
+ * 需要C++11的测试(移动语义)加-std=c++11，需要线程的测试加-DTIXML_USE_THREADS -pthread
+ */
+#ifndef TIXML_TEST_INCLUDED
+#define TIXML_TEST_INCLUDED
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <float.h>
+#include <math.h>
+#include <errno.h>
+#include <assert.h>
+#include <new>
+#if __cplusplus >= 201103L
+#include <utility>
+#endif
+
+#include "TiXmlArena.cpp"
+#include "TiXmlStringRef.cpp"
+#include "TiXmlStringPool.cpp"
+#include "TiXmlNameTable.cpp"
+#include "TiXmlConvert.cpp"
+#include "TiXmlScanner.cpp"
+#include "TiXmlParseOptions.cpp"
+#include "TiXmlParsingData.cpp"
+#include "TiXmlParseStats.cpp"
+#include "TiXmlLineIndex.cpp"
+#include "TiXmlBase.cpp"
+#include "TiXmlNode.cpp"
+#include "TiXmlAttribute.cpp"
+#include "TiXmlAttributeSet.cpp"
+#include "TiXmlElement.cpp"
+#include "TiXmlText.cpp"
+#include "TiXmlWriter.cpp"
+#include "TiXmlFileMapping.cpp"
+#include "TiXmlDocument.cpp"
+#include "TiXmlReader.cpp"
+#include "TiXmlIncrementalParser.cpp"
+#include "TiXmlParallelParser.cpp"
+#include "TiXmlBatchLoader.cpp"
+#include "TiXmlSnapshot.cpp"
+#include "TiXmlFrozenDocument.cpp"
+#include "TiXmlFrozenNode.cpp"
+#include "TiXmlQuery.cpp"
+#include "TiXmlQueryIterator.cpp"
+
+static int failures = 0;
+
+#define CHECK( cond )                                                   \
+  do                                                                    \
+  {                                                                     \
+    if ( !( cond ) )                                                    \
+    {                                                                   \
+      fprintf( stderr, "%s:%d: CHECK( %s ) failed\n", __FILE__, __LINE__, #cond ); \
+      ++failures;                                                       \
+    }                                                                   \
+  } while ( 0 )
+
+/* 把content写到filename，测试结束后由调用者remove() */
+static bool WriteFile( const char* filename, const char* content )
+{
+  FILE* fp = fopen( filename, "wb" );
+  if ( !fp )
+    return false;
+  fputs( content, fp );
+  fclose( fp );
+  return true;
+}
+
+/* 打印汇总，返回值直接作为main()的返回值 */
+static int Report()
+{
+  if ( failures )
+    fprintf( stderr, "%d check(s) failed\n", failures );
+  else
+    printf( "all passed\n" );
+  return failures ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,142 @@
+/* 属性的散列索引(TiXmlAttributeSet::INDEX_THRESHOLD)：属性个数在阈值上下来回变化时，
+ * 添加、删除和改名以后按名字都能找到，找不到已经删掉或改掉的名字，遍历顺序保持属性出现的顺序。
+ * 全部通过时返回0。
+ * 编译方法见TiXmlTest.h
+ */
+#include "TiXmlTest.h"
+
+enum { COUNT = 2 * TiXmlAttributeSet::INDEX_THRESHOLD + 8 };
+
+static void Name( char* buf, const char* prefix, int i )
+{
+  sprintf( buf, "%s%d", prefix, i );
+}
+
+/* present[i]为true的属性prefix<i>都能找到，值是i，并且按i的顺序排列；其余的找不到 */
+static void Verify( const TiXmlElement& element, const char* prefix, const bool* present )
+{
+  char name[32];
+  int expected = 0;
+  for ( int i = 0; i < COUNT; ++i )
+  {
+    Name( name, prefix, i );
+    int value = -1;
+    if ( present[i] )
+    {
+      ++expected;
+      CHECK( element.QueryIntAttribute( name, &value ) == TIXML_SUCCESS && value == i );
+    }
+    else
+      CHECK( element.Attribute( name ) == 0 );
+  }
+
+  int count = 0;
+  int last = -1;
+  for ( const TiXmlAttribute* attribute = element.FirstAttribute(); attribute; attribute = attribute->Next() )
+  {
+    int i = attribute->IntValue();
+    CHECK( i > last && i < COUNT && present[i] );
+    last = i;
+    ++count;
+  }
+  CHECK( count == expected );
+}
+
+int main()
+{
+  char name[32];
+  bool present[COUNT];
+  memset( present, 0, sizeof( present ) );
+
+  TiXmlElement element( "e" );
+
+  /* 逐个添加，越过阈值时建立索引 */
+  for ( int i = 0; i < COUNT; ++i )
+  {
+    Name( name, "a", i );
+    element.SetAttribute( name, i );
+    present[i] = true;
+    Verify( element, "a", present );
+  }
+
+  /* 已有的属性只改值，不会重复添加 */
+  Name( name, "a", TiXmlAttributeSet::INDEX_THRESHOLD );
+  element.SetAttribute( name, TiXmlAttributeSet::INDEX_THRESHOLD );
+  Verify( element, "a", present );
+
+  /* 删到阈值以下，再加回来 */
+  for ( int i = 0; i < COUNT; i += 2 )
+  {
+    Name( name, "a", i );
+    element.RemoveAttribute( name );
+    present[i] = false;
+    Verify( element, "a", present );
+  }
+  for ( int i = 0; i < COUNT; ++i )
+  {
+    if ( i % 3 == 0 )
+      continue;
+    Name( name, "a", i );
+    element.RemoveAttribute( name );
+    present[i] = false;
+  }
+  Verify( element, "a", present );
+
+  /* 全部删掉以后重新添加，顺序按新的添加顺序 */
+  for ( int i = 0; i < COUNT; ++i )
+  {
+    Name( name, "a", i );
+    element.RemoveAttribute( name );
+    present[i] = false;
+  }
+  CHECK( element.FirstAttribute() == 0 );
+  for ( int i = 0; i < COUNT; ++i )
+  {
+    Name( name, "a", i );
+    element.SetAttribute( name, i );
+    present[i] = true;
+  }
+  Verify( element, "a", present );
+
+  /* 逐个改名：新名字找得到，旧名字找不到，顺序不变 */
+  bool renamed[COUNT];
+  memset( renamed, 0, sizeof( renamed ) );
+  int i = 0;
+  for ( TiXmlAttribute* attribute = element.FirstAttribute(); attribute; attribute = attribute->Next(), ++i )
+  {
+    Name( name, "b", i );
+    attribute->SetName( name );
+    present[i] = false;
+    renamed[i] = true;
+    Verify( element, "a", present );
+    Verify( element, "b", renamed );
+  }
+
+  /* 解析时超过阈值的元素：重复的属性照样能发现 */
+  {
+    TIXML_STRING xml = "<e";
+    for ( int i = 0; i < COUNT; ++i )
+    {
+      char attribute[64];
+      sprintf( attribute, " a%d=\"%d\"", i, i );
+      xml += attribute;
+    }
+    TIXML_STRING good = xml;
+    good += "/>";
+    xml += " a3=\"3\"/>";
+
+    TiXmlDocument doc;
+    doc.Parse( good.c_str() );
+    CHECK( !doc.Error() );
+    for ( int i = 0; i < COUNT; ++i )
+      present[i] = true;
+    if ( doc.RootElement() )
+      Verify( *doc.RootElement(), "a", present );
+
+    TiXmlDocument duplicate;
+    duplicate.Parse( xml.c_str() );
+    CHECK( duplicate.Error() && duplicate.ErrorId() == TiXmlBase::TIXML_ERROR_PARSING_ELEMENT );
+  }
+
+  return Report();
+}
@@ -0,0 +1,80 @@
+/* 分段解析(FeedChunk()/Finish())：同一份输入在任意一个字节处分成两块，以及每次只给一个字节，
+ * 得到的树都要和一次Parse()的结果相同。断点会落在名字、实体引用、属性值、注释、CDATA、
+ * UTF-8的多字节字符和"\r\n"的中间。
+ * 全部通过时返回0。
+ * 编译方法见TiXmlTest.h
+ */
+#include "TiXmlTest.h"
+
+static void Serialize( const TiXmlDocument& doc, TIXML_STRING* str )
+{
+  TiXmlWriter writer( TiXmlWriter::COMPACT );
+  writer.Write( doc );
+  str->assign( writer.CStr(), writer.Size() );
+}
+
+int main()
+{
+  const char* xml =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<!DOCTYPE feed>\n"
+    "<!-- head -- comment -->\n"
+    "<feed xmlns:x=\"urn:x\" title='a &gt; b'>\n"
+    "  <entry id=\"1\" note=\"x > y &amp; z\">Tom &amp; Jerry &#x4E2D;&#25991;\r\n 中文 text</entry>\n"
+    "  <x:entry id='2'><![CDATA[a ]] b ]]> c <not a tag>]]></x:entry>\n"
+    "  <empty/><empty a=\"\" />\n"
+    "  <?pi data?>\n"
+    "</feed>\n";
+  const size_t length = strlen( xml );
+
+  TiXmlDocument whole;
+  whole.Parse( xml );
+  CHECK( !whole.Error() );
+  TIXML_STRING expected;
+  Serialize( whole, &expected );
+
+  /* 在每一个位置分成两块 */
+  for ( size_t split = 0; split <= length; ++split )
+  {
+    TiXmlDocument doc;
+    CHECK( doc.FeedChunk( xml, split ) );
+    CHECK( doc.FeedChunk( xml + split, length - split ) );
+    CHECK( doc.Finish() );
+    CHECK( !doc.Error() );
+
+    TIXML_STRING actual;
+    Serialize( doc, &actual );
+    if ( actual != expected )
+    {
+      fprintf( stderr, "split at %lu differs\n", (unsigned long)split );
+      CHECK( actual == expected );
+    }
+  }
+
+  /* 每次一个字节 */
+  {
+    TiXmlDocument doc;
+    for ( size_t i = 0; i < length; ++i )
+      CHECK( doc.FeedChunk( xml + i, 1 ) );
+    CHECK( doc.Finish() );
+    TIXML_STRING actual;
+    Serialize( doc, &actual );
+    CHECK( actual == expected );
+  }
+
+  /* 出错的输入不管在哪里断开都要报错 */
+  {
+    const char* bad = "<feed><entry id=\"1\">text</entyr></feed>";
+    const size_t badLength = strlen( bad );
+    for ( size_t split = 0; split <= badLength; ++split )
+    {
+      TiXmlDocument doc;
+      bool ok = doc.FeedChunk( bad, split );
+      ok = ok && doc.FeedChunk( bad + split, badLength - split );
+      ok = ok && doc.Finish();
+      CHECK( !ok && doc.Error() );
+    }
+  }
+
+  return Report();
+}
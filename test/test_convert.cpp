@@ -0,0 +1,45 @@
+/* TiXmlConvert的边界情况：-0.0的符号、带符号的NaN、全部C locale空白、STRICT下的浮点溢出。
+ * 全部通过时返回0。
+ * 编译方法见TiXmlTest.h
+ */
+#include "TiXmlTest.h"
+
+static int ToDouble( const char* s, double* d, TiXmlConvert::Mode mode )
+{
+  return TiXmlConvert::ToDouble( s, strlen( s ), d, mode );
+}
+
+int main()
+{
+  char buffer[ TiXmlConvert::BUFFER_SIZE ];
+
+  /* -0.0写出来要能读回负零 */
+  CHECK( TiXmlConvert::FromDouble( -0.0, buffer ) == 2 && strcmp( buffer, "-0" ) == 0 );
+  CHECK( TiXmlConvert::FromDouble( 0.0, buffer ) == 1 && strcmp( buffer, "0" ) == 0 );
+  double d = 1;
+  CHECK( ToDouble( "-0", &d, TiXmlConvert::STRICT ) == TIXML_SUCCESS && d == 0 && 1 / d < 0 );
+
+  /* 带符号的NaN */
+  d = 1;
+  CHECK( ToDouble( "-NaN", &d, TiXmlConvert::STRICT ) == TIXML_SUCCESS && d != d );
+  d = 1;
+  CHECK( ToDouble( "+NaN", &d, TiXmlConvert::STRICT ) == TIXML_SUCCESS && d != d );
+  CHECK( ToDouble( "-NaNx", &d, TiXmlConvert::STRICT ) == TIXML_WRONG_TYPE );
+
+  /* '\v'和'\f'也是空白 */
+  int i = 0;
+  CHECK( TiXmlConvert::ToInt( "\v\f12\f", 5, &i, TiXmlConvert::LENIENT ) == TIXML_SUCCESS && i == 12 );
+  bool b = false;
+  CHECK( TiXmlConvert::ToBool( "\vtrue\f", 6, &b, TiXmlConvert::LENIENT ) == TIXML_SUCCESS && b );
+
+  /* STRICT下超出double范围的值算类型不对，LENIENT下和strtod()一样得到无穷大 */
+  d = 1;
+  CHECK( ToDouble( "1e400", &d, TiXmlConvert::STRICT ) == TIXML_WRONG_TYPE && d == 1 );
+  CHECK( ToDouble( "-1e400", &d, TiXmlConvert::STRICT ) == TIXML_WRONG_TYPE && d == 1 );
+  CHECK( ToDouble( "1e400", &d, TiXmlConvert::LENIENT ) == TIXML_SUCCESS && d > 1e308 );
+  CHECK( ToDouble( "INF", &d, TiXmlConvert::STRICT ) == TIXML_SUCCESS && d > 1e308 );
+  /* 下溢不算错 */
+  CHECK( ToDouble( "1e-400", &d, TiXmlConvert::STRICT ) == TIXML_SUCCESS && d == 0 );
+
+  return Report();
+}
@@ -0,0 +1,73 @@
+/* TiXmlFrozenNode的空节点：和TiXmlHandle一样，从找不到的节点继续链式调用不能崩溃，
+ * 导航返回空节点，字符串返回0，查询返回TIXML_NO_ATTRIBUTE。全部通过时返回0。
+ * 编译方法见TiXmlTest.h
+ */
+#include "TiXmlTest.h"
+
+int main()
+{
+  TiXmlDocument doc;
+  doc.Parse( "<root><item id=\"1\">text</item></root>" );
+  CHECK( !doc.Error() );
+  TiXmlFrozenDocument* frozen = doc.Freeze();
+
+  /* 存在的路径照常工作 */
+  TiXmlFrozenNode item = frozen->RootElement().FirstChildElement( "item" );
+  CHECK( item );
+  CHECK( item.Attribute( "id" ) && strcmp( item.Attribute( "id" ), "1" ) == 0 );
+  CHECK( item.GetText() && strcmp( item.GetText(), "text" ) == 0 );
+
+  /* 从不存在的节点继续往下走 */
+  TiXmlFrozenNode missing = frozen->RootElement().FirstChildElement( "missing" );
+  CHECK( !missing );
+  CHECK( !missing.FirstChildElement( "a" ).FirstChild().NextSibling().NextSiblingElement( "b" ) );
+  CHECK( !missing.Parent() );
+  CHECK( !missing.FirstChild( "x" ) );
+  CHECK( !missing.NextSibling( "x" ) );
+  CHECK( !missing.FirstChildElement() );
+  CHECK( !missing.NextSiblingElement() );
+  CHECK( missing.Type() == -1 );
+  CHECK( missing.Value() == 0 );
+  CHECK( !missing.ValueIs( "missing" ) );
+  CHECK( !missing.IsElement() && !missing.IsText() && !missing.CDATA() );
+  CHECK( missing.GetText() == 0 );
+  CHECK( missing.FirstChildElement( "a" ).Attribute( "id" ) == 0 );
+  CHECK( missing.AttributeCount() == 0 );
+  CHECK( missing.AttributeName( 0 ) == 0 && missing.AttributeValue( 0 ) == 0 );
+
+  int i = 7;
+  long long ll = 7;
+  unsigned long long ull = 7;
+  double d = 7;
+  bool b = true;
+  CHECK( missing.QueryIntAttribute( "id", &i ) == TIXML_NO_ATTRIBUTE && i == 7 );
+  CHECK( missing.QueryInt64Attribute( "id", &ll ) == TIXML_NO_ATTRIBUTE && ll == 7 );
+  CHECK( missing.QueryUint64Attribute( "id", &ull ) == TIXML_NO_ATTRIBUTE && ull == 7 );
+  CHECK( missing.QueryDoubleAttribute( "id", &d ) == TIXML_NO_ATTRIBUTE && d == 7 );
+  CHECK( missing.QueryBoolAttribute( "id", &b ) == TIXML_NO_ATTRIBUTE && b );
+
+  /* 默认的mode和TiXmlElement一样：Int和Double是LENIENT，Int64等是STRICT */
+  TiXmlDocument lenient;
+  lenient.Parse( "<item n=\" 12px\" x=\"1.5em\"/>" );
+  TiXmlFrozenDocument* lenientFrozen = lenient.Freeze();
+  const TiXmlElement* element = lenient.RootElement();
+  TiXmlFrozenNode node = lenientFrozen->RootElement();
+  int ei = 0, fi = 0;
+  double ed = 0, fd = 0;
+  CHECK( element->QueryIntAttribute( "n", &ei ) == TIXML_SUCCESS );
+  CHECK( node.QueryIntAttribute( "n", &fi ) == TIXML_SUCCESS && fi == ei && fi == 12 );
+  CHECK( element->QueryDoubleAttribute( "x", &ed ) == TIXML_SUCCESS );
+  CHECK( node.QueryDoubleAttribute( "x", &fd ) == TIXML_SUCCESS && fd == ed && fd == 1.5 );
+  CHECK( element->QueryInt64Attribute( "n", &ll ) == TIXML_WRONG_TYPE );
+  CHECK( node.QueryInt64Attribute( "n", &ll ) == TIXML_WRONG_TYPE );
+  delete lenientFrozen;
+
+  /* 默认构造的空节点也一样 */
+  TiXmlFrozenNode empty;
+  CHECK( !empty.FirstChildElement( "item" ).NextSiblingElement() );
+  CHECK( empty.Attribute( "id" ) == 0 );
+
+  delete frozen;
+
+  return Report();
+}
@@ -0,0 +1,65 @@
+/* 就地解析(SetInSitu())的回归测试：属性值和不合并空白的文本中间有实体引用时，
+ * 解析结束后的就地解码要得到和普通解析相同的结果(以前会死循环)。
+ * 全部通过时返回0。
+ * 编译方法见TiXmlTest.h
+ */
+#include "TiXmlTest.h"
+
+/* 同一份内容分别用就地解析和普通解析加载 */
+static void Load( const char* filename, const char* content, bool condense, TiXmlDocument* inSitu, TiXmlDocument* plain )
+{
+  CHECK( WriteFile( filename, content ) );
+  inSitu->SetInSitu( true );
+  inSitu->SetCondenseWhiteSpace( condense );
+  CHECK( inSitu->LoadFile( filename ) );
+  plain->SetCondenseWhiteSpace( condense );
+  CHECK( plain->LoadFile( filename ) );
+  remove( filename );
+}
+
+int main()
+{
+  const char* filename = "test_insitu.xml";
+
+  /* 带引号的属性值总是不合并空白，实体引用在中间 */
+  {
+    TiXmlDocument inSitu, plain;
+    Load( filename, "<a b=\"x &amp; y\" c=\"Tom &amp; Jerry &#65;&#x42;\"/>", true, &inSitu, &plain );
+    const TiXmlElement* a = inSitu.RootElement();
+    CHECK( a != 0 );
+    if ( a )
+    {
+      CHECK( strcmp( a->Attribute( "b" ), "x & y" ) == 0 );
+      CHECK( strcmp( a->Attribute( "c" ), "Tom & Jerry AB" ) == 0 );
+      CHECK( strcmp( a->Attribute( "c" ), plain.RootElement()->Attribute( "c" ) ) == 0 );
+    }
+  }
+
+  /* 不合并空白的文本：实体引用、"\r\n"和单独的'\r'混在中间 */
+  {
+    TiXmlDocument inSitu, plain;
+    Load( filename, "<a>Tom &amp; Jerry\r\n  and &lt;friends&gt;\r!</a>", false, &inSitu, &plain );
+    const TiXmlElement* a = inSitu.RootElement();
+    CHECK( a != 0 && a->GetText() != 0 );
+    if ( a && a->GetText() )
+    {
+      CHECK( strcmp( a->GetText(), "Tom & Jerry\n  and <friends>\n!" ) == 0 );
+      CHECK( strcmp( a->GetText(), plain.RootElement()->GetText() ) == 0 );
+    }
+  }
+
+  /* 不认识的实体引用原样保留 */
+  {
+    TiXmlDocument inSitu, plain;
+    Load( filename, "<a b=\"1 &unknown; 2\">x &bogus y</a>", false, &inSitu, &plain );
+    const TiXmlElement* a = inSitu.RootElement();
+    CHECK( a != 0 );
+    if ( a )
+    {
+      CHECK( strcmp( a->Attribute( "b" ), plain.RootElement()->Attribute( "b" ) ) == 0 );
+      CHECK( strcmp( a->GetText(), plain.RootElement()->GetText() ) == 0 );
+    }
+  }
+
+  return Report();
+}
@@ -0,0 +1,53 @@
+/* LoadFileMapped()的回归测试：注释和未知节点中的"\r\n"、单独的'\r'要和LoadFile()一样换成'\n'；
+ * 打开失败时不能保留上一次加载的内容。全部通过时返回0。
+ * 编译方法见TiXmlTest.h
+ */
+#include "TiXmlTest.h"
+
+int main()
+{
+  const char* filename = "test_loadfile.xml";
+  CHECK( WriteFile( filename, "<!-- one\r\ntwo\rthree -->\r\n<a><!--x\r\ny--><!DOCTYPE a\r\n[]>t\r\nu</a>" ) );
+
+  TiXmlDocument plain, mapped;
+  CHECK( plain.LoadFile( filename ) );
+  CHECK( mapped.LoadFileMapped( filename ) );
+  remove( filename );
+
+  const TiXmlNode* p = plain.FirstChild();
+  const TiXmlNode* m = mapped.FirstChild();
+  CHECK( m != 0 && strcmp( m->Value(), " one\ntwo\nthree " ) == 0 );
+
+  /* 逐个节点比较，包括元素里面的注释和未知节点 */
+  while ( p && m )
+  {
+    CHECK( p->Type() == m->Type() );
+    CHECK( strchr( m->Value(), '\r' ) == 0 );
+    CHECK( strcmp( p->Value(), m->Value() ) == 0 );
+
+    if ( p->FirstChild() && m->FirstChild() )
+    {
+      p = p->FirstChild();
+      m = m->FirstChild();
+      continue;
+    }
+    while ( p && !p->NextSibling() )
+    {
+      p = p->Parent() != &plain ? p->Parent() : 0;
+      m = m->Parent() != &mapped ? m->Parent() : 0;
+    }
+    if ( p && m )
+    {
+      p = p->NextSibling();
+      m = m->NextSibling();
+    }
+  }
+  CHECK( !p && !m );
+
+  /* 打开失败时旧的节点已经清掉 */
+  CHECK( !mapped.LoadFileMapped( "test_loadfile_missing.xml" ) );
+  CHECK( mapped.Error() );
+  CHECK( mapped.FirstChild() == 0 );
+
+  return Report();
+}
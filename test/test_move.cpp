@@ -0,0 +1,89 @@
+/* 移动节点的回归测试：从使用内存池、名字表并且就地解析的文档中移出子树，
+ * 源文档析构以后移出来的内容仍然要能读。全部通过时返回0。
+ * 编译方法见TiXmlTest.h，需要-std=c++11
+ */
+#include "TiXmlTest.h"
+
+/* 名字、属性和文本都引用源文档的缓冲区、名字表和内存池 */
+static TiXmlDocument* Load( const char* filename )
+{
+  CHECK( WriteFile( filename,
+    "<list>"
+    "<item id=\"1\" name=\"first &amp; best\"><title>One</title><tag/></item>"
+    "<item id=\"2\" name=\"second\"><title>Two</title></item>"
+    "</list>" ) );
+
+  TiXmlDocument* doc = new TiXmlDocument();
+  CHECK( doc->UseArena( true ) );
+  CHECK( doc->UseNameTable( true ) );
+  doc->SetInSitu( true );
+  CHECK( doc->LoadFile( filename ) );
+  remove( filename );
+  return doc;
+}
+
+static void CheckItem( const TiXmlElement* item, const char* id, const char* name, const char* title )
+{
+  CHECK( item != 0 );
+  if ( !item )
+    return;
+  CHECK( strcmp( item->Value(), "item" ) == 0 );
+  CHECK( item->Attribute( "id" ) && strcmp( item->Attribute( "id" ), id ) == 0 );
+  CHECK( item->Attribute( "name" ) && strcmp( item->Attribute( "name" ), name ) == 0 );
+  const TiXmlElement* child = item->FirstChildElement( "title" );
+  CHECK( child != 0 && child->GetText() != 0 );
+  if ( child && child->GetText() )
+    CHECK( strcmp( child->GetText(), title ) == 0 );
+}
+
+int main()
+{
+  const char* filename = "test_move.xml";
+
+  /* 移动构造到栈上的元素，以及用右值插入另一个文档 */
+  {
+    TiXmlDocument* doc = Load( filename );
+    TiXmlElement* first = doc->RootElement()->FirstChildElement( "item" );
+    TiXmlElement* second = first->NextSiblingElement( "item" );
+
+    TiXmlElement moved( std::move( *first ) );
+    TiXmlDocument target;
+    target.InsertEndChild( TiXmlElement( "list" ) );
+    target.RootElement()->InsertEndChild( std::move( *second ) );
+
+    delete doc;
+
+    CheckItem( &moved, "1", "first & best", "One" );
+    CHECK( moved.FirstChildElement( "tag" ) != 0 );
+    CheckItem( target.RootElement()->FirstChildElement( "item" ), "2", "second", "Two" );
+  }
+
+  /* 移动赋值给已有的元素 */
+  {
+    TiXmlDocument* doc = Load( filename );
+    TiXmlElement moved( "old" );
+    moved.SetAttribute( "id", "0" );
+    moved = std::move( *doc->RootElement()->FirstChildElement( "item" ) );
+
+    delete doc;
+
+    CheckItem( &moved, "1", "first & best", "One" );
+  }
+
+  /* 移动单个文本节点和属性 */
+  {
+    TiXmlDocument* doc = Load( filename );
+    TiXmlText* text = doc->RootElement()->FirstChildElement( "item" )->FirstChildElement( "title" )->FirstChild()->ToText();
+    CHECK( text != 0 );
+    TiXmlText movedText( std::move( *text ) );
+    TiXmlAttribute movedAttribute( std::move( *doc->RootElement()->FirstChildElement( "item" )->FirstAttribute() ) );
+
+    delete doc;
+
+    CHECK( strcmp( movedText.Value(), "One" ) == 0 );
+    CHECK( strcmp( movedAttribute.Name(), "id" ) == 0 );
+    CHECK( strcmp( movedAttribute.Value(), "1" ) == 0 );
+  }
+
+  return Report();
+}
@@ -0,0 +1,111 @@
+/* 并行解析(SetParseThreads())和串行解析的结果必须完全相同：树的内容、每个节点的行列号，
+ * 以及出错时的错误码和行列号。没有定义TIXML_USE_THREADS时两边都是串行解析，检查照样通过。
+ * 全部通过时返回0。
+ * 编译方法见TiXmlTest.h，需要加-DTIXML_USE_THREADS -pthread
+ */
+#include "TiXmlTest.h"
+
+/* 一个根元素下面有大量兄弟节点，足够分成几段 */
+static void BuildFeed( TIXML_STRING* xml )
+{
+  char record[256];
+  *xml = "<?xml version=\"1.0\"?>\n<feed>\n";
+  for ( int i = 0; xml->length() < 4 * TiXmlParallelParser::MIN_SEGMENT; ++i )
+  {
+    sprintf( record, "  <record id=\"%d\" name='r%d'>Tom &amp; Jerry\t%d<child a=\"1\"/><!-- c --><![CDATA[<x>]]></record>\n", i, i, i );
+    *xml += record;
+  }
+  *xml += "</feed>\n";
+}
+
+static void Parse( TiXmlDocument* doc, const TIXML_STRING& xml, int threads )
+{
+  TiXmlParseOptions options;
+  options.SetTrackLocation( true );
+  doc->SetParseThreads( threads );
+  doc->Parse( xml.c_str(), options );
+}
+
+/* 先序同时走两棵树，比较类型、值和行列号 */
+static void CompareTrees( const TiXmlNode* a, const TiXmlNode* b )
+{
+  const TiXmlNode* rootA = a;
+  while ( a && b )
+  {
+    CHECK( a->Type() == b->Type() );
+    CHECK( strcmp( a->Value(), b->Value() ) == 0 );
+    CHECK( a->Row() == b->Row() && a->Column() == b->Column() );
+
+    if ( a->FirstChild() || b->FirstChild() )
+    {
+      a = a->FirstChild();
+      b = b->FirstChild();
+      continue;
+    }
+    while ( a && a != rootA && !a->NextSibling() )
+    {
+      a = a->Parent();
+      b = b->Parent();
+    }
+    if ( !a || a == rootA )
+      return;
+    a = a->NextSibling();
+    b = b ? b->NextSibling() : 0;
+  }
+  CHECK( !a && !b );
+}
+
+int main()
+{
+  TIXML_STRING xml;
+  BuildFeed( &xml );
+
+  /* 正确的文档 */
+  {
+    TiXmlDocument serial, parallel;
+    Parse( &serial, xml, 1 );
+    Parse( &parallel, xml, 4 );
+    CHECK( !serial.Error() && !parallel.Error() );
+
+    TiXmlWriter a( TiXmlWriter::COMPACT ), b( TiXmlWriter::COMPACT );
+    a.Write( serial );
+    b.Write( parallel );
+    CHECK( a.Size() == b.Size() && memcmp( a.CStr(), b.CStr(), a.Size() ) == 0 );
+    CompareTrees( &serial, &parallel );
+  }
+
+  /* 最后一段中有一个结束标签写错了：并行解析要退回串行，错误和串行完全相同 */
+  {
+    TIXML_STRING broken = xml;
+    size_t at = broken.length() - strlen( "</record>\n</feed>\n" );
+    CHECK( broken[ at + 7 ] == 'd' );
+    broken[ at + 7 ] = 'x';
+
+    TiXmlDocument serial, parallel;
+    Parse( &serial, broken, 1 );
+    Parse( &parallel, broken, 4 );
+    CHECK( serial.Error() && parallel.Error() );
+    CHECK( serial.ErrorId() == parallel.ErrorId() );
+    CHECK( serial.ErrorRow() == parallel.ErrorRow() );
+    CHECK( serial.ErrorCol() == parallel.ErrorCol() );
+    CHECK( strcmp( serial.ErrorDesc(), parallel.ErrorDesc() ) == 0 );
+  }
+
+  /* 第一段中的错误 */
+  {
+    TIXML_STRING broken = xml;
+    const char* hit = strstr( broken.c_str(), "</record>" );
+    CHECK( hit != 0 );
+    broken[ ( hit - broken.c_str() ) + 7 ] = 'x';
+
+    TiXmlDocument serial, parallel;
+    Parse( &serial, broken, 1 );
+    Parse( &parallel, broken, 4 );
+    CHECK( serial.Error() && parallel.Error() );
+    CHECK( serial.ErrorId() == parallel.ErrorId() );
+    CHECK( serial.ErrorRow() == parallel.ErrorRow() && serial.ErrorRow() == 3 );
+    CHECK( serial.ErrorCol() == parallel.ErrorCol() );
+  }
+
+  return Report();
+}
@@ -0,0 +1,144 @@
+/* 路径查询(TiXmlQuery/TiXmlQueryIterator)：语法、各种谓词、后代轴的去重和结果顺序，
+ * 以及用不用名字表(UseNameTable())结果都相同。
+ * 全部通过时返回0。
+ * 编译方法见TiXmlTest.h
+ */
+#include "TiXmlTest.h"
+
+static const char* xml =
+  "<library>"
+    "<shelf id='1'>"
+      "<book id='a' type='novel'/>"
+      "<book id='b' type='poem'/>"
+      "<book type='novel'/>"
+      "<magazine id='m'/>"
+    "</shelf>"
+    "<shelf id='2'>"
+      "<box><book id='c' type='novel'/></box>"
+      "<book id='d'/>"
+    "</shelf>"
+    "<section><section><book id='e'/></section></section>"
+  "</library>";
+
+/* expression在node上的所有结果的id，用','隔开，没有id的写'-' */
+static void Ids( TiXmlNode* node, const char* expression, TIXML_STRING* ids )
+{
+  *ids = "";
+  TiXmlQuery query( expression );
+  CHECK( query.Valid() );
+  TiXmlQueryIterator it( query, node );
+  while ( TiXmlElement* element = it.Next() )
+  {
+    if ( ids->length() )
+      *ids += ",";
+    const char* id = element->Attribute( "id" );
+    *ids += id ? id : "-";
+  }
+}
+
+static void Expect( TiXmlNode* node, const char* expression, const char* expected )
+{
+  TIXML_STRING ids;
+  Ids( node, expression, &ids );
+  if ( strcmp( ids.c_str(), expected ) != 0 )
+  {
+    fprintf( stderr, "%s: got \"%s\", expected \"%s\"\n", expression, ids.c_str(), expected );
+    CHECK( strcmp( ids.c_str(), expected ) == 0 );
+  }
+}
+
+static void Run( TiXmlDocument& doc )
+{
+  TiXmlElement* root = doc.RootElement();
+  CHECK( root != 0 );
+  if ( !root )
+    return;
+
+  /* 绝对路径和相对路径 */
+  Expect( &doc, "/library/shelf", "1,2" );
+  Expect( root, "shelf/book", "a,b,-,d" );
+  Expect( root, "./shelf/book", "a,b,-,d" );
+  Expect( root->FirstChildElement(), "/library/shelf", "1,2" );
+  Expect( root, "/shelf", "" );
+
+  /* 后代和通配符 */
+  Expect( &doc, "//book", "a,b,-,c,d,e" );
+  Expect( root, "shelf//book", "a,b,-,c,d" );
+  Expect( root, "shelf/*", "a,b,-,m,-,d" );
+  Expect( &doc, "//shelf/*/book", "c" );
+
+  /* 嵌套的上下文：内层的section已经在外层的后代里，e只返回一次 */
+  Expect( &doc, "//section//book", "e" );
+  Expect( &doc, "//*//book", "a,b,-,c,d,e" );
+
+  /* 属性谓词 */
+  Expect( &doc, "//book[@id]", "a,b,c,d,e" );
+  Expect( &doc, "//book[@type='novel']", "a,-,c" );
+  Expect( &doc, "//book[@type=\"novel\"]", "a,-,c" );
+  /* 不等于也要求有这个属性 */
+  Expect( &doc, "//book[@type!='novel']", "b" );
+  Expect( &doc, "//book[@type][@id]", "a,b,c" );
+
+  /* 位置谓词：同一个父节点下的第n个，和前面的谓词一起计数 */
+  Expect( root, "shelf/book[1]", "a,d" );
+  Expect( root, "shelf/book[3]", "-" );
+  Expect( root, "shelf/book[@type='novel'][2]", "-" );
+  Expect( root, "shelf[2]/book", "d" );
+  Expect( root, "shelf/book[9]", "" );
+
+  /* First()和Count() */
+  TiXmlQuery query( "//book[@type='novel']" );
+  CHECK( query.Count( &doc ) == 3 );
+  CHECK( query.First( &doc ) && strcmp( query.First( &doc )->Attribute( "id" ), "a" ) == 0 );
+  TiXmlQuery none( "//missing" );
+  CHECK( none.Count( &doc ) == 0 && none.First( &doc ) == 0 );
+
+  /* 同一个编译结果可以反复使用 */
+  Expect( root, "shelf[1]/magazine", "m" );
+  Expect( root, "shelf[1]/magazine", "m" );
+}
+
+int main()
+{
+  /* 语法错误 */
+  {
+    const char* bad[] = { "", "/", "a//", "a[", "a[@]", "a[@id='x]", "a[0]", "a[@id=x]", "a b", "a/[1]" };
+    for ( size_t i = 0; i < sizeof( bad ) / sizeof( bad[0] ); ++i )
+    {
+      TiXmlQuery query;
+      CHECK( !query.Compile( bad[i] ) );
+      CHECK( !query.Valid() );
+      CHECK( query.ErrorOffset() >= 0 && query.ErrorOffset() <= (int)strlen( bad[i] ) );
+    }
+    TiXmlQuery query( "a/b" );
+    CHECK( query.Valid() );
+    CHECK( !query.Compile( "a[" ) && !query.Valid() );
+    CHECK( query.Compile( "a" ) && query.Valid() );
+  }
+
+  /* 不用名字表 */
+  {
+    TiXmlDocument doc;
+    doc.Parse( xml );
+    CHECK( !doc.Error() );
+    Run( doc );
+  }
+
+  /* 用名字表：名字按指针比较，结果相同 */
+  {
+    TiXmlDocument doc;
+    CHECK( doc.UseNameTable( true ) );
+    doc.Parse( xml );
+    CHECK( !doc.Error() );
+    Run( doc );
+
+    /* 解析以后新加的节点名字不在表里，照样能找到 */
+    TiXmlElement book( "book" );
+    book.SetAttribute( "id", "f" );
+    doc.RootElement()->InsertEndChild( book );
+    Expect( &doc, "/library/book", "f" );
+    Expect( &doc, "//book[@id='f']", "f" );
+  }
+
+  return Report();
+}
@@ -0,0 +1,97 @@
+/* TiXmlScanner的随机对拍：每一套CPU支持的SIMD实现都和标量实现比较结果。
+ * 输入从容易出问题的字符中随机生成(各种停止字符、'\0'、>= 127的字节)，起点覆盖所有对齐方式。
+ * 全部通过时返回0。
+ * 编译方法见TiXmlTest.h
+ */
+#include "TiXmlTest.h"
+
+enum
+{
+  ROUNDS  = 20000,
+  MAX_LEN = 200,
+  PADDING = 64    /* SIMD版本可能读到'\0'后面，留出余量 */
+};
+
+/* 固定种子，失败时可以重现 */
+static unsigned long seed = 12345;
+static unsigned Random()
+{
+  seed = seed * 1103515245 + 12345;
+  return (unsigned)( seed >> 16 ) & 0x7FFF;
+}
+
+static void Fill( char* buf, size_t length )
+{
+  static const char pool[] = " \t\n\v\f\r<>&\"'/-.:_=aZ09\x7F\x80\xC3\xA9\xFF\x01\x1F";
+  for ( size_t i = 0; i < length; ++i )
+  {
+    /* 偶尔放一个'\0'，其余大多是普通字母，保证有足够长的连续段 */
+    unsigned r = Random() % 100;
+    if ( r == 0 )
+      buf[i] = 0;
+    else if ( r < 40 )
+      buf[i] = pool[ Random() % ( sizeof( pool ) - 1 ) ];
+    else
+      buf[i] = (char)( 'a' + Random() % 26 );
+  }
+  buf[length] = 0;
+}
+
+/* level和标量实现在同一份输入上的结果 */
+static void Compare( TiXmlScanner::ScanLevel level, const char* input, size_t length )
+{
+  static const char delims[] = { '<', '\"', '\'' };
+
+  TiXmlScanner::SetLevel( TiXmlScanner::TIXML_SCAN_SCALAR );
+  const char* space = TiXmlScanner::SkipSpace( input );
+  const char* name = TiXmlScanner::NameEnd( input );
+  const char* text[ 3 ][ 2 ];
+  for ( int d = 0; d < 3; ++d )
+    for ( int f = 0; f < 2; ++f )
+      text[d][f] = TiXmlScanner::FindText( input, delims[d], f ? TiXmlScanner::TIXML_SCAN_SPACE : 0 );
+  const char* escape = TiXmlScanner::FindEscape( input, input + length );
+  char expected[ MAX_LEN + PADDING ];
+  memcpy( expected, input, length + 1 );
+  size_t expectedLength = TiXmlScanner::NormalizeNewlines( expected, length ) - expected;
+
+  CHECK( TiXmlScanner::SetLevel( level ) );
+  CHECK( TiXmlScanner::SkipSpace( input ) == space );
+  CHECK( TiXmlScanner::NameEnd( input ) == name );
+  for ( int d = 0; d < 3; ++d )
+    for ( int f = 0; f < 2; ++f )
+      CHECK( TiXmlScanner::FindText( input, delims[d], f ? TiXmlScanner::TIXML_SCAN_SPACE : 0 ) == text[d][f] );
+  CHECK( TiXmlScanner::FindEscape( input, input + length ) == escape );
+  char actual[ MAX_LEN + PADDING ];
+  memcpy( actual, input, length + 1 );
+  size_t actualLength = TiXmlScanner::NormalizeNewlines( actual, length ) - actual;
+  CHECK( actualLength == expectedLength && memcmp( actual, expected, actualLength ) == 0 );
+}
+
+int main()
+{
+  const TiXmlScanner::ScanLevel detected = TiXmlScanner::Level();
+  /* 64字节对齐的缓冲区，起点在前64个字节中变化 */
+  static char storage[ MAX_LEN + 2 * PADDING + 64 ];
+  char* base = storage + ( 64 - ( (size_t)storage & 63 ) );
+
+  for ( int level = TiXmlScanner::TIXML_SCAN_SSE2; level <= detected; ++level )
+  {
+    for ( int round = 0; round < ROUNDS; ++round )
+    {
+      memset( storage, 0, sizeof( storage ) );
+      char* input = base + round % 64;
+      size_t length = Random() % MAX_LEN;
+      Fill( input, length );
+      Compare( (TiXmlScanner::ScanLevel)level, input, length );
+      if ( failures )
+      {
+        fprintf( stderr, "level %d, round %d\n", level, round );
+        break;
+      }
+    }
+  }
+  TiXmlScanner::SetLevel( detected );
+
+  printf( "%d SIMD level(s) checked\n", (int)detected );
+  return Report();
+}
@@ -0,0 +1,102 @@
+/* 二进制快照(SaveBinary()/LoadBinary())：保存再加载以后，Print()的输出和原来的文档完全相同；
+ * 快照损坏时LoadBinary()失败，错误码是TIXML_ERROR_BINARY_FORMAT。
+ * 全部通过时返回0。
+ * 编译方法见TiXmlTest.h
+ */
+#include "TiXmlTest.h"
+
+/* Print()的输出读回到str中 */
+static void PrintToString( const TiXmlDocument& doc, TIXML_STRING* str )
+{
+  *str = "";
+  FILE* fp = tmpfile();
+  CHECK( fp != 0 );
+  if ( !fp )
+    return;
+  doc.Print( fp, 0 );
+  rewind( fp );
+  char buf[1024];
+  size_t n;
+  while ( ( n = fread( buf, 1, sizeof( buf ), fp ) ) > 0 )
+    str->append( buf, n );
+  fclose( fp );
+}
+
+/* 改写文件中间的一个字节 */
+static void Corrupt( const char* filename )
+{
+  FILE* fp = fopen( filename, "r+b" );
+  CHECK( fp != 0 );
+  if ( !fp )
+    return;
+  fseek( fp, 0, SEEK_END );
+  long size = ftell( fp );
+  fseek( fp, size / 2, SEEK_SET );
+  int c = fgetc( fp );
+  fseek( fp, size / 2, SEEK_SET );
+  fputc( c ^ 0x5a, fp );
+  fclose( fp );
+}
+
+int main()
+{
+  const char* filename = "test_snapshot.bin";
+  const char* xml =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\n"
+    "<!DOCTYPE config SYSTEM \"config.dtd\">\n"
+    "<!-- 配置 -->\n"
+    "<config version=\"2\" name='a &amp; b'>\n"
+    "  <server host=\"localhost\" port=\"8080\" empty=\"\"/>\n"
+    "  <script><![CDATA[if ( a < b && c ) return;]]></script>\n"
+    "  <text>Tom &lt;&amp;&gt; Jerry</text>\n"
+    "  <list><item>1</item><item>2</item><item/></list>\n"
+    "  <!-- 内层注释 -->\n"
+    "</config>\n";
+
+  TiXmlDocument original;
+  original.Parse( xml );
+  CHECK( !original.Error() );
+  CHECK( original.SaveBinary( filename ) );
+
+  TIXML_STRING expected;
+  PrintToString( original, &expected );
+
+  /* 保存再加载，输出相同 */
+  {
+    TiXmlDocument loaded;
+    CHECK( loaded.LoadBinary( filename ) );
+    CHECK( !loaded.Error() );
+
+    TIXML_STRING actual;
+    PrintToString( loaded, &actual );
+    CHECK( actual.length() == expected.length() && strcmp( actual.c_str(), expected.c_str() ) == 0 );
+
+    /* CDATA和属性顺序原样保留 */
+    const TiXmlElement* script = loaded.RootElement()->FirstChildElement( "script" );
+    CHECK( script && script->FirstChild() && script->FirstChild()->ToText() && script->FirstChild()->ToText()->CDATA() );
+    const TiXmlAttribute* attribute = loaded.RootElement()->FirstChildElement( "server" )->FirstAttribute();
+    CHECK( attribute && strcmp( attribute->Name(), "host" ) == 0 );
+    CHECK( attribute && attribute->Next() && strcmp( attribute->Next()->Name(), "port" ) == 0 );
+
+    /* 加载的文档可以照常修改，再保存一次结果还是一样 */
+    loaded.RootElement()->SetAttribute( "version", "3" );
+    loaded.RootElement()->SetAttribute( "version", "2" );
+    CHECK( loaded.SaveBinary( filename ) );
+    TiXmlDocument again;
+    CHECK( again.LoadBinary( filename ) );
+    PrintToString( again, &actual );
+    CHECK( strcmp( actual.c_str(), expected.c_str() ) == 0 );
+  }
+
+  /* 损坏的快照 */
+  {
+    Corrupt( filename );
+    TiXmlDocument loaded;
+    CHECK( !loaded.LoadBinary( filename ) );
+    CHECK( loaded.ErrorId() == TiXmlBase::TIXML_ERROR_BINARY_FORMAT );
+    CHECK( loaded.FirstChild() == 0 );
+  }
+
+  remove( filename );
+  return Report();
+}